@@ -0,0 +1,58 @@
+#ifndef __LIBSPEEDWIRE_ALIGNEDALLOCATOR_HPP__
+#define __LIBSPEEDWIRE_ALIGNEDALLOCATOR_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace libspeedwire {
+
+    /**
+     *  Class AlignedAllocator implements a standard library allocator returning memory aligned to the given boundary,
+     *  e.g. to a cache line. Before C++17, std::allocator only guarantees the alignment of std::max_align_t, even for
+     *  types declared with a larger alignas() requirement.
+     *
+     *  Each block is over-allocated with operator new; the pointer returned by operator new is stored immediately in
+     *  front of the aligned block, such that deallocate() can release it.
+     */
+    template<class T, size_t Alignment> class AlignedAllocator {
+        static_assert(Alignment >= sizeof(void*) && (Alignment & (Alignment - 1)) == 0, "Alignment must be a power of two of at least pointer size");
+
+    public:
+        typedef T value_type;
+
+        /** Rebind the allocator to another value type with the same alignment. */
+        template<class U> struct rebind { typedef AlignedAllocator<U, Alignment> other; };
+
+        AlignedAllocator(void) {}
+        template<class U> AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+        /**
+         *  Allocate an aligned block of memory.
+         *  @param n the number of elements
+         *  @return pointer to the first element
+         */
+        T* allocate(const size_t n) {
+            void* const block = ::operator new(n * sizeof(T) + Alignment - 1 + sizeof(void*));
+            const uintptr_t aligned = ((uintptr_t)block + sizeof(void*) + Alignment - 1) & ~(uintptr_t)(Alignment - 1);
+            ((void**)aligned)[-1] = block;
+            return (T*)aligned;
+        }
+
+        /**
+         *  Deallocate a block of memory obtained from allocate().
+         *  @param p pointer to the first element
+         *  @param n the number of elements
+         */
+        void deallocate(T* const p, const size_t /*n*/) {
+            ::operator delete(((void**)p)[-1]);
+        }
+    };
+
+    /** All instances are interchangeable, as they do not hold any state. */
+    template<class T, class U, size_t Alignment> bool operator==(const AlignedAllocator<T, Alignment>&, const AlignedAllocator<U, Alignment>&) { return true; }
+    template<class T, class U, size_t Alignment> bool operator!=(const AlignedAllocator<T, Alignment>&, const AlignedAllocator<U, Alignment>&) { return false; }
+
+}   // namespace libspeedwire
+
+#endif
@@ -2,20 +2,31 @@
 #define __LIBSPEEDWIRE_AVERAGINGPROCESSOR_HPP__
 
 #include <cstdint>
+#include <map>
+#include <vector>
+#include <AlignedAllocator.hpp>
 #include <Consumer.hpp>
 #include <ObisData.hpp>
 #include <ObisFilter.hpp>
 #include <SpeedwireData.hpp>
 #include <Measurement.hpp>
 #include <Producer.hpp>
+#include <MeasurementAggregator.hpp>
 
 namespace libspeedwire {
 
     /**
      *  Class AveragingProcessor implements the temporal averaging processing of obis elements received from emeter
      *  packets and inverter reply packets; this is useful to reduce the amount of data fed to the InfluxDB producer.
+     *
+     *  Obis data can be received either element by element as an ObisConsumer, or packet by packet as an
+     *  ObisFrameConsumer. Received frames are passed on to both registered ObisFrameConsumers and ObisConsumers.
+     *
+     *  Optionally, tumbling or sliding time window aggregates, i.e. mean, minimum, maximum, last value and number of
+     *  measurements, are computed incrementally per device and measurement and passed to registered AggregateConsumers
+     *  whenever a window is closed; see enableAggregation(). Aggregation is independent of the averaging time.
      */
-    class AveragingProcessor : public ObisConsumer, SpeedwireConsumer {
+    class AveragingProcessor : public ObisConsumer, public ObisFrameConsumer, SpeedwireConsumer {
 
     protected:
 
@@ -25,26 +36,38 @@ namespace libspeedwire {
             INVERTER    //!< An inverter device.
         };
 
-        //! Struct holding a block of averaging related information for a given speedwire device.
-        typedef struct {
-            uint32_t      serialNumber;             //!< Serial number of the speedwire device.
+        //! Struct holding a block of averaging related information for a given speedwire device; each block is aligned
+        //! to its own cache line, such that states of different devices can be updated concurrently without false sharing.
+        //! The states vector uses an AlignedAllocator, as std::allocator does not honor the alignment before C++17.
+        struct alignas(64) AveragingState {
+            SpeedwireAddress address;               //!< Address of the speedwire device.
             DeviceType    deviceType;               //!< Device type.
             unsigned long averagingTime;            //!< Averaging time for data packets.
             unsigned long remainder;                //!< Remainding time for averaging data packets.
             uint32_t      currentTimestamp;         //!< Timestamp of the most recently received data packet.
             bool          currentTimestampIsValid;  //!< The current emeter timestamp has been initialized.
             bool          averagingTimeReached;     //!< Boolean indicating that the averaging time has been reached with this emeter obis packet.
-        } AveragingState;
+            std::map<uint32_t, MeasurementAggregator> aggregators;  //!< Time window aggregators by measurement key.
+        };
 
         unsigned long averagingTimeObisData;                    //!< Averaging time constant for obis data.
         unsigned long averagingTimeSpeedwireData;               //!< Averaging time constant for speedwire data.
-        std::vector<AveragingState> states;                     //!< Array holding averaging states for alle knowne speedwire devices
+        std::vector<AveragingState, AlignedAllocator<AveragingState, 64> > states;  //!< Array holding averaging states for alle knowne speedwire devices
+        std::vector<int> stateTable;                            //!< Open addressing hash table of indexes into states; -1 for unused slots
+        int lastStateIndex;                                     //!< Index of the most recently found state, or -1
         std::vector<ObisConsumer*> obisConsumerTable;           //!< Table of registered ObisConsumer
+        std::vector<ObisFrameConsumer*> obisFrameConsumerTable; //!< Table of registered ObisFrameConsumer
         std::vector<SpeedwireConsumer*> speedwireConsumerTable; //!< Table of registered SpeedwireConsumer
+        std::vector<AggregateConsumer*> aggregateConsumerTable; //!< Table of registered AggregateConsumer
+        unsigned long aggregationWindowTime;                    //!< Aggregation window length in ms; 0 if aggregation is disabled
+        unsigned long aggregationHopTime;                       //!< Time between aggregation window ends in ms
+        std::vector<MeasurementAggregate> aggregates;           //!< Scratch buffer for the aggregates of closed windows
 
-        int initializeState(const uint32_t serial_number, const DeviceType& device_type);
-        int findStateIndex(const uint32_t serial_number);
-        bool process(const SpeedwireDevice& device, const DeviceType& device_type, Measurement& measurement);
+        int initializeState(const SpeedwireAddress& address, const DeviceType& device_type);
+        int findStateIndex(const SpeedwireAddress& address);
+        void insertStateIndex(const int index);
+        bool process(const SpeedwireDevice& device, const DeviceType& device_type, const uint32_t measurement_time);
+        void aggregate(const SpeedwireDevice& device, const DeviceType& device_type, const uint32_t key, const Measurement& measurement, const double value, const uint32_t time);
 
     public:
 
@@ -52,10 +75,14 @@ namespace libspeedwire {
         ~AveragingProcessor(void);
 
         void addConsumer(ObisConsumer& obis_consumer);
+        void addFrameConsumer(ObisFrameConsumer& obis_frame_consumer);
         void addConsumer(SpeedwireConsumer& speedwire_consumer);
+        void addAggregateConsumer(AggregateConsumer& aggregate_consumer);
+        void enableAggregation(const unsigned long window_time, const unsigned long hop_time = 0);
 
         virtual void consume(const SpeedwireDevice& device, ObisData& element);
         virtual void consume(const SpeedwireDevice& device, SpeedwireData& element);
+        virtual void consume(const SpeedwireDevice& device, const ObisDataFrame& frame);
         virtual void endOfObisData(const SpeedwireDevice& device, const uint32_t time);
         virtual void endOfSpeedwireData(const SpeedwireDevice& device, const uint32_t time);
     };
@@ -2,27 +2,91 @@
 #define __LIBSPEEDWIRE_CALCULATEDVALUEPROCESSOR_HPP__
 
 #include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <Consumer.hpp>
 #include <Producer.hpp>
 #include <ObisData.hpp>
 #include <SpeedwireData.hpp>
+#include <OnlineChangePointDetector.hpp>
+#include <LineSegmentEstimator.hpp>
+#include <OrderedWorkerPool.hpp>
+#include <DerivedValueEngine.hpp>
 
 namespace libspeedwire {
 
+    /**
+     *  Struct holding input and output of the signed power analysis of an emeter packet; it is passed to and from
+     *  the analysis worker threads of the CalculatedValueProcessor. It only carries the measurements received with
+     *  the packet, or with several packets of the same device if the analysis falls behind.
+     */
+    struct SignedPowerAnalysis {
+        //! New measurements of a single obis data series.
+        struct Series {
+            const ObisData*   definition;   //!< Definition of the obis data
+            size_t            capacity;     //!< Capacity of the measurement values of the series
+            std::vector<TimestampDoublePair> values;  //!< New measurements, oldest first
+            double            mean;         //!< Output: mean value of the series
+            Series(const ObisData& def, const size_t cap) : definition(&def), capacity(cap), mean(0.0) {}
+        };
+
+        SpeedwireDevice device;                             //!< Input: originating emeter device
+        uint32_t        time;                               //!< Input: emeter packet timestamp
+        std::vector<Series> inputs;                         //!< Input: new positive and negative power measurements
+        std::vector<Series> outputs;                        //!< Output: new signed power measurements L1, L2, L3 and total
+        std::vector<MeasurementValueInterval> intervals;    //!< Output: finalized piecewise constant intervals of the signed total power
+
+        SignedPowerAnalysis(void) : time(0) {}
+
+        void merge(const SignedPowerAnalysis& newer);
+    };
+
     /**
      *  Class CalculatedValueProcessor implements the calculation values derived from obis elements received from emeter
      *  packets and inverter reply packets.
      *
      *  The class is implemented as an ObisConsumer and SpeedwireConsumer. Values are passed on the obis_consumer and
-     *  speedwire_consumer configured
+     *  speedwire_consumer configured. Obis data can also be received packet by packet as an ObisFrameConsumer.
+     *
+     *  Optionally, the signed power analysis, i.e. signed power differences and their segmentation into piecewise
+     *  constant intervals, is moved off the receiving thread to a pool of worker threads; see enableAnalysisWorkers().
+     *  Results are produced in packet order per device, whenever packets are received or deliverAnalysisResults()
+     *  is called.
      */
-    class CalculatedValueProcessor : public ObisConsumer, SpeedwireConsumer {
+    class CalculatedValueProcessor : public ObisConsumer, public ObisFrameConsumer, SpeedwireConsumer {
 
     protected:
 
         ObisDataMap& obis_data_map;       //!< Reference to the data map, where all received obis values reside
         SpeedwireDataMap& speedwire_data_map;  //!< Reference to the data map, where all received inverter values reside
         Producer& producer;            //!< Reference to producer to receive the consumed and calculated values
+        DerivedValueEngine derived_values;  //!< Derived value definitions, i.e. signed power L1, L2, L3 and total
+
+        //! Change point detector state of a device, used if there are no analysis worker threads.
+        struct DetectorState {
+            OnlineChangePointDetector detector; //!< Change point detector for time-accurate signed total power intervals
+            uint32_t time;                      //!< Time of the most recent measurement fed to the change point detector
+            DetectorState(void) : time(0) {}
+        };
+        std::map<uint64_t, DetectorState> detector_states;  //!< Detector state by device address, i.e. susy id and serial number
+
+        //! Signed power analysis state of a device, owned by the analysis worker threads.
+        struct AnalysisState {
+            ObisDataMap obis_map;               //!< Positive, negative and signed power measurements of the device
+            SpeedwireDataMap speedwire_map;     //!< Empty, required by the derived value engine
+            DerivedValueEngine derived_values;  //!< Signed power definitions operating on obis_map
+            OnlineChangePointDetector detector; //!< Change point detector for the signed total power of the device
+            AnalysisState(void);
+        };
+        std::map<uint64_t, uint32_t> analysis_watermarks;  //!< Time of the newest submitted packet by device address, i.e. susy id and serial number
+        std::map<uint64_t, std::unique_ptr<AnalysisState> > analysis_states;  //!< Analysis state by device address, i.e. susy id and serial number
+        std::mutex analysis_states_mutex;   //!< Protects analysis_states; jobs of the same device are processed one at a time
+        std::unique_ptr<OrderedWorkerPool<SignedPowerAnalysis, SignedPowerAnalysis> > analysis_pool;  //!< Optional analysis worker threads
+
+        static void defineSignedPower(DerivedValueEngine& engine);
+        void analyze(const SignedPowerAnalysis& job, SignedPowerAnalysis& result);
+        void deliver(SignedPowerAnalysis& analysis);
 
     public:
 
@@ -31,9 +95,13 @@ namespace libspeedwire {
 
         virtual void consume(const SpeedwireDevice& device, ObisData& element);
         virtual void consume(const SpeedwireDevice& device, SpeedwireData& element);
+        virtual void consume(const SpeedwireDevice& device, const ObisDataFrame& frame);
 
         virtual void endOfObisData(const SpeedwireDevice& device, const uint32_t time);
         virtual void endOfSpeedwireData(const SpeedwireDevice& device, const uint32_t time);
+
+        bool enableAnalysisWorkers(const size_t number_of_threads, const size_t queue_size = 16, const OverflowPolicy policy = OverflowPolicy::MERGE);
+        size_t deliverAnalysisResults(void);
     };
 
 }   // namespace libspeedwire
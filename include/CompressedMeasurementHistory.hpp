@@ -0,0 +1,129 @@
+#ifndef __LIBSPEEDWIRE_COMPRESSEDMEASUREMENTHISTORY_HPP__
+#define __LIBSPEEDWIRE_COMPRESSEDMEASUREMENTHISTORY_HPP__
+
+#include <cstdint>
+#include <cmath>
+#include <deque>
+#include <vector>
+#include <MeasurementHistory.hpp>
+
+namespace libspeedwire {
+
+    /**
+     *  Class encapsulating a decoded sample of a CompressedMeasurementHistory.
+     */
+    class CompressedMeasurementSample {
+    public:
+        int64_t  raw_value;     //!< Raw measurement value, i.e. the value before applying the divisor
+        uint32_t time;          //!< Measurement time
+        uint32_t divisor;       //!< Divisor of the raw measurement value, as stored in the block holding the sample
+
+        CompressedMeasurementSample(void) : raw_value(0), time(0), divisor(1) {}
+
+        /** Get the measurement value, i.e. the raw value divided by the divisor. */
+        double getValue(void) const { return (double)raw_value / (double)divisor; }
+    };
+
+
+    /**
+     *  Class CompressedMeasurementHistory implements a compressed in-memory store of raw measurement values.
+     *
+     *  Samples are stored in blocks of up to samples_per_block samples. The first sample of each block is stored
+     *  uncompressed in the block header. Each subsequent sample is encoded as:
+     *    - the delta-of-delta of its timestamp, i.e. the change of the time difference to the previous sample;
+     *      regular 1000 ms emeter ticks encode to a single 0x00 byte
+     *    - the delta of its raw integer value with respect to the previous sample
+     *  Both are zigzag-mapped to unsigned integers and written as LEB128 varints. As raw values are integers,
+     *  the encoding is lossless. Time differences use modulo arithmetic, i.e. 32-bit timer wrap arounds are handled.
+     *
+     *  Each block stores the divisor of its raw values in its header; a raw value with a different divisor starts a new
+     *  block, such that all samples can be converted back to measurement values. Measurement values without a raw
+     *  representation are scaled by the divisor of the newest block and rounded, i.e. they are stored with the divisor
+     *  they are decoded with. If the maximum number of blocks is exceeded, the oldest block is dropped.
+     */
+    class CompressedMeasurementHistory : public MeasurementHistoryBackend {
+    protected:
+        struct Block {
+            uint32_t first_time;            //!< Timestamp of the first sample
+            uint64_t first_raw_value;       //!< Raw value of the first sample
+            uint32_t divisor;               //!< Divisor of all raw values in the block
+            uint32_t count;                 //!< Number of samples in the block
+            std::vector<uint8_t> data;      //!< Encoded samples following the first sample
+        };
+
+        size_t            samples_per_block;    //!< Maximum number of samples per block
+        size_t            max_blocks;           //!< Maximum number of blocks
+        uint32_t          divisor;              //!< Divisor of the newest block; a raw value with a different divisor starts a new block
+        std::deque<Block> blocks;               //!< Encoded blocks, oldest first
+        size_t            num_samples;          //!< Total number of samples in all blocks
+
+        // encoder state of the newest block
+        uint32_t previous_time;
+        int64_t  previous_time_delta;
+        uint64_t previous_raw_value;
+
+    public:
+        CompressedMeasurementHistory(const size_t samples_per_block, const size_t max_blocks);
+
+        void addMeasurement(const int64_t raw_value, const uint32_t time);
+        void clear(void);
+
+        /** Add a raw measurement value; see MeasurementHistoryBackend. */
+        virtual void addRawMeasurement(const int64_t raw_value, const unsigned long divisor, const uint32_t time) {
+            this->divisor = (uint32_t)divisor;
+            addMeasurement(raw_value, time);
+        }
+
+        /** Add a measurement value; see MeasurementHistoryBackend. */
+        virtual void addMeasurementValue(const double value, const uint32_t time) {
+            addMeasurement((int64_t)llround(value * (double)divisor), time);
+        }
+
+        /** Get the total number of samples in the history. */
+        size_t getNumberOfSamples(void) const { return num_samples; }
+
+        /** Get the number of blocks in the history. */
+        size_t getNumberOfBlocks(void) const { return blocks.size(); }
+
+        /** Get the divisor of the newest block; 1 if no raw value has been added through addRawMeasurement(). */
+        unsigned long getDivisor(void) const { return divisor; }
+
+        size_t getEncodedSize(void) const;
+
+        /**
+         *  Iterator decoding all samples sequentially from oldest to newest.
+         */
+        class Iterator {
+        protected:
+            const std::deque<Block>* blocks;
+            size_t block_index;
+            size_t sample_index;        //!< index of the current sample in the current block
+            size_t data_offset;         //!< offset of the next encoded sample in the current block
+            int64_t time_delta;
+            CompressedMeasurementSample sample;
+            void load(void);
+        public:
+            Iterator(const std::deque<Block>& blocks, const size_t block_index);
+            const CompressedMeasurementSample& operator*(void) const { return sample; }
+            const CompressedMeasurementSample* operator->(void) const { return &sample; }
+            Iterator& operator++(void);
+            bool operator==(const Iterator& rhs) const { return block_index == rhs.block_index && sample_index == rhs.sample_index; }
+            bool operator!=(const Iterator& rhs) const { return !(*this == rhs); }
+        };
+
+        /** Get an iterator to the oldest sample. */
+        Iterator begin(void) const { return Iterator(blocks, 0); }
+
+        /** Get an iterator past the newest sample. */
+        Iterator end(void) const { return Iterator(blocks, blocks.size()); }
+
+    protected:
+        static void     writeVarint(std::vector<uint8_t>& data, const uint64_t value);
+        static uint64_t readVarint(const std::vector<uint8_t>& data, size_t& offset);
+        static uint64_t zigzagEncode(const int64_t value) { return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63); }
+        static int64_t  zigzagDecode(const uint64_t value) { return (int64_t)(value >> 1) ^ -(int64_t)(value & 1); }
+    };
+
+}   // namespace libspeedwire
+
+#endif
@@ -1,7 +1,10 @@
 #ifndef __LIBSPEEDWIRE_CONSUMER_HPP__
 #define __LIBSPEEDWIRE_CONSUMER_HPP__
 
+#include <cstddef>
 #include <ObisData.hpp>
+#include <MeasurementFrame.hpp>
+#include <MeasurementAggregator.hpp>
 #include <SpeedwireData.hpp>
 #include <SpeedwireDevice.hpp>
 
@@ -31,6 +34,100 @@ namespace libspeedwire {
     };
 
 
+    /**
+     *  Class holding a single entry of an ObisDataFrame. Each entry refers to the ObisData instance held by the
+     *  ObisFilter together with the value and timestamp that have been received with the emeter packet.
+     */
+    class ObisDataFrameElement {
+    public:
+        ObisData* element;      //!< Pointer to the ObisData instance held by the ObisFilter
+        double    value;        //!< Measurement value as received with the emeter packet; 0.0 for string values
+        uint32_t  time;         //!< Timestamp of the emeter packet
+
+        /** Constructor. */
+        ObisDataFrameElement(ObisData* element, const double value, const uint32_t time) : element(element), value(value), time(time) {}
+    };
+
+
+    /**
+     *  Class holding all filtered obis elements received with a single emeter packet.
+     *
+     *  The frame refers to a contiguous span of ObisDataFrameElement instances; it is immutable and only valid
+     *  for the duration of the ObisFrameConsumer::consume() callback. The numeric values of the frame are also
+     *  provided in columnar form as a MeasurementFrame, which can be copied or serialized by consumers that need
+     *  to keep the data beyond the callback. If the packet holds more numeric values than the MeasurementFrame
+     *  capacity, the MeasurementFrame is marked truncated, while the frame elements are still complete.
+     */
+    class ObisDataFrame {
+    public:
+        const ObisDataFrameElement* elements;       //!< Pointer to the first element of the frame
+        size_t                      size;           //!< Number of elements in the frame
+        uint32_t                    time;           //!< Timestamp of the emeter packet
+        const MeasurementFrame&     measurements;   //!< Numeric values of the frame, slot ids are ObisData keys
+
+        /** Constructor. */
+        ObisDataFrame(const ObisDataFrameElement* elements, const size_t size, const uint32_t time, const MeasurementFrame& measurements) :
+            elements(elements), size(size), time(time), measurements(measurements) {}
+
+        /** Get an iterator to the first element of the frame. */
+        const ObisDataFrameElement* begin(void) const { return elements; }
+
+        /** Get an iterator past the last element of the frame. */
+        const ObisDataFrameElement* end(void) const { return elements + size; }
+
+        /** Get the element at the given index. */
+        const ObisDataFrameElement& operator[](const size_t index) const { return elements[index]; }
+    };
+
+
+    /**
+     *  Interface to be implemented by any obis consumer that likes to receive all data of an emeter packet at once.
+     *
+     *  In contrast to ObisConsumer, there is a single callback per emeter packet instead of one callback per obis
+     *  element followed by the endOfObisData() callback.
+     */
+    class ObisFrameConsumer {
+    public:
+        /** Virtual destructor. */
+        virtual ~ObisFrameConsumer(void) {}
+
+        /**
+         * Callback to consume all filtered obis data of an emeter packet.
+         * @param device The originating emeter device.
+         * @param frame A reference to the obis data frame, holding output data of the ObisFilter.
+         */
+        virtual void consume(const SpeedwireDevice& device, const ObisDataFrame& frame) = 0;
+    };
+
+
+    /**
+     *  Adapter class passing obis data frames to an ObisConsumer, element by element followed by endOfObisData().
+     */
+    class ObisFrameConsumerAdapter : public ObisFrameConsumer {
+    protected:
+        ObisConsumer& consumer;     //!< Reference to the adapted ObisConsumer
+
+    public:
+        /**
+         * Constructor.
+         * @param consumer Reference to the ObisConsumer receiving the frame elements.
+         */
+        ObisFrameConsumerAdapter(ObisConsumer& consumer) : consumer(consumer) {}
+
+        /**
+         * Callback to consume all filtered obis data of an emeter packet.
+         * @param device The originating emeter device.
+         * @param frame A reference to the obis data frame, holding output data of the ObisFilter.
+         */
+        virtual void consume(const SpeedwireDevice& device, const ObisDataFrame& frame) {
+            for (const auto& entry : frame) {
+                consumer.consume(device, *entry.element);
+            }
+            consumer.endOfObisData(device, frame.time);
+        }
+    };
+
+
     /**
      *  Interface to be implemented by the consumer of speedwire inverter reply data.
      */
@@ -54,6 +151,24 @@ namespace libspeedwire {
         virtual void endOfSpeedwireData(const SpeedwireDevice&device, const uint32_t timestamp) {}
     };
 
+
+    /**
+     *  Interface to be implemented by any consumer of time window aggregates, e.g. as emitted by the AveragingProcessor.
+     */
+    class AggregateConsumer {
+    public:
+        /** Virtual destructor */
+        virtual ~AggregateConsumer(void) {}
+
+        /**
+         * Consume the aggregate of a measurement in a closed time window.
+         * @param device The originating device.
+         * @param measurement The measurement definition, i.e. measurement type and wire.
+         * @param aggregate The aggregate of all measurements in the time window.
+         */
+        virtual void consume(const SpeedwireDevice& device, const Measurement& measurement, const MeasurementAggregate& aggregate) = 0;
+    };
+
 }   // namespace libspeedwire
 
 #endif
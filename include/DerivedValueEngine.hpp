@@ -0,0 +1,106 @@
+#ifndef __LIBSPEEDWIRE_DERIVEDVALUEENGINE_HPP__
+#define __LIBSPEEDWIRE_DERIVEDVALUEENGINE_HPP__
+
+#include <cstdint>
+#include <vector>
+#include <ObisData.hpp>
+#include <SpeedwireData.hpp>
+
+namespace libspeedwire {
+
+    //! Operation calculating a derived measurement value from two operand values a and b.
+    enum class DerivedOperation : uint8_t {
+        DIFFERENCE  = 0,    //!< a - b, e.g. signed power or power losses
+        SUM         = 1,    //!< a + b
+        RATIO       = 2,    //!< a / b; 0 if b is 0
+        PERCENTAGE  = 3     //!< a / b * 100, e.g. efficiency; 0 if b is 0
+    };
+
+    //! Data map holding a measurement referenced by a derived value definition.
+    enum class DerivedValueSource : uint8_t {
+        OBIS      = 0,      //!< The measurement resides in the ObisDataMap.
+        SPEEDWIRE = 1       //!< The measurement resides in the SpeedwireDataMap.
+    };
+
+
+    /**
+     *  Class referencing a measurement in one of the data maps by its key.
+     */
+    class DerivedValueRef {
+    public:
+        DerivedValueSource source;  //!< Data map holding the measurement
+        uint32_t           key;     //!< Key of the measurement in the data map
+
+        /** Constructor referencing obis data. */
+        DerivedValueRef(const ObisData& element) : source(DerivedValueSource::OBIS), key(element.toKey()) {}
+
+        /** Constructor referencing speedwire data. */
+        DerivedValueRef(const SpeedwireData& element) : source(DerivedValueSource::SPEEDWIRE), key(element.toKey()) {}
+    };
+
+
+    /**
+     *  Class DerivedValueEngine calculates measurements derived from other measurements in the obis and speedwire data maps.
+     *
+     *  Each definition calculates a result measurement from two operand measurements. Definitions are compiled once into a flat
+     *  evaluation plan, where all data map lookups are resolved into pointers to the measurements. Definitions are evaluated in
+     *  the order they were added, such that the result of a definition can be used as operand of a subsequent definition.
+     *
+     *  Evaluation is incremental: each definition keeps a watermark, i.e. the time of the newest measurement of operand a that
+     *  has been processed, and only operand measurements newer than the watermark are visited. Measurements of operand a are
+     *  processed once operand b has caught up with them within the time tolerance; each one is paired with the closest measurement of operand b within
+     *  the time tolerance of the definition. Measurements without a counterpart in operand b are skipped, such that misaligned
+     *  or missing timestamps of one operand do not affect the pairing of subsequent measurements.
+     *
+     *  Definitions referencing measurements missing in the data maps are skipped; they are resolved again by subsequent calls to
+     *  evaluate(). Data map entries must not be erased while they are referenced by a compiled plan.
+     */
+    class DerivedValueEngine {
+    public:
+        //! Compiled definition.
+        struct Step {
+            DerivedOperation operation;     //!< Operation
+            DerivedValueRef  result_ref;    //!< Reference to the result measurement
+            DerivedValueRef  a_ref;         //!< Reference to the first operand measurement
+            DerivedValueRef  b_ref;         //!< Reference to the second operand measurement
+            Measurement*     result;        //!< Resolved result measurement, or NULL if unresolved
+            const MeasurementValues* a;     //!< Resolved first operand measurement values
+            const MeasurementValues* b;     //!< Resolved second operand measurement values
+            uint32_t         time_tolerance;//!< Maximum time difference of paired operand measurements
+            uint32_t         watermark;     //!< Time of the newest processed measurement of operand a
+            bool             has_watermark; //!< True if watermark is valid
+            Step(const DerivedOperation op, const DerivedValueRef& r, const DerivedValueRef& x, const DerivedValueRef& y, const uint32_t tolerance) :
+                operation(op), result_ref(r), a_ref(x), b_ref(y), result(NULL), a(NULL), b(NULL), time_tolerance(tolerance), watermark(0), has_watermark(false) {}
+
+            /** Check if all measurements of this step have been resolved. */
+            bool isResolved(void) const { return result != NULL; }
+        };
+
+    protected:
+        ObisDataMap&       obis_data_map;       //!< Data map holding obis measurements
+        SpeedwireDataMap&  speedwire_data_map;  //!< Data map holding speedwire measurements
+        std::vector<Step>  plan;                //!< Evaluation plan
+        size_t             unresolved;          //!< Number of unresolved plan steps
+
+        Measurement* resolve(const DerivedValueRef& ref) const;
+        size_t evaluate(Step& step) const;
+
+    public:
+        DerivedValueEngine(ObisDataMap& obis_map, SpeedwireDataMap& speedwire_map);
+
+        size_t define(const DerivedValueRef& result, const DerivedOperation operation, const DerivedValueRef& a, const DerivedValueRef& b, const uint32_t time_tolerance = 0);
+        size_t compile(void);
+        size_t evaluate(void);
+
+        /** Get the evaluation plan; steps are in definition order. */
+        const std::vector<Step>& getPlan(void) const { return plan; }
+
+        /** Get the number of unresolved plan steps. */
+        size_t getNumberOfUnresolvedSteps(void) const { return unresolved; }
+
+        static double apply(const DerivedOperation operation, const double a, const double b);
+    };
+
+}   // namespace libspeedwire
+
+#endif
@@ -0,0 +1,158 @@
+#ifndef __LIBSPEEDWIRE_ENERGYPROCESSOR_HPP__
+#define __LIBSPEEDWIRE_ENERGYPROCESSOR_HPP__
+
+#include <cstdint>
+#include <map>
+#include <vector>
+#include <Consumer.hpp>
+#include <Producer.hpp>
+#include <LocalHost.hpp>
+#include <MeasurementResampler.hpp>
+#include <DerivedValueEngine.hpp>
+
+namespace libspeedwire {
+
+    //! Quantity of the measurements tracked by an EnergyTracker.
+    enum class EnergySource : uint8_t {
+        ENERGY_COUNTER = 0,     //!< Cumulative energy counter readings; power is derived from counter deltas.
+        POWER          = 1      //!< Instantaneous power values in W; energy is integrated by the trapezoidal rule.
+    };
+
+
+    /**
+     *  Struct holding energy and average power of a time interval.
+     */
+    struct EnergyInterval {
+        uint64_t start_time;        //!< Interval start in unix epoch milliseconds
+        uint64_t end_time;          //!< Interval end in unix epoch milliseconds
+        double   energy;            //!< Energy in the interval, in the energy unit of the tracker
+        double   average_power;     //!< Average power in the interval in W
+        EnergyInterval(const uint64_t start, const uint64_t end, const double e, const double p) : start_time(start), end_time(end), energy(e), average_power(p) {}
+    };
+
+
+    /**
+     *  Class EnergyTracker incrementally tracks the cumulative energy of a single measurement series.
+     *
+     *  For energy counters, the average power between consecutive counter readings is derived from the counter delta;
+     *  this is more accurate than instantaneous power values, as the counter integrates over the whole time between
+     *  two packets. Counter decrements, e.g. after a counter reset, do not contribute energy. For power values, the
+     *  energy is integrated by the trapezoidal rule with compensated summation.
+     *
+     *  The cumulative energy is split at multiples of the interval length in unix epoch time, e.g. at 15 minute billing
+     *  intervals. The energy at an interval boundary is interpolated between the measurements before and after the
+     *  boundary, linearly for energy counters and by splitting the trapezoid for power values; only the most recent
+     *  measurement is kept, such that raw measurements need not be stored for the interval calculation. The first
+     *  partial interval is not reported.
+     *
+     *  A time between consecutive measurements longer than the maximum gap, e.g. while a device is offline, counts as
+     *  missing data. No energy is accounted for the gap, neither from counter deltas nor by interpolation, the interval
+     *  in progress is not reported, and tracking restarts from the measurement after the gap like from a first one.
+     *
+     *  Each call to update() processes all measurements newer than the most recently processed one. 32-bit timestamps
+     *  are expanded to 64-bit unix epoch milliseconds once, and then advanced by wrap around safe time differences.
+     */
+    class EnergyTracker {
+    protected:
+        EnergySource        source;             //!< Quantity of the tracked measurements
+        MeasurementTimeBase time_base;          //!< Time base of the tracked measurements
+        uint64_t            interval_in_ms;     //!< Interval length in milliseconds
+        uint64_t            max_gap_in_ms;      //!< Maximum time between measurements in milliseconds; 0 if unlimited
+        double              ms_per_unit;        //!< Conversion factor from energy units to W * ms
+        bool                has_last;           //!< True if a measurement has been processed
+        uint32_t            last_time;          //!< Timestamp of the most recently processed measurement
+        uint64_t            last_time64;        //!< Unix epoch time of the most recently processed measurement in ms
+        double              last_value;         //!< Value of the most recently processed measurement
+        KahanSum            energy;             //!< Cumulative energy at the most recently processed measurement
+        double              power;              //!< Average or instantaneous power at the most recently processed measurement in W
+        bool                has_power;          //!< True if power is valid; energy counters need two readings
+        bool                has_interval_start; //!< True if an interval boundary has been passed
+        uint64_t            interval_start;     //!< Start of the current interval in unix epoch milliseconds
+        double              interval_start_energy; //!< Cumulative energy at the start of the current interval
+
+        void restart(const uint64_t time64, const TimestampDoublePair& measurement);
+        void addBoundaries(const uint64_t time64, const double value, const double previous_energy, std::vector<EnergyInterval>& intervals);
+
+    public:
+        EnergyTracker(const EnergySource source, const MeasurementTimeBase time_base, const uint64_t interval_in_ms = 15 * 60 * 1000, const double watt_seconds_per_unit = 3600000.0,
+                      const uint64_t max_gap_in_ms = 5 * 60 * 1000);
+
+        void reset(void);
+        size_t update(const MeasurementValues& values, std::vector<EnergyInterval>& intervals, const uint64_t unix_epoch_time_in_ms = LocalHost::getUnixEpochTimeInMs());
+
+        /** Check if a measurement has been processed since the last reset(). */
+        bool hasMeasurements(void) const { return has_last; }
+
+        /** Get the cumulative energy since the first processed measurement, in the energy unit of the tracker. */
+        double getEnergy(void) const { return energy.sum; }
+
+        /** Check if the power is valid; for energy counters, at least two counter readings are needed. */
+        bool hasPower(void) const { return has_power; }
+
+        /** Get the power in W; for energy counters the average power between the two most recent counter readings. */
+        double getPower(void) const { return power; }
+
+        /** Get the timestamp of the most recently processed measurement. */
+        uint32_t getTime(void) const { return last_time; }
+
+        /** Get the interval length in milliseconds. */
+        uint64_t getIntervalLength(void) const { return interval_in_ms; }
+
+        /** Get the maximum time between measurements in milliseconds; 0 if unlimited. */
+        uint64_t getMaximumGap(void) const { return max_gap_in_ms; }
+
+        static double getWattSecondsPerUnit(const MeasurementType& energy_type);
+    };
+
+
+    /**
+     *  Class EnergyProcessor derives power from energy counters and energy from power measurements, and produces
+     *  energy and average power of fixed-length intervals, e.g. 15 minute billing intervals.
+     *
+     *  The class is implemented as an ObisConsumer, ObisFrameConsumer and SpeedwireConsumer. Each registered
+     *  measurement is tracked per device by an EnergyTracker. The derived value, i.e. the average power for energy
+     *  counters and the cumulative energy for power measurements, is passed to the producer for each packet.
+     *  Completed intervals are passed to the interval producer, with the interval end as timestamp. Intervals with
+     *  gaps in the measurements longer than the maximum gap are not reported.
+     */
+    class EnergyProcessor : public ObisConsumer, public ObisFrameConsumer, public SpeedwireConsumer {
+    protected:
+        //! Registered measurement.
+        struct Definition {
+            DerivedValueRef  input;         //!< Reference to the measurement
+            EnergySource     source;        //!< Quantity of the measurement
+            MeasurementType  power_type;    //!< Measurement type of produced power values
+            MeasurementType  energy_type;   //!< Measurement type of produced energy values
+            Wire             wire;          //!< Wire of produced values
+            Definition(const DerivedValueRef& in, const EnergySource src, const MeasurementType& ptype, const MeasurementType& etype, const Wire w) :
+                input(in), source(src), power_type(ptype), energy_type(etype), wire(w) {}
+        };
+
+        Producer& producer;                             //!< Producer receiving derived values for each packet
+        Producer& interval_producer;                    //!< Producer receiving completed interval values
+        uint64_t  interval_in_ms;                       //!< Interval length in milliseconds
+        uint64_t  max_gap_in_ms;                        //!< Maximum time between measurements in milliseconds; 0 if unlimited
+        std::vector<Definition> definitions;            //!< Registered measurements
+        std::map<uint64_t, EnergyTracker> trackers;     //!< Trackers by device serial number and definition index
+        std::vector<EnergyInterval> intervals;          //!< Scratch buffer for completed intervals
+
+        void process(const SpeedwireDevice& device, const DerivedValueSource source, const uint32_t key, const MeasurementValues& values);
+
+    public:
+        EnergyProcessor(Producer& producer, Producer& interval_producer, const uint64_t interval_in_ms = 15 * 60 * 1000, const uint64_t max_gap_in_ms = 5 * 60 * 1000);
+
+        void addEnergyCounter(const ObisData& counter, const MeasurementType& power_type);
+        void addEnergyCounter(const SpeedwireData& counter, const MeasurementType& power_type);
+        void addPower(const ObisData& power, const MeasurementType& energy_type);
+        void addPower(const SpeedwireData& power, const MeasurementType& energy_type);
+
+        virtual void consume(const SpeedwireDevice& device, ObisData& element);
+        virtual void consume(const SpeedwireDevice& device, const ObisDataFrame& frame);
+        virtual void consume(const SpeedwireDevice& device, SpeedwireData& element);
+        virtual void endOfObisData(const SpeedwireDevice& device, const uint32_t time);
+        virtual void endOfSpeedwireData(const SpeedwireDevice& device, const uint32_t time);
+    };
+
+}   // namespace libspeedwire
+
+#endif
@@ -0,0 +1,149 @@
+#ifndef __LIBSPEEDWIRE_FLEETAGGREGATOR_HPP__
+#define __LIBSPEEDWIRE_FLEETAGGREGATOR_HPP__
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include <Consumer.hpp>
+#include <LocalHost.hpp>
+#include <MeasurementValues.hpp>
+
+namespace libspeedwire {
+
+    /**
+     *  Class FleetAggregator keeps the latest value of a set of measurements for many devices, e.g. all emeters of a
+     *  site, and provides fleet-wide totals per measurement.
+     *
+     *  Latest values are held in a dense column-major matrix with one row per device and one column per registered
+     *  measurement, such that each column is a contiguous array. For each column the sum and the number of values are
+     *  updated incrementally with every value. After as many incremental changes as there are devices, the sum is
+     *  re-calculated from the contiguous column with independent accumulators, such that rounding errors of the
+     *  changes do not accumulate; this is amortized O(1) per value. Minimum and maximum are kept by an indexed binary
+     *  heap of the live rows per column, which is updated in O(log devices) per value; therefore all totals are
+     *  available in O(1) after each packet. Device addresses and obis data keys are mapped to rows and columns by
+     *  open addressing hash tables.
+     *
+     *  A device is stale if it has not been updated for the stale time; the values of stale devices are removed from
+     *  the totals and counted separately, until the device is updated again. Stale devices are detected from a queue
+     *  of update times in amortized O(1). Times are local host times in milliseconds, as device timers are not
+     *  synchronized.
+     *
+     *  The class is implemented as an ObisConsumer and ObisFrameConsumer. It is not thread-safe.
+     */
+    class FleetAggregator : public ObisConsumer, public ObisFrameConsumer {
+    protected:
+        //! Binary heap of the live rows of a column ordered by their values, together with the heap position of each
+        //! row, such that the value of any row can be inserted, changed or removed in O(log n).
+        struct ColumnHeap {
+            static const uint32_t none = 0xffffffff;    //!< Heap position of rows not in the heap
+            std::vector<uint32_t> heap;     //!< Row indexes in heap order; the first row holds the extreme value
+            std::vector<uint32_t> position; //!< Heap position by row index, or none
+            double   sign;                  //!< 1.0 for a minimum heap, -1.0 for a maximum heap
+            ColumnHeap(const double s) : sign(s) {}
+
+            void insert(const double* values, const uint32_t row);
+            void remove(const double* values, const uint32_t row);
+            void update(const double* values, const uint32_t row);
+            size_t siftUp(const double* values, size_t i);
+            size_t siftDown(const double* values, size_t i);
+
+            /** Check if row a is ordered before row b. */
+            bool before(const double* values, const uint32_t a, const uint32_t b) const { return sign * values[a] < sign * values[b]; }
+        };
+
+        //! Open addressing hash table of indexes by key using linear probing; it is kept at most half full.
+        struct IndexTable {
+            static const uint32_t none = 0xffffffff;    //!< Index of unused slots
+            std::vector<uint64_t> keys;     //!< Key by slot
+            std::vector<uint32_t> indexes;  //!< Index by slot, or none
+            uint32_t size;                  //!< Number of used slots
+            IndexTable(void) : size(0) {}
+
+            int find(const uint64_t key) const;
+            void insert(const uint64_t key, const uint32_t index);
+
+            /** Get the preferred slot of the given key; the number of slots is a power of two. */
+            size_t hash(const uint64_t key) const { return (size_t)((key * UINT64_C(0x9E3779B97F4A7C15)) >> 32) & (keys.size() - 1); }
+        };
+
+        //! Totals of a single measurement column.
+        struct Column {
+            uint32_t   key;         //!< Obis data key of the measurement
+            KahanSum   sum;         //!< Sum of all live values
+            uint32_t   changes;     //!< Number of incremental changes of the sum since it has been re-calculated
+            ColumnHeap min_heap;    //!< Live rows ordered by increasing value
+            ColumnHeap max_heap;    //!< Live rows ordered by decreasing value
+            uint32_t   count;       //!< Number of live values
+            uint32_t   stale;       //!< Number of values of stale devices
+            Column(const uint32_t k) : key(k), changes(0), min_heap(1.0), max_heap(-1.0), count(0), stale(0) {}
+        };
+
+        //! Update time of a device row.
+        struct RowUpdate {
+            uint32_t row;           //!< Row index
+            uint64_t time;          //!< Local time of the update in ms
+            RowUpdate(const uint32_t r, const uint64_t t) : row(r), time(t) {}
+        };
+
+        uint64_t stale_time;                    //!< Time in ms after which a device without updates is stale
+        uint32_t number_of_rows;                //!< Number of devices
+        uint32_t row_capacity;                  //!< Allocated number of rows per column
+        std::vector<Column>   columns;          //!< Column totals
+        std::vector<double>   values;           //!< Column-major matrix of latest values
+        std::vector<uint8_t>  present;          //!< Column-major matrix; 1 if the device has reported a value, 0 otherwise
+        std::vector<uint8_t>  row_stale;        //!< 1 if the device row is stale, 0 otherwise
+        std::vector<uint64_t> row_time;         //!< Local time of the most recent update of each row in ms
+        IndexTable rows;                        //!< Row indexes by device address
+        IndexTable keys;                        //!< Column indexes by obis data key
+        std::deque<RowUpdate> updates;          //!< Row updates in time order, used to detect stale devices
+
+        void grow(void);
+        void touch(const uint32_t row, const uint64_t now);
+        void setStale(const uint32_t row, const bool stale);
+        void addToSum(const uint32_t column, const double delta);
+        void resum(const uint32_t column);
+
+        /** Get the matrix index of the given cell. */
+        size_t cell(const uint32_t row, const uint32_t column) const { return (size_t)column * row_capacity + row; }
+
+    public:
+        FleetAggregator(const uint64_t stale_time_in_ms = 5000);
+
+        uint32_t addMeasurement(const ObisData& measurement);
+        uint32_t getDeviceRow(const SpeedwireAddress& device);
+
+        void update(const uint32_t row, const uint32_t column, const double value, const uint64_t now);
+        void expire(const uint64_t now);
+
+        /** Get the number of registered measurements, i.e. columns. */
+        uint32_t getNumberOfMeasurements(void) const { return (uint32_t)columns.size(); }
+
+        /** Get the number of known devices, i.e. rows. */
+        uint32_t getNumberOfDevices(void) const { return number_of_rows; }
+
+        /** Get the column index of the given obis data key, or -1 if the measurement is not registered. */
+        int findMeasurement(const uint32_t key) const { return keys.find(key); }
+
+        /** Get the sum of the latest values of all live devices. */
+        double getSum(const uint32_t column) const { return columns[column].sum.sum; }
+
+        /** Get the number of live devices that have reported a value. */
+        uint32_t getCount(const uint32_t column) const { return columns[column].count; }
+
+        /** Get the number of stale devices that have reported a value. */
+        uint32_t getNumberOfStaleDevices(const uint32_t column) const { return columns[column].stale; }
+
+        /** Get the minimum of the latest values of all live devices, or 0.0 if there is no live value. */
+        double getMinimum(const uint32_t column) const { const ColumnHeap& h = columns[column].min_heap; return (h.heap.empty() ? 0.0 : values[cell(h.heap[0], column)]); }
+
+        /** Get the maximum of the latest values of all live devices, or 0.0 if there is no live value. */
+        double getMaximum(const uint32_t column) const { const ColumnHeap& h = columns[column].max_heap; return (h.heap.empty() ? 0.0 : values[cell(h.heap[0], column)]); }
+
+        virtual void consume(const SpeedwireDevice& device, ObisData& element);
+        virtual void consume(const SpeedwireDevice& device, const ObisDataFrame& frame);
+        virtual void endOfObisData(const SpeedwireDevice& device, const uint32_t time);
+    };
+
+}   // namespace libspeedwire
+
+#endif
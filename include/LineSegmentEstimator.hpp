@@ -1,8 +1,11 @@
 #ifndef __LIBSPEEDWIRE_LINESEGMENTESTIMATOR_HPP__
 #define __LIBSPEEDWIRE_LINESEGMENTESTIMATOR_HPP__
 
+#include <cmath>
 #include <cstdint>
 #include <cstdlib>
+#include <algorithm>
+#include <initializer_list>
 #include <vector>
 #include <MeasurementValues.hpp>
 
@@ -20,8 +23,13 @@ namespace libspeedwire {
         size_t end_index;       // included
         double mean_value;
         double slope;
-        MeasurementValueInterval(const size_t start, const size_t end, const double mean) : start_index(start), end_index(end), mean_value(mean), slope(0.0) {}
-        MeasurementValueInterval(const size_t start, const size_t end, const double mean, const double slop) : start_index(start), end_index(end), mean_value(mean), slope(slop) {}
+        uint32_t start_time;    // time of the measurement at start_index
+        uint32_t end_time;      // time of the measurement at end_index
+        MeasurementValueInterval(void) : start_index(0), end_index(0), mean_value(0.0), slope(0.0), start_time(0), end_time(0) {}
+        MeasurementValueInterval(const size_t start, const size_t end, const double mean) : start_index(start), end_index(end), mean_value(mean), slope(0.0), start_time(0), end_time(0) {}
+        MeasurementValueInterval(const size_t start, const size_t end, const double mean, const double slop) : start_index(start), end_index(end), mean_value(mean), slope(slop), start_time(0), end_time(0) {}
+        MeasurementValueInterval(const size_t start, const size_t end, const double mean, const double slop, const uint32_t start_t, const uint32_t end_t) :
+            start_index(start), end_index(end), mean_value(mean), slope(slop), start_time(start_t), end_time(end_t) {}
     };
 
     struct StatisticalEstimates {
@@ -32,27 +40,60 @@ namespace libspeedwire {
         StatisticalEstimates(const double m, const double var, const double sl, const double sl_var) : mean(m), variance(var), slope(sl), sloped_variance(sl_var) {}
     };
 
+    /**
+     *  Class holding the configuration of a LineSegmentEstimator.
+     */
+    class LineSegmentEstimatorConfig {
+    public:
+        size_t constant_window_size;        //!< Sliding window size for piecewise constant intervals: -window_size .. 0 .. window_size
+        size_t linear_window_size;          //!< Sliding window size for piecewise linear intervals: -window_size .. 0 .. window_size
+        double mean_ratio;                  //!< Minimum ratio of squared mean differences to variance of a mean value change point; 9.0 is 3 sigma
+        double min_variance_threshold;      //!< Mean value change points are ignored if mean_ratio * variance does not exceed this value
+        double linear_ratio;                //!< Minimum ratio of squared extrapolated mean differences to slope variance of a linear regression change point
+
+        LineSegmentEstimatorConfig(void) :
+            constant_window_size(6),
+            linear_window_size(10),
+            mean_ratio(9.0),
+            min_variance_threshold(200.0),
+            linear_ratio(9.0) {}
+    };
+
+
+    /**
+     *  Class LineSegmentEstimator implements the segmentation of measurement values into piecewise constant or piecewise linear intervals.
+     *
+     *  An instance holds its configuration and owns all scratch buffers needed for the segmentation; the buffers are reused
+     *  across calls, such that repeated segmentation of measurement series up to the same size does not allocate memory.
+     *  An instance must not be used by several threads concurrently. The static methods are kept for convenience; they use
+     *  a temporary instance with the default configuration.
+     */
     class LineSegmentEstimator {
     public:
+        LineSegmentEstimatorConfig config;      //!< Configuration; it can be modified between calls
+
+        /**
+         *  Constructor.
+         *  @param configuration the configuration
+         */
+        LineSegmentEstimator(const LineSegmentEstimatorConfig& configuration = LineSegmentEstimatorConfig()) : config(configuration) {}
 
         /**
          *  Find mean value change points by simplified total variation.
          *  @param mvalues input measurement values
-         *  @param changepoints output vector holding indexes of change points; the index points to the last index before the change point
+         *  @param changepoints output vector holding indexes of change points; the index points to the last index before the change point; it is cleared first
          *  @return the number of change points
          */
-        static size_t findChangePointsOfMeanValues(const MeasurementValues& mvalues, std::vector<size_t>& changepoints) {
+        size_t findMeanValueChangePoints(const MeasurementValues& mvalues, std::vector<size_t>& changepoints) {
             const size_t num_values = mvalues.getNumberOfElements();
-            const size_t default_window_size = 6; //mvalues.getMaximumNumberOfElements() / 10;   // must be > 0
-            const size_t window_size = (default_window_size < num_values / 4u ? default_window_size : num_values / 4u);
+            const size_t window_size = (config.constant_window_size < num_values / 4u ? config.constant_window_size : num_values / 4u);
             const bool enable_linear_regression = false;
 
-            std::vector<StatisticalEstimates> estimates;
-            estimates.reserve(mvalues.getMaximumNumberOfElements());
-
             // for each measurement value, estimate statistical parameters in a sliding window around the value;
             // the sliding window size is: -window_size .. 0 .. window_size
-            estimateStatistics(mvalues, window_size, enable_linear_regression, estimates);
+            changepoints.clear();
+            estimates.clear();
+            estimateStatistics(mvalues, window_size, enable_linear_regression, estimates, prefix_sums);
 
             // find mean value change points by simplified total variation. This is done by calculating the sum of variances of
             // two adjacent sliding windows. Adjacent sliding windows have their centers 2 * window_size values apart.
@@ -63,21 +104,19 @@ namespace libspeedwire {
         /**
          *  Find linear regression change points by simplified total variation.
          *  @param mvalues input measurement values
-         *  @param changepoints output vector holding indexes of change points; the index points to the last index before the change point
+         *  @param changepoints output vector holding indexes of change points; the index points to the last index before the change point; it is cleared first
          *  @return the number of change points
          */
-        static size_t findChangePointsOfLinearRegressionValues(const MeasurementValues& mvalues, std::vector<size_t>& changepoints) {
+        size_t findLinearRegressionChangePoints(const MeasurementValues& mvalues, std::vector<size_t>& changepoints) {
             const size_t num_values = mvalues.getNumberOfElements();
-            const size_t default_window_size = 10; //mvalues.getMaximumNumberOfElements() / 10;   // must be > 0
-            const size_t window_size = (default_window_size < num_values / 4u ? default_window_size : num_values / 4u);
+            const size_t window_size = (config.linear_window_size < num_values / 4u ? config.linear_window_size : num_values / 4u);
             const bool enable_linear_regression = true;
 
-            std::vector<StatisticalEstimates> estimates;
-            estimates.reserve(mvalues.getMaximumNumberOfElements());
-
             // for each measurement value, estimate statistical parameters in a sliding window around the value;
             // the sliding window size is: -window_size .. 0 .. window_size
-            estimateStatistics(mvalues, window_size, enable_linear_regression, estimates);
+            changepoints.clear();
+            estimates.clear();
+            estimateStatistics(mvalues, window_size, enable_linear_regression, estimates, prefix_sums);
 
             // find linear regression change points by simplified total variation. This is done by calculating the sum of variances of
             // two adjacent sliding windows. Adjacent sliding windows have their centers 2 * window_size values apart.
@@ -88,12 +127,12 @@ namespace libspeedwire {
         /**
          *  Find mean value intervals by simplified total variation.
          *  @param mvalues input measurement values
-         *  @param intervals output vector holding interval definitions
-         *  @return the number of intervals
+         *  @param intervals output vector; the interval definitions are appended
+         *  @return the number of intervals in the output vector
          */
-        static size_t findPiecewiseConstantIntervals(const MeasurementValues& mvalues, std::vector<MeasurementValueInterval>& intervals) {
-            std::vector<size_t> changes;
-            if (findChangePointsOfMeanValues(mvalues, changes) > 0) {
+        size_t findConstantIntervals(const MeasurementValues& mvalues, std::vector<MeasurementValueInterval>& intervals) {
+            const size_t first = intervals.size();
+            if (findMeanValueChangePoints(mvalues, changes) > 0) {
                 double avg0 = mvalues.estimateMean(0, changes[0]);
                 intervals.push_back(MeasurementValueInterval(0, changes[0], avg0));
 
@@ -108,19 +147,20 @@ namespace libspeedwire {
                 double avg = mvalues.estimateMean();
                 intervals.push_back(MeasurementValueInterval(0, mvalues.getNumberOfElements() - 1, avg));
             }
+            setIntervalTimes(mvalues, intervals, first);
             return intervals.size();
         }
 
         /**
-         *  Find mean value intervals by simplified total variation.
+         *  Find linear regression intervals by simplified total variation.
          *  @param mvalues input measurement values
-         *  @param intervals output vector holding interval definitions
-         *  @return the number of intervals
+         *  @param intervals output vector; the interval definitions are appended
+         *  @return the number of intervals in the output vector
          */
-        static size_t findPiecewiseLinearIntervals(const MeasurementValues& mvalues, std::vector<MeasurementValueInterval>& intervals) {
+        size_t findLinearIntervals(const MeasurementValues& mvalues, std::vector<MeasurementValueInterval>& intervals) {
+            const size_t first = intervals.size();
             double mean, var, slope;
-            std::vector<size_t> changes;
-            if (findChangePointsOfLinearRegressionValues(mvalues, changes) > 0) {
+            if (findLinearRegressionChangePoints(mvalues, changes) > 0) {
                 mvalues.estimateLinearRegression(0, changes[0], mean, var, slope);
                 intervals.push_back(MeasurementValueInterval(0, changes[0], mean, slope));
 
@@ -135,11 +175,136 @@ namespace libspeedwire {
                 mvalues.estimateLinearRegression(0, mvalues.getNumberOfElements() - 1, mean, var, slope);
                 intervals.push_back(MeasurementValueInterval(0, mvalues.getNumberOfElements() - 1, mean, slope));
             }
+            setIntervalTimes(mvalues, intervals, first);
             return intervals.size();
         }
 
+        /**
+         *  Find mean value intervals of several measurement series in one call.
+         *  @param series input measurement series
+         *  @param intervals output vectors, one per input series; each output vector is cleared first, its capacity is kept
+         *  @return the total number of intervals
+         */
+        size_t findConstantIntervals(const std::vector<const MeasurementValues*>& series, std::vector<std::vector<MeasurementValueInterval> >& intervals) {
+            size_t total = 0;
+            intervals.resize(series.size());
+            for (size_t i = 0; i < series.size(); ++i) {
+                intervals[i].clear();
+                total += findConstantIntervals(*series[i], intervals[i]);
+            }
+            return total;
+        }
+
+        /**
+         *  Find linear regression intervals of several measurement series in one call.
+         *  @param series input measurement series
+         *  @param intervals output vectors, one per input series; each output vector is cleared first, its capacity is kept
+         *  @return the total number of intervals
+         */
+        size_t findLinearIntervals(const std::vector<const MeasurementValues*>& series, std::vector<std::vector<MeasurementValueInterval> >& intervals) {
+            size_t total = 0;
+            intervals.resize(series.size());
+            for (size_t i = 0; i < series.size(); ++i) {
+                intervals[i].clear();
+                total += findLinearIntervals(*series[i], intervals[i]);
+            }
+            return total;
+        }
+
+        /**
+         *  Find mean value change points by simplified total variation.
+         *  @param mvalues input measurement values
+         *  @param changepoints output vector holding indexes of change points; the index points to the last index before the change point
+         *  @param default_window_size the sliding window size: -window_size .. 0 .. window_size; it is limited to a quarter of the number of values
+         *  @return the number of change points
+         */
+        static size_t findChangePointsOfMeanValues(const MeasurementValues& mvalues, std::vector<size_t>& changepoints, const size_t default_window_size = 6) {
+            LineSegmentEstimator estimator;
+            estimator.config.constant_window_size = default_window_size;
+            std::vector<size_t> result;
+            estimator.findMeanValueChangePoints(mvalues, result);
+            changepoints.insert(changepoints.end(), result.begin(), result.end());
+            return changepoints.size();
+        }
+
+        /**
+         *  Find linear regression change points by simplified total variation.
+         *  @param mvalues input measurement values
+         *  @param changepoints output vector holding indexes of change points; the index points to the last index before the change point
+         *  @param default_window_size the sliding window size: -window_size .. 0 .. window_size; it is limited to a quarter of the number of values
+         *  @return the number of change points
+         */
+        static size_t findChangePointsOfLinearRegressionValues(const MeasurementValues& mvalues, std::vector<size_t>& changepoints, const size_t default_window_size = 10) {
+            LineSegmentEstimator estimator;
+            estimator.config.linear_window_size = default_window_size;
+            std::vector<size_t> result;
+            estimator.findLinearRegressionChangePoints(mvalues, result);
+            changepoints.insert(changepoints.end(), result.begin(), result.end());
+            return changepoints.size();
+        }
+
+        /**
+         *  Find mean value intervals by simplified total variation.
+         *  @param mvalues input measurement values
+         *  @param intervals output vector holding interval definitions
+         *  @param window_size the sliding window size: -window_size .. 0 .. window_size
+         *  @return the number of intervals
+         */
+        static size_t findPiecewiseConstantIntervals(const MeasurementValues& mvalues, std::vector<MeasurementValueInterval>& intervals, const size_t window_size = 6) {
+            LineSegmentEstimator estimator;
+            estimator.config.constant_window_size = window_size;
+            return estimator.findConstantIntervals(mvalues, intervals);
+        }
+
+        /**
+         *  Find mean value intervals by simplified total variation.
+         *  @param mvalues input measurement values
+         *  @param intervals output vector holding interval definitions
+         *  @param window_size the sliding window size: -window_size .. 0 .. window_size
+         *  @return the number of intervals
+         */
+        static size_t findPiecewiseLinearIntervals(const MeasurementValues& mvalues, std::vector<MeasurementValueInterval>& intervals, const size_t window_size = 10) {
+            LineSegmentEstimator estimator;
+            estimator.config.linear_window_size = window_size;
+            return estimator.findLinearIntervals(mvalues, intervals);
+        }
+
     protected:
 
+        /**
+         *  Class holding prefix sums of y, y^2 and t*y of a measurement series.
+         */
+        struct PrefixSums {
+            std::vector<double> y;
+            std::vector<double> y_sq;
+            std::vector<double> ty;
+        };
+
+        //! Minimum cost entry of the linear regression total variation.
+        struct MinEntry {
+            size_t index;
+            double cost;
+            MinEntry(const size_t i, const double c) : index(i), cost(c) {}
+        };
+
+        std::vector<StatisticalEstimates> estimates;    //!< Scratch buffer for window estimates
+        PrefixSums                        prefix_sums;  //!< Scratch buffer for prefix sums
+        std::vector<size_t>               changes;      //!< Scratch buffer for change points
+        std::vector<MinEntry>             minima;       //!< Scratch buffer for cost minima
+
+        /**
+         *  Set start and end times of the given intervals from the measurement times at their start and end indexes.
+         *  @param mvalues input measurement values
+         *  @param intervals intervals to update
+         *  @param first index of the first interval to update
+         */
+        static void setIntervalTimes(const MeasurementValues& mvalues, std::vector<MeasurementValueInterval>& intervals, const size_t first) {
+            for (size_t i = first; i < intervals.size(); ++i) {
+                intervals[i].start_time = mvalues[intervals[i].start_index].time;
+                intervals[i].end_time   = mvalues[intervals[i].end_index].time;
+            }
+        }
+
         /**
          *  Estimate statistical parameters for each values in the given measurement values.
          *  A sliding window around each value is used to estimate:
@@ -147,13 +312,52 @@ namespace libspeedwire {
          *  - variance to mean value, i.e. the squared diff to of the values inside the sliding window to the mean value
          *  - slope value, i.e. the slope value determined by linear regression (optional)
          *  - slope variance, i.e. the squared diff of the values y component to the line defined by slope and mean as intercept point (optional)
+         *  All window sums are derived from prefix sums of y, y^2 and t*y, such that the whole pass is O(n) regardless of the window size.
          *  @param mvalues input measurement values
          *  @param window_size the sliding window size: -window_size .. 0 .. window_size
          *  @param enable_linear_regression enable estimation of optional linear regression parameters (slope and variance to slope)
          *  @param estimates output statistical parameters
          */
         static void estimateStatistics(const MeasurementValues& mvalues, const size_t window_size, const bool enable_linear_regression, std::vector<StatisticalEstimates>& estimates) {
+            PrefixSums prefix_sums;
+            estimateStatistics(mvalues, window_size, enable_linear_regression, estimates, prefix_sums);
+        }
+
+        /**
+         *  Estimate statistical parameters for each values in the given measurement values, using the given scratch buffer for prefix sums.
+         *  @param mvalues input measurement values
+         *  @param window_size the sliding window size: -window_size .. 0 .. window_size
+         *  @param enable_linear_regression enable estimation of optional linear regression parameters (slope and variance to slope)
+         *  @param estimates output statistical parameters
+         *  @param prefix_sums scratch buffer
+         */
+        static void estimateStatistics(const MeasurementValues& mvalues, const size_t window_size, const bool enable_linear_regression, std::vector<StatisticalEstimates>& estimates, PrefixSums& prefix_sums) {
             const size_t num_values = mvalues.getNumberOfElements();
+            if (num_values == 0) {
+                return;
+            }
+
+            // calculate prefix sums of y, y^2 and t*y in a single pass over the contiguous value spans, such that the
+            // sums over each window are available in O(1); values are shifted by the first value to reduce cancellation
+            // errors, as variances and centered covariances do not depend on the shift
+            std::vector<double>& y_prefix = prefix_sums.y;
+            std::vector<double>& y_sq_prefix = prefix_sums.y_sq;
+            std::vector<double>& ty_prefix = prefix_sums.ty;
+            y_prefix.resize(num_values + 1);
+            y_sq_prefix.resize(num_values + 1);
+            ty_prefix.resize(num_values + 1);
+            const double y0 = mvalues.at(0).value;
+            y_prefix[0] = y_sq_prefix[0] = ty_prefix[0] = 0.0;
+            size_t t = 0;
+            for (const RingBufferSpan<TimestampDoublePair>& span : { mvalues.getFirstSpan(), mvalues.getSecondSpan() }) {
+                for (const TimestampDoublePair& pair : span) {
+                    const double y = pair.value - y0;
+                    y_prefix[t + 1]    = y_prefix[t] + y;
+                    y_sq_prefix[t + 1] = y_sq_prefix[t] + y * y;
+                    ty_prefix[t + 1]   = ty_prefix[t] + (double)t * y;
+                    ++t;
+                }
+            }
 
             // for each measurement value, estimate statistical parameters in a sliding window around the value
             for (size_t i = 0; i < num_values; ++i) {
@@ -161,29 +365,31 @@ namespace libspeedwire {
                 const size_t from = i - truncated_size;
                 const size_t to   = i + truncated_size;
                 const size_t n    = to - from + 1;
+                const double y_sum    = y_prefix[to + 1] - y_prefix[from];
+                const double y_sq_sum = y_sq_prefix[to + 1] - y_sq_prefix[from];
+                const double y_mean_shifted = y_sum / n;
+                const double y_sq_dist_sum  = y_sq_sum - y_mean_shifted * y_sum;     // sum of (y - y_mean)^2
+                const double y_mean = y_mean_shifted + y0;
+                double y_var = (n <= 1 ? FLT_MAX : y_sq_dist_sum / (n - 1));
                 if (enable_linear_regression == false) {
-                    double y_mean, y_var;
-                    mvalues.estimateMeanAndVariance(from, to, y_mean, y_var);
                     if (n > 1) y_var *= (2 * window_size + 1) / (n - 1);    // even more variance correction for small sample sizes
                     estimates.push_back(StatisticalEstimates(y_mean, y_var, 0.0, 0.0));
                 }
                 else {
-                    double y_mean, y_var, slope, slope_var;
-                    mvalues.estimateLinearRegression(from, to, y_mean, y_var, slope);
-
-                    // calculate variance of y-values to the linear regression line defined by slope and intercept
-                    double y_dist_sum = 0.0;
-                    for (size_t w = from; w <= to; ++w) {
-                        const double x = (int)w - (int)i;
-                        const double y = mvalues.at(w).value;
-                        const double y_dist = y - (x * slope + y_mean);
-                        y_dist_sum += y_dist * y_dist;
-                    }
-                    slope_var = FLT_MAX;
+                    // linear regression with x = t - i, i.e. x is centered in the symmetric window and sum(x) = 0;
+                    // sum(x^2) = 2 * (1^2 + 2^2 + ... + truncated_size^2)
+                    const double xy_sum = (ty_prefix[to + 1] - ty_prefix[from]) - (double)i * y_sum;
+                    const double x_sq_sum = (double)((truncated_size * (truncated_size + 1) * (2 * truncated_size + 1)) / 3);
+                    const double slope = (x_sq_sum != 0.0 ? xy_sum / x_sq_sum : 0.0);
+
+                    // variance of y-values to the linear regression line defined by slope and intercept point (0, y_mean):
+                    // sum((y - y_mean - slope * x)^2) = sum((y - y_mean)^2) - slope * sum(x * y), as slope * sum(x^2) = sum(x * y)
+                    const double y_dist_sum = std::max(y_sq_dist_sum - slope * xy_sum, 0.0);
+                    double slope_var = FLT_MAX;
                     if (n > 1) {
                         // reflect larger uncertainty of smaller window sizes by increasing their variance
                         y_var    *= (2 * window_size + 1) / (n - 1);
-                        slope_var = (y_dist_sum / n) * (((size_t)1) << (window_size - truncated_size));
+                        slope_var = std::ldexp(y_dist_sum / n, (int)std::min(window_size - truncated_size, (size_t)1023));   // scale by 2^(window_size - truncated_size)
                         if (i == 1 || i == num_values - 2) slope_var = FLT_MAX / 1e18;
                     }
                     estimates.push_back(StatisticalEstimates(y_mean, y_var, slope, slope_var));
@@ -207,7 +413,7 @@ namespace libspeedwire {
          *  @param steps
          *  @return number of steps
          */
-        static size_t totalVariationOfMeanValues(const MeasurementValues& mvalues, const size_t window_size, const std::vector<StatisticalEstimates>& estimates, std::vector<size_t>& steps) {
+        size_t totalVariationOfMeanValues(const MeasurementValues& mvalues, const size_t window_size, const std::vector<StatisticalEstimates>& estimates, std::vector<size_t>& steps) const {
             const size_t num_values = mvalues.getNumberOfElements();
 
             // find mean value change points by simplified total variation. This is done by calculating the sum of variances of
@@ -233,10 +439,10 @@ namespace libspeedwire {
                     // to avoid square root calculations squared mean differences and 9 * variance are used instead
                     const double mean_diff = estimates[center_1].mean - estimates[center_2].mean;
                     const double mean_diff_squared = mean_diff * mean_diff;
-                    const double three_sigma_squared = 9.0 * 0.5 * (estimates[center_1].variance + estimates[center_2].variance);
+                    const double three_sigma_squared = config.mean_ratio * 0.5 * (estimates[center_1].variance + estimates[center_2].variance);
                     if (mean_diff_squared > three_sigma_squared) {
                         // ignore if the variance is small compared to the absolute value
-                        if (three_sigma_squared > 200.0) {
+                        if (three_sigma_squared > config.min_variance_threshold) {
 #if DEBUG_LOGGING
                             printf("3 sigma total variation minimum found at %d  (mean_1 %lf  mean_2 %lf  mean_diff^2: %lf  9*variance: %lf)\n", (int)min_index, estimates[center_1].mean, estimates[center_2].mean, mean_diff_squared, three_sigma_squared);
 #endif
@@ -263,19 +469,13 @@ namespace libspeedwire {
          *  @param change_points
          *  @return number of steps
          */
-        static size_t totalVariationOfLinearRegressionValues(const MeasurementValues& mvalues, const size_t window_size, const std::vector<StatisticalEstimates>& estimates, std::vector<size_t>& change_points) {
+        size_t totalVariationOfLinearRegressionValues(const MeasurementValues& mvalues, const size_t window_size, const std::vector<StatisticalEstimates>& estimates, std::vector<size_t>& change_points) {
             const size_t num_estimates = estimates.size();
             const size_t min_window = 2 * window_size;
 
             // find local minima of cost. This is done by calculating the sum of variances of two adjacent sliding windows.
             // Adjacent sliding windows have their centers 2 * window_size values apart.
-            struct MinEntry {
-                size_t index;
-                double cost;
-                MinEntry(const size_t i, const double c) : index(i), cost(c) {}
-            };
-            std::vector<MinEntry> minima;
-            minima.reserve(num_estimates / 2u);
+            minima.clear();
             for (size_t center_1 = 0, center_m = window_size, center_2 = 2 * window_size + 1; center_2 < num_estimates; ++center_1, ++center_m, ++center_2) {
                 const double cost = estimates[center_1].sloped_variance + estimates[center_2].sloped_variance;
                 const size_t minima_size = minima.size();
@@ -316,7 +516,7 @@ namespace libspeedwire {
 #if DEBUG_LOGGING
                 printf("minimum total variation found at %d  slope_1 %lf  slope_2 %lf  mean_diff^2 %lf  ratio %lf\n", (int)center_m, estimates[center_1].slope, estimates[center_2].slope, mean_diff_squared, ratio);
 #endif
-                if (ratio > 9.0) {  // ignore if the variance is small compared to the absolute value
+                if (ratio > config.linear_ratio) {  // ignore if the variance is small compared to the absolute value
 #if DEBUG_LOGGING
                     printf("3 sigma total variation minimum found at %d  (slope_1 %lf  slope_2 %lf  mean_diff^2 %lf  ratio %lf)\n", (int)center_m, estimates[center_1].slope, estimates[center_2].slope, mean_diff_squared, ratio);
 #endif
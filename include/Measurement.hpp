@@ -30,18 +30,18 @@ namespace libspeedwire {
         }
 
         /**
-         *  Add a new measurement value.
+         *  Add a new measurement value; a history backend attached to the measurement values receives the raw value.
          *  @param value the measurement value
          *  @param time the measurement time
          */
         void addMeasurement(const int32_t  raw_value, const uint32_t time) {
-            measurementValues.addMeasurement((double)raw_value / (double)measurementType.divisor, time);
+            measurementValues.addRawMeasurement((int64_t)raw_value, measurementType.divisor, time);
         }
         void addMeasurement(const uint32_t raw_value, const uint32_t time) {
-            measurementValues.addMeasurement((double)raw_value / (double)measurementType.divisor, time);
+            measurementValues.addRawMeasurement((int64_t)raw_value, measurementType.divisor, time);
         }
         void addMeasurement(const uint64_t raw_value, const uint32_t time) {
-            measurementValues.addMeasurement((double)raw_value / (double)measurementType.divisor, time);
+            measurementValues.addRawMeasurement(raw_value, measurementType.divisor, time);
         }
     };
 
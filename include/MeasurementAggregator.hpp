@@ -0,0 +1,88 @@
+#ifndef __LIBSPEEDWIRE_MEASUREMENTAGGREGATOR_HPP__
+#define __LIBSPEEDWIRE_MEASUREMENTAGGREGATOR_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace libspeedwire {
+
+    /**
+     *  Struct holding the aggregate of all measurements in a time window; it is a compact record, such that consumers
+     *  do not need to keep any measurement ring buffers.
+     */
+    struct MeasurementAggregate {
+        uint32_t start_time;    //!< Window start; it is included
+        uint32_t end_time;      //!< Window end; it is excluded
+        uint32_t count;         //!< Number of measurements in the window
+        double   mean;          //!< Mean value
+        double   min;           //!< Minimum value
+        double   max;           //!< Maximum value
+        double   last;          //!< Value of the most recent measurement
+        uint32_t last_time;     //!< Time of the most recent measurement
+
+        MeasurementAggregate(void) : start_time(0), end_time(0), count(0), mean(0.0), min(0.0), max(0.0), last(0.0), last_time(0) {}
+    };
+
+
+    /**
+     *  Class MeasurementAggregator computes tumbling or sliding window aggregates of a measurement series incrementally.
+     *
+     *  Windows have a fixed length and are closed every hop length; if the hop length equals the window length, windows
+     *  are tumbling, otherwise they are sliding and overlapping. Window boundaries are multiples of the hop length after
+     *  the time of the first measurement. A window is closed and its aggregate is emitted, when the first measurement at
+     *  or after its end is added. A single measurement can close several sliding windows, e.g. after a gap in the
+     *  measurements; all of them are emitted, while windows without measurements are not reported.
+     *
+     *  Tumbling windows keep running sums only. Sliding windows keep the measurements of the current window, together
+     *  with monotonic queues for minimum and maximum, such that each measurement is processed in amortized O(1). The
+     *  sliding sum is re-calculated from the kept measurements after as many additions as measurements are kept, such
+     *  that rounding errors of evictions do not accumulate. Timestamps are compared with wrap around safe time
+     *  differences.
+     */
+    class MeasurementAggregator {
+    protected:
+        //! Measurement kept for sliding windows.
+        struct Sample {
+            double   value;
+            uint32_t time;
+            Sample(const double v, const uint32_t t) : value(v), time(t) {}
+        };
+
+        uint32_t window_length;         //!< Window length in timestamp units
+        uint32_t hop_length;            //!< Time between window ends in timestamp units
+        bool     has_window;            //!< True if the first measurement has been added
+        uint32_t window_end;            //!< End of the current window
+        uint32_t count;                 //!< Number of measurements in the current window; tumbling windows only
+        double   sum;                   //!< Sum of the values in the current window
+        double   min;                   //!< Minimum value in the current window; tumbling windows only
+        double   max;                   //!< Maximum value in the current window; tumbling windows only
+        double   last;                  //!< Value of the most recent measurement
+        uint32_t last_time;             //!< Time of the most recent measurement
+        std::deque<Sample> samples;     //!< Measurements of the current window; sliding windows only
+        std::deque<Sample> minima;      //!< Monotonic queue of minimum candidates; sliding windows only
+        std::deque<Sample> maxima;      //!< Monotonic queue of maximum candidates; sliding windows only
+        size_t   additions_since_rebase;    //!< Number of measurements added since the last re-calculation of the sliding sum
+
+        bool isSliding(void) const { return hop_length < window_length; }
+        void evict(const uint32_t start_time);
+        void rebase(void);
+        void emit(MeasurementAggregate& aggregate) const;
+
+    public:
+        MeasurementAggregator(const uint32_t window_length, const uint32_t hop_length = 0);
+
+        void reset(void);
+        size_t add(const double value, const uint32_t time, std::vector<MeasurementAggregate>& aggregates);
+
+        /** Get the window length in timestamp units. */
+        uint32_t getWindowLength(void) const { return window_length; }
+
+        /** Get the hop length in timestamp units. */
+        uint32_t getHopLength(void) const { return hop_length; }
+    };
+
+}   // namespace libspeedwire
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef __LIBSPEEDWIRE_MEASUREMENTFRAME_HPP__
+#define __LIBSPEEDWIRE_MEASUREMENTFRAME_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <SpeedwireDevice.hpp>
+
+namespace libspeedwire {
+
+    //! Type of the measurement slot ids stored in a MeasurementFrame.
+    enum class MeasurementFrameType : uint8_t {
+        OBIS      = 0,      //!< Slot ids are ObisData keys, i.e. ObisType::toKey(); the timestamp is in milliseconds.
+        SPEEDWIRE = 1       //!< Slot ids are SpeedwireData keys, i.e. SpeedwireRawData::toKey(); the timestamp is in seconds.
+    };
+
+
+    /**
+     *  Class MeasurementFrame holds all measurement values received with a single emeter or inverter packet.
+     *
+     *  The frame consists of the device address, the packet timestamp and two fixed-capacity parallel arrays holding
+     *  measurement slot ids and measurement values. The frame does not allocate any memory, it can be passed by
+     *  reference from stage to stage and it can be serialized into a compact byte stream. If a packet holds more
+     *  measurements than the frame capacity, add() fails and the producer of the frame marks it truncated.
+     *
+     *  Serialized format (little endian):
+     *
+     *      +---------------------------------------------------------------------------------+
+     *      +      2 Bytes   | Susy ID                | Source devices susy id                +
+     *      +      4 Bytes   | Serial Number          | Source devices serial number          +
+     *      +      1 Byte    | Type                   | see enum MeasurementFrameType         +
+     *      +      1 Byte    | Flags                  | 0x01 if the frame is truncated        +
+     *      +      4 Bytes   | Timestamp              | Packet timestamp                      +
+     *      +      4 Bytes   | Size                   | Number of measurements n              +
+     *      +  n * 4 Bytes   | Slot IDs               | Measurement slot ids                  +
+     *      +  n * 8 Bytes   | Values                 | IEEE 754 double measurement values    +
+     *      +---------------------------------------------------------------------------------+
+     */
+    class MeasurementFrame {
+    public:
+        static constexpr size_t capacity = 128;             //!< Maximum number of measurements in a frame.
+        static constexpr size_t serialized_header_size = 16; //!< Size of the serialized frame header in bytes.
+
+        SpeedwireAddress     device;                        //!< Address of the originating device.
+        uint32_t             time;                          //!< Timestamp of the packet.
+        MeasurementFrameType type;                          //!< Type of the measurement slot ids.
+        uint32_t             size;                          //!< Number of measurements in the frame.
+        bool                 truncated;                     //!< True if measurements have been dropped, as the frame was full.
+        uint32_t             slots[capacity];               //!< Measurement slot ids.
+        double               values[capacity];              //!< Measurement values.
+
+        MeasurementFrame(void);
+
+        void initialize(const SpeedwireAddress& device, const uint32_t time, const MeasurementFrameType type);
+        void clear(void);
+        bool add(const uint32_t slot, const double value);
+        int  find(const uint32_t slot) const;
+
+        /** Check if the frame does not hold any measurement. */
+        bool isEmpty(void) const { return size == 0; }
+
+        /** Check if the maximum number of measurements has been reached. */
+        bool isFull(void) const { return size >= capacity; }
+
+        size_t getSerializedSize(void) const;
+        size_t serialize(void* const buffer, const size_t buffer_size) const;
+        bool   deserialize(const void* const buffer, const size_t buffer_size);
+    };
+
+}   // namespace libspeedwire
+
+#endif
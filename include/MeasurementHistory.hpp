@@ -0,0 +1,160 @@
+#ifndef __LIBSPEEDWIRE_MEASUREMENTHISTORY_HPP__
+#define __LIBSPEEDWIRE_MEASUREMENTHISTORY_HPP__
+
+#include <cstdint>
+#include <vector>
+#include <RingBuffer.hpp>
+#include <SpeedwireTime.hpp>
+
+namespace libspeedwire {
+
+    /**
+     *  Class encapsulating summary statistics of all measurements within a time bucket.
+     */
+    class MeasurementBucket {
+    public:
+        uint32_t start_time;    //!< Start time of the bucket, i.e. the bucket time aligned to the bucket duration
+        uint32_t last_time;     //!< Time of the latest measurement in the bucket
+        uint32_t count;         //!< Number of measurements in the bucket
+        double   min;           //!< Minimum measurement value
+        double   max;           //!< Maximum measurement value
+        double   sum;           //!< Sum of all measurement values
+        double   last;          //!< Latest measurement value
+
+        MeasurementBucket(void) : start_time(0), last_time(0), count(0), min(0.0), max(0.0), sum(0.0), last(0.0) {}
+
+        /** Start a new bucket with the given measurement. */
+        MeasurementBucket(const uint32_t start, const double value, const uint32_t time) :
+            start_time(start), last_time(time), count(1), min(value), max(value), sum(value), last(value) {}
+
+        /** Add the given measurement to this bucket. */
+        void add(const double value, const uint32_t time) {
+            if (value < min) min = value;
+            if (value > max) max = value;
+            sum += value;
+            last = value;
+            last_time = time;
+            ++count;
+        }
+
+        /** Get the mean value of all measurements in the bucket. */
+        double mean(void) const { return (count > 0 ? sum / count : 0.0); }
+    };
+
+
+    /**
+     *  Interface of history backends attached to a MeasurementValues instance, see MeasurementValues::setHistory().
+     *  Measurements received from a device are passed as raw measurement values, i.e. the values before applying the
+     *  measurement type divisor; measurements without a raw representation, e.g. calculated values, are passed as
+     *  measurement values.
+     */
+    class MeasurementHistoryBackend {
+    public:
+        virtual ~MeasurementHistoryBackend(void) {}
+
+        /**
+         *  Add a measurement value to the history.
+         *  @param value the measurement value in its unit
+         *  @param time the measurement time
+         */
+        virtual void addMeasurementValue(const double value, const uint32_t time) = 0;
+
+        /**
+         *  Add a raw measurement value to the history; by default it is divided by the divisor and added as measurement value.
+         *  @param raw_value the raw measurement value; unsigned 64-bit values are passed in their 2's complement representation
+         *  @param divisor the measurement type divisor to obtain the measurement value in its unit
+         *  @param time the measurement time
+         */
+        virtual void addRawMeasurement(const int64_t raw_value, const unsigned long divisor, const uint32_t time) {
+            addMeasurementValue((double)raw_value / (double)divisor, time);
+        }
+
+        /**
+         *  Get summary statistics of the measurements in the given time interval at the given resolution.
+         *  Backends that cannot provide summary statistics return 0 buckets.
+         *  @param from the start of the time interval
+         *  @param to the end of the time interval; it is included
+         *  @param resolution the requested resolution in timestamp units
+         *  @param result the buckets in increasing time order
+         *  @return the number of buckets
+         */
+        virtual size_t query(const uint32_t /*from*/, const uint32_t /*to*/, const uint32_t /*resolution*/, std::vector<MeasurementBucket>& result) const {
+            result.clear();
+            return 0;
+        }
+    };
+
+
+    /**
+     *  Class encapsulating a single resolution tier of a MeasurementHistory.
+     *  It holds a ring buffer of completed buckets and the currently open bucket.
+     */
+    class MeasurementHistoryTier {
+    public:
+        uint32_t                      duration;     //!< Bucket duration in timestamp units, i.e. ms for emeter and s for inverter data
+        RingBuffer<MeasurementBucket> buckets;      //!< Completed buckets
+        MeasurementBucket             current;      //!< Currently open bucket; it is empty if current.count == 0
+
+        MeasurementHistoryTier(const uint32_t bucket_duration, const size_t capacity) : duration(bucket_duration), buckets(capacity) {}
+
+        void addMeasurement(const double value, const uint32_t time, const uint64_t time64);
+        void clear(void);
+
+        /** Check if the tier holds any measurements. */
+        bool isEmpty(void) const { return (current.count == 0 && buckets.getNumberOfElements() == 0); }
+
+        /** Get the start time of the oldest bucket; the tier must not be empty. */
+        uint32_t getOldestStartTime(void) const { return (buckets.getNumberOfElements() > 0 ? buckets.getOldestElement().start_time : current.start_time); }
+    };
+
+
+    /**
+     *  Class MeasurementHistory implements a multi-resolution history of measurement values.
+     *
+     *  The history consists of rollup tiers with increasing bucket durations, e.g. 1 minute and 15 minutes. Each
+     *  measurement is added to the open bucket of each tier in O(1); whenever a measurement falls into a new bucket,
+     *  the open bucket is completed and moved into the tier's ring buffer. The raw measurements are kept by the
+     *  MeasurementValues instance the history is attached to.
+     *
+     *  Bucket boundaries are aligned to multiples of the bucket duration in unix epoch time, e.g. 15 minute buckets
+     *  start at full quarter hours. Like in EnergyTracker, the first 32-bit timestamp is expanded to 64-bit unix epoch
+     *  time once, and then advanced by wrap around safe time differences; bucket start times are stored as 32-bit
+     *  timestamps of the measurement time base.
+     *  The history is attached to a MeasurementValues instance as a MeasurementHistoryBackend.
+     */
+    class MeasurementHistory : public MeasurementHistoryBackend {
+    protected:
+        std::vector<MeasurementHistoryTier> tiers;  //!< Rollup tiers, sorted by increasing bucket duration
+        MeasurementTimeBase time_base;              //!< Time base of the measurement timestamps
+        bool     has_time;                          //!< True if a measurement has been added since the last clear()
+        uint32_t last_time;                         //!< Timestamp of the most recently added measurement
+        uint64_t last_time64;                       //!< Unix epoch time of the most recently added measurement in timestamp units
+
+    public:
+        MeasurementHistory(const MeasurementTimeBase time_base = MeasurementTimeBase::EMETER_MS) :
+            time_base(time_base), has_time(false), last_time(0), last_time64(0) {}
+
+        void addTier(const uint32_t bucket_duration, const size_t capacity);
+        void addMeasurement(const double value, const uint32_t time);
+        void addMeasurement(const double value, const uint32_t time, const uint64_t unix_epoch_time_in_ms);
+        void clear(void);
+
+        /** Add a measurement value to all rollup tiers; see MeasurementHistoryBackend. */
+        virtual void addMeasurementValue(const double value, const uint32_t time) {
+            addMeasurement(value, time);
+        }
+
+        /** Get the number of rollup tiers. */
+        size_t getNumberOfTiers(void) const { return tiers.size(); }
+
+        /** Get the rollup tier at the given index; tiers are sorted by increasing bucket duration. */
+        const MeasurementHistoryTier& getTier(const size_t index) const { return tiers[index]; }
+
+        const MeasurementHistoryTier* findTier(const uint32_t resolution) const;
+        const MeasurementHistoryTier* findTier(const uint32_t resolution, const uint32_t from) const;
+        virtual size_t query(const uint32_t from, const uint32_t to, const uint32_t resolution, std::vector<MeasurementBucket>& result) const;
+    };
+
+}   // namespace libspeedwire
+
+#endif
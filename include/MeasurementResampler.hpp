@@ -0,0 +1,80 @@
+#ifndef __LIBSPEEDWIRE_MEASUREMENTRESAMPLER_HPP__
+#define __LIBSPEEDWIRE_MEASUREMENTRESAMPLER_HPP__
+
+#include <cstdint>
+#include <vector>
+#include <LocalHost.hpp>
+#include <MeasurementValues.hpp>
+
+namespace libspeedwire {
+
+    //! Interpolation method used to calculate values at grid times.
+    enum class ResamplingMode : uint8_t {
+        LINEAR          = 0,    //!< Linear interpolation between the measurements before and after the grid time.
+        ZERO_ORDER_HOLD = 1     //!< The value of the latest measurement not after the grid time.
+    };
+
+
+    /**
+     *  Class MeasurementResampler aligns several measurement series onto a common time grid.
+     *
+     *  Each series is registered together with the time base of its timestamps, such that emeter series in
+     *  milliseconds and inverter series in seconds can be combined. All timestamps are expanded to 64-bit unix
+     *  epoch times in milliseconds, which removes any 32-bit timer wrap around. The grid consists of all multiples
+     *  of the given period inside the time interval covered by all series. The result is a dense row-major matrix
+     *  with one row per grid time and one column per series.
+     *
+     *  The series are referenced, not copied; they must stay alive while the resampler is used. Internal buffers
+     *  and the result matrix are reused between calls to resample().
+     */
+    class MeasurementResampler {
+    protected:
+        struct Series {
+            const MeasurementValues* values;    //!< Pointer to the measurement series
+            MeasurementTimeBase time_base;      //!< Time base of the measurement series
+            Series(const MeasurementValues& v, const MeasurementTimeBase tb) : values(&v), time_base(tb) {}
+        };
+
+        ResamplingMode        mode;             //!< Interpolation method
+        std::vector<Series>   series;           //!< Registered measurement series
+        std::vector<uint64_t> expanded_times;   //!< Scratch buffer holding the expanded timestamps of all series
+        std::vector<size_t>   expanded_offsets; //!< Offset of each series in expanded_times
+        std::vector<uint64_t> grid_times;       //!< Grid times in unix epoch milliseconds
+        std::vector<double>   matrix;           //!< Result matrix, row-major
+
+    public:
+        MeasurementResampler(const ResamplingMode mode = ResamplingMode::LINEAR);
+
+        size_t addSeries(const MeasurementValues& values, const MeasurementTimeBase time_base);
+        void   clearSeries(void);
+
+        size_t resample(const uint64_t period_in_ms, const uint64_t unix_epoch_time_in_ms = LocalHost::getUnixEpochTimeInMs());
+
+        /** Get the interpolation method. */
+        ResamplingMode getMode(void) const { return mode; }
+
+        /** Set the interpolation method. */
+        void setMode(const ResamplingMode m) { mode = m; }
+
+        /** Get the number of registered series, i.e. the number of matrix columns. */
+        size_t getNumberOfSeries(void) const { return series.size(); }
+
+        /** Get the number of grid times of the last call to resample(), i.e. the number of matrix rows. */
+        size_t getNumberOfTimes(void) const { return grid_times.size(); }
+
+        /** Get the grid times of the last call to resample() in unix epoch milliseconds. */
+        const std::vector<uint64_t>& getTimes(void) const { return grid_times; }
+
+        /** Get the row-major result matrix of the last call to resample(). */
+        const std::vector<double>& getMatrix(void) const { return matrix; }
+
+        /** Get the resampled value of the given series at the given grid time index. */
+        double getValue(const size_t time_index, const size_t series_index) const { return matrix[time_index * series.size() + series_index]; }
+
+    protected:
+        void expandTimes(const Series& s, const uint64_t unix_epoch_time_in_ms, uint64_t* const times) const;
+    };
+
+}   // namespace libspeedwire
+
+#endif
@@ -6,6 +6,8 @@
 #include <vector>
 #include <float.h>
 #include <RingBuffer.hpp>
+#include <MeasurementHistory.hpp>
+#include <PersistentRingBuffer.hpp>
 #include <SpeedwireTime.hpp>
 
 namespace libspeedwire {
@@ -24,19 +26,218 @@ namespace libspeedwire {
         static TimestampDoublePair defaultPair;
     };
 
+    /**
+     *  Class implementing Kahan compensated summation of double values.
+     */
+    class KahanSum {
+    public:
+        double sum;             //!< Running sum
+        double compensation;    //!< Running compensation for lost low-order bits
+
+        KahanSum(void) : sum(0.0), compensation(0.0) {}
+
+        /** Reset the sum to 0. */
+        void clear(void) { sum = compensation = 0.0; }
+
+        /** Add the given value to the sum. */
+        void add(const double value) {
+            const double y = value - compensation;
+            const double t = sum + y;
+            compensation = (t - sum) - y;
+            sum = t;
+        }
+    };
+
+
     /**
      *  Class encapsulating a ring buffer of measurement values together with their timesamps.
      *  It is assumed that measurement values are added to the ring buffer with monotically increasing timestamps.
+     *
+     *  The measurements are stored once, in a RingBuffer<TimestampDoublePair>, whose read-only interface is provided
+     *  unchanged, i.e. accessors return references and report index out of bounds conditions by returning a
+     *  reference to getIndexOutOfBoundsElement(). The statistics methods run over the at most two contiguous spans
+     *  of the ring buffer and read the values with a stride of sizeof(TimestampDoublePair). The ring buffer can only
+     *  be modified by the methods of this class, which keep it and the running statistics consistent.
+     *
+     *  Optionally, running statistics can be enabled. Then the sum and the sum of squares of all values and the
+     *  time-weighted area below the measurement curve are updated whenever measurements are added or evicted,
+     *  such that mean and variance over the whole ring buffer are available in O(1). The sums are Kahan
+     *  compensated and are re-calculated from scratch after each getMaximumNumberOfElements() additions.
      */
-    class MeasurementValues : public RingBuffer<TimestampDoublePair> {
+    class MeasurementValues : protected RingBuffer<TimestampDoublePair> {
     public:
         std::string value_string;                   //!< String value, e.g. to hold the firmware version or similar
 
+    protected:
+        bool     running_statistics;                //!< True if running statistics are maintained
+        KahanSum value_sum;                         //!< Running sum of all values
+        KahanSum value_sq_sum;                      //!< Running sum of all squared values
+        KahanSum area_sum;                          //!< Running sum of trapezoidal areas between consecutive measurements
+        int64_t  duration_sum;                      //!< Running sum of time differences between consecutive measurements
+        size_t   additions_since_rebase;            //!< Number of measurements added since the last re-calculation
+        MeasurementHistoryBackend* history;         //!< Optional history backend, e.g. a multi-resolution history, not owned by this instance
+        PersistentRingBuffer<TimestampDoublePair>* persistent;  //!< Optional persistent copy of the measurements, not owned by this instance
+
+    public:
+        using RingBuffer<TimestampDoublePair>::value_type;
+        using RingBuffer<TimestampDoublePair>::reference;
+        using RingBuffer<TimestampDoublePair>::const_reference;
+        using RingBuffer<TimestampDoublePair>::size_type;
+
+        // read-only ring buffer interface
+        using RingBuffer<TimestampDoublePair>::getMaximumNumberOfElements;
+        using RingBuffer<TimestampDoublePair>::getNumberOfElements;
+        using RingBuffer<TimestampDoublePair>::operator[];
+        using RingBuffer<TimestampDoublePair>::at;
+        using RingBuffer<TimestampDoublePair>::getNewestElement;
+        using RingBuffer<TimestampDoublePair>::getOldestElement;
+        using RingBuffer<TimestampDoublePair>::getFirstSpan;
+        using RingBuffer<TimestampDoublePair>::getSecondSpan;
+        using RingBuffer<TimestampDoublePair>::getDataVector;
+        using RingBuffer<TimestampDoublePair>::getWritePointer;
+        using RingBuffer<TimestampDoublePair>::getDataVectorIndex;
+        using RingBuffer<TimestampDoublePair>::getRingBufferIndex;
+        using RingBuffer<TimestampDoublePair>::getIndexOutOfBoundsElement;
+        using RingBuffer<TimestampDoublePair>::isIndexOutOfBoundsElement;
+
         /**
          * Constructor.
          * @param capacity Maximum number of measurements
          */
-        MeasurementValues(const size_t capacity) : RingBuffer(capacity) {}
+        MeasurementValues(const size_t capacity) :
+            RingBuffer<TimestampDoublePair>(capacity),
+            running_statistics(false),
+            history(NULL),
+            persistent(NULL) {
+            clearRunningStatistics();
+        }
+
+        /**
+         *  Delete all measurements from the ring buffer.
+         */
+        void clear(void) {
+            RingBuffer<TimestampDoublePair>::clear();
+            clearRunningStatistics();
+            if (persistent != NULL) {
+                persistent->clear();
+            }
+        }
+
+        /**
+         *  Enable or disable running statistics.
+         *  @param enable true to maintain running sums on each addition, false to calculate statistics on demand
+         */
+        void setRunningStatistics(const bool enable) {
+            running_statistics = enable;
+            rebaseRunningStatistics();
+        }
+
+        /**
+         *  Check if running statistics are enabled.
+         *  @return true or false
+         */
+        bool hasRunningStatistics(void) const {
+            return running_statistics;
+        }
+
+        /**
+         *  Attach a history backend, e.g. a MeasurementHistory or a CompressedMeasurementHistory; all subsequently
+         *  added measurements are also added to the history. This is the only history hook, i.e. measurements added
+         *  through a Measurement reach the backend once, as raw values. The history is not owned by this instance and
+         *  it is not affected by clear(); copies of this instance refer to the same history.
+         *  @param h pointer to the history, or NULL to detach the history
+         */
+        void setHistory(MeasurementHistoryBackend* const h) {
+            history = h;
+        }
+
+        /**
+         *  Get the attached history backend.
+         *  @return pointer to the history, or NULL if there is none
+         */
+        MeasurementHistoryBackend* getHistory(void) const {
+            return history;
+        }
+
+        /**
+         *  Attach a persistent ring buffer; all subsequently added measurements are also written to it, such that
+         *  the measurements survive a restart of the process. When attaching, the measurements are restored from the
+         *  persistent ring buffer, i.e. this ring buffer is cleared and refilled with the newest measurements found
+         *  in the persistent ring buffer; running statistics are updated accordingly. The restored measurements are not
+         *  added to an attached history, as they reached it when they were added in the first place.
+         *  The persistent ring buffer is not owned by this instance; copies of this instance refer to the same
+         *  persistent ring buffer.
+         *  @param p pointer to an open persistent ring buffer, or NULL to detach the persistent ring buffer
+         */
+        void setPersistentBuffer(PersistentRingBuffer<TimestampDoublePair>* const p) {
+            persistent = NULL;
+            if (p != NULL) {
+                RingBuffer<TimestampDoublePair>::clear();
+                clearRunningStatistics();
+                const size_t n = p->getNumberOfElements();
+                const size_t capacity = getMaximumNumberOfElements();
+                for (size_t i = (n > capacity && capacity > 0 ? n - capacity : 0); i < n; ++i) {
+                    const TimestampDoublePair& pair = p->at(i);
+                    addValue(pair.value, pair.time);     // bypass the history hook
+                }
+            }
+            persistent = p;
+        }
+
+        /**
+         *  Get the attached persistent ring buffer.
+         *  @return pointer to the persistent ring buffer, or NULL if there is none
+         */
+        PersistentRingBuffer<TimestampDoublePair>* getPersistentBuffer(void) const {
+            return persistent;
+        }
+
+        /**
+         *  Get summary statistics of the measurements in the given time interval at the given resolution.
+         *  The attached history is queried first, see MeasurementHistory::query(); if it returns no buckets, e.g. if
+         *  there is no tier with a bucket duration not exceeding the resolution, each raw measurement in this ring
+         *  buffer is returned as a single-measurement bucket.
+         *  @param from the start of the time interval
+         *  @param to the end of the time interval; it is included
+         *  @param resolution the requested resolution in timestamp units
+         *  @param result the buckets in increasing time order
+         *  @return the number of buckets
+         */
+        size_t query(const uint32_t from, const uint32_t to, const uint32_t resolution, std::vector<MeasurementBucket>& result) const {
+            if (history != NULL && history->query(from, to, resolution, result) > 0) {
+                return result.size();
+            }
+            result.clear();
+            for (size_t i = findLowerBoundIndex(from, 0, getNumberOfElements()); i < getNumberOfElements(); ++i) {
+                const TimestampDoublePair& measurement = at(i);
+                if (SpeedwireTime::calculateTimeDifference(measurement.time, to) > 0) {
+                    break;
+                }
+                result.push_back(MeasurementBucket(measurement.time, measurement.value, measurement.time));
+            }
+            return result.size();
+        }
+
+        /**
+         *  Set maximum number of measurements that can be stored in the ring buffer.
+         *  This will clear any measurements before resizing the ring buffer.
+         *  @param new_capacity the maximum number
+         */
+        void setMaximumNumberOfElements(const size_t new_capacity) {
+            RingBuffer<TimestampDoublePair>::setMaximumNumberOfElements(new_capacity);
+            clearRunningStatistics();
+            if (persistent != NULL) {
+                persistent->clear();
+            }
+        }
+
+        /**
+         *  Add a new measurement to the ring buffer. If the buffer is full, the oldest measurement is replaced.
+         *  @param pair the measurement value and time
+         */
+        void addNewElement(const TimestampDoublePair& pair) {
+            addMeasurement(pair.value, pair.time);
+        }
 
         /**
          *  Add a new measurement to the ring buffer. If the buffer is full, the oldest measurement is replaced.
@@ -44,8 +245,111 @@ namespace libspeedwire {
          *  @param time the measurement time
          */
         void addMeasurement(const double value, const uint32_t time) {
-            const TimestampDoublePair pair(value, time);
-            addNewElement(pair);
+            addValue(value, time);
+            if (history != NULL) {
+                history->addMeasurementValue(value, time);
+            }
+        }
+
+        /**
+         *  Add a new raw measurement value to the ring buffer, i.e. a value before applying the measurement type divisor.
+         *  The attached history receives the raw value. If the buffer is full, the oldest measurement is replaced.
+         *  @param raw_value the raw measurement value
+         *  @param divisor the measurement type divisor to obtain the measurement value in its unit
+         *  @param time the measurement time
+         */
+        void addRawMeasurement(const int64_t raw_value, const unsigned long divisor, const uint32_t time) {
+            addValue((double)raw_value / (double)divisor, time);
+            if (history != NULL) {
+                history->addRawMeasurement(raw_value, divisor, time);
+            }
+        }
+
+        /**
+         *  Add a new unsigned 64-bit raw measurement value to the ring buffer; the attached history receives the
+         *  raw value in its 2's complement representation. If the buffer is full, the oldest measurement is replaced.
+         *  @param raw_value the raw measurement value
+         *  @param divisor the measurement type divisor to obtain the measurement value in its unit
+         *  @param time the measurement time
+         */
+        void addRawMeasurement(const uint64_t raw_value, const unsigned long divisor, const uint32_t time) {
+            addValue((double)raw_value / (double)divisor, time);
+            if (history != NULL) {
+                history->addRawMeasurement((int64_t)raw_value, divisor, time);
+            }
+        }
+
+    protected:
+        /**
+         *  Add a new measurement to the ring buffer, the running statistics and the persistent ring buffer.
+         *  @param value the measurement value
+         *  @param time the measurement time
+         */
+        void addValue(const double value, const uint32_t time) {
+            if (running_statistics) {
+                updateRunningStatistics(value, time);
+            }
+            RingBuffer<TimestampDoublePair>::addNewElement(TimestampDoublePair(value, time));
+            if (persistent != NULL) {
+                persistent->addNewElement(TimestampDoublePair(value, time));
+            }
+            if (running_statistics && ++additions_since_rebase >= getMaximumNumberOfElements()) {
+                rebaseRunningStatistics();
+            }
+        }
+
+    public:
+        /**
+         *  Remove measurements from the ring buffer. Non-existing measurements are silently ignored.
+         *  @param offs index of the first measurement to be removed
+         *  @param n number of measurements to be removed
+         *  @return number of measurements removed
+         */
+        size_t removeElements(const size_t offs, const size_t n) {
+            const size_t num = getNumberOfElements();
+            if (persistent != NULL && offs < num) {
+                // both ring buffers are aligned at their newest measurements, but may hold different numbers of measurements
+                const size_t end = (n < num - offs ? offs + n : num);
+                const size_t persistent_num = persistent->getNumberOfElements();
+                const size_t missing = (num > persistent_num ? num - persistent_num : 0);
+                const size_t extra = (persistent_num > num ? persistent_num - num : 0);
+                if (end > missing) {
+                    const size_t from = (offs > missing ? offs : missing);
+                    persistent->removeElements(from - missing + extra, end - from);
+                }
+            }
+            const size_t removed = RingBuffer<TimestampDoublePair>::removeElements(offs, n);
+            if (running_statistics && removed > 0) {
+                rebaseRunningStatistics();
+            }
+            return removed;
+        }
+
+        /**
+         *  Remove the given number of oldest measurements from the ring buffer.
+         *  @param n number of measurements to be removed
+         *  @return number of measurements removed
+         */
+        size_t removeOldestElements(const size_t n) {
+            return removeElements(0, n);
+        }
+
+        /**
+         *  Remove the given number of newest measurements from the ring buffer.
+         *  @param n number of measurements to be removed
+         *  @return number of measurements removed
+         */
+        size_t removeNewestElements(const size_t n) {
+            const size_t removed = (n < getNumberOfElements() ? n : getNumberOfElements());
+            return removeElements(getNumberOfElements() - removed, removed);
+        }
+
+        /**
+         *  Get read-only access to the underlying ring buffer of measurements.
+         *  @return reference to the ring buffer
+         */
+        const RingBuffer<TimestampDoublePair>& getRingBuffer(void) const {
+            return *this;
         }
 
         /**
@@ -53,23 +357,45 @@ namespace libspeedwire {
          *  @return index in ring buffer
          */
         size_t findClosestIndex(const uint32_t time) const {
-            if (getNumberOfElements() > 0) {
-                // binary search
-                size_t low = 0;
-                size_t high = getNumberOfElements() - 1;
-                while ((low + 1) < high) {
-                    const size_t mid = (low + high) / 2u;
-                    if (SpeedwireTime::calculateTimeDifference(time, at(mid).time) > 0) {  // use signed difference
-                        low = mid;
-                    }
-                    else {
-                        high = mid;
-                    }
-                }
+            return findClosestIndex(time, findLowerBoundIndex(time, 0, getNumberOfElements()));
+        }
+
+        /**
+         *  Get the index in the ring buffer time-wise closest to the given time, given the index of the first
+         *  measurement that is not older than the given time.
+         *  @param time the time to compare with
+         *  @param lower_bound the index of the first measurement not older than time; getNumberOfElements() if there is none
+         *  @return index in ring buffer; (size_t)-1 if the ring buffer is empty
+         */
+        size_t findClosestIndex(const uint32_t time, const size_t lower_bound) const {
+            const size_t num_measurements = getNumberOfElements();
+            if (num_measurements > 1) {
+                const size_t high = (lower_bound == 0 ? 1 : (lower_bound < num_measurements ? lower_bound : num_measurements - 1));
+                const size_t low  = high - 1;
                 const bool low_is_closer = (SpeedwireTime::calculateAbsTimeDifference(time, at(low).time) < SpeedwireTime::calculateAbsTimeDifference(time, at(high).time));
                 return (low_is_closer ? low : high);
             }
-            return (size_t)-1;
+            return (num_measurements > 0 ? 0 : (size_t)-1);
+        }
+
+        /**
+         *  Binary search for the first measurement in the given index range that is not older than the given time.
+         *  @param time the time to compare with
+         *  @param from the first index of the range
+         *  @param to the index after the last index of the range
+         *  @return the index of the first measurement not older than time; to if there is none
+         */
+        size_t findLowerBoundIndex(const uint32_t time, size_t from, size_t to) const {
+            while (from < to) {
+                const size_t mid = from + (to - from) / 2u;
+                if (SpeedwireTime::calculateTimeDifference(time, at(mid).time) > 0) {  // use signed difference
+                    from = mid + 1;
+                }
+                else {
+                    to = mid;
+                }
+            }
+            return from;
         }
 
         /**
@@ -91,7 +417,16 @@ namespace libspeedwire {
          *  @return the interpolated measurement value
          */
         double interpolateClosestValues(const uint32_t time) const {
-            const size_t index_center = findClosestIndex(time);
+            return interpolateClosestValues(time, findClosestIndex(time));
+        }
+
+        /**
+         *  Interpolate the two measurement values time-wise closest to the given time.
+         *  @param time the time to compare with
+         *  @param index_center the index of the measurement time-wise closest to the given time, see findClosestIndex()
+         *  @return the interpolated measurement value
+         */
+        double interpolateClosestValues(const uint32_t time, const size_t index_center) const {
             if (index_center != (size_t)-1) {
                 const size_t num_measurements = getNumberOfElements();
                 if (num_measurements > 1) {
@@ -114,16 +449,61 @@ namespace libspeedwire {
             return 0.0;
         }
 
+        /**
+         *  Interpolate this series onto the given target times in a single pass.
+         *  The target times are expected to be monotonically increasing; the result for each target time is
+         *  identical to interpolateClosestValues(time).
+         *  @param target_times the times to interpolate at
+         *  @param result the interpolated values, one for each target time
+         */
+        void resample(const std::vector<uint32_t>& target_times, std::vector<double>& result) const;
+
         /**
          *  Estimate the sample mean, aka average value, of all measurements in the ring buffer.
          *  @return average value
          */
         double estimateMean(void) const {
-            double sum = 0.0;
-            for (const auto& m : data_vector) {
-                sum += m.value;
+            if (running_statistics) {
+                return value_sum.sum / getNumberOfElements();
             }
-            return sum / data_vector.size();
+            const double sum = sumValues(getFirstSpan()) + sumValues(getSecondSpan());
+            return sum / getNumberOfElements();
+        }
+
+        /**
+         *  Estimate the sample variance of all measurements in the ring buffer.
+         *  @return sample variance; FLT_MAX if there are less than two measurements
+         */
+        double estimateVariance(void) const {
+            const size_t n_values = getNumberOfElements();
+            if (n_values <= 1) {
+                return FLT_MAX;
+            }
+            if (running_statistics) {
+                const double mean = value_sum.sum / n_values;
+                return (value_sq_sum.sum - mean * value_sum.sum) / (n_values - 1);
+            }
+            double mean, var;
+            estimateMeanAndVariance(0, n_values - 1, mean, var);
+            return var;
+        }
+
+        /**
+         *  Estimate the time-weighted mean of all measurements in the ring buffer, i.e. the area below the piecewise
+         *  linear measurement curve divided by the time span covered by the measurements.
+         *  @return time-weighted average value; the plain average if all measurements have the same timestamp
+         */
+        double estimateTimeWeightedMean(void) const {
+            double area;
+            int64_t duration;
+            if (running_statistics) {
+                area = area_sum.sum;
+                duration = duration_sum;
+            }
+            else {
+                calculateArea(area, duration);
+            }
+            return (duration != 0 ? area / (double)duration : estimateMean());
         }
 
         /**
@@ -133,11 +513,9 @@ namespace libspeedwire {
          *  @return average value
          */
         double estimateMean(const size_t from, const size_t to) const {
-            double sum = 0.0;
-            for (size_t index = from; index <= to; ++index) {
-                sum += at(index).value;
-            }
-            return sum / (to - from + 1);
+            const size_t n_values = to - from + 1;
+            const double sum = sumValues(getFirstSpan(from, n_values)) + sumValues(getSecondSpan(from, n_values));
+            return sum / n_values;
         }
 
         /**
@@ -151,11 +529,8 @@ namespace libspeedwire {
             const size_t n_values = end_index - start_index + 1;
 
             double y_sum = 0.0, y_sq_sum = 0.0;
-            for (size_t index = start_index; index <= end_index; ++index) {
-                const double value = at(index).value;
-                y_sum    += value;
-                y_sq_sum += value * value;
-            }
+            sumValuesAndSquares(getFirstSpan(start_index, n_values), y_sum, y_sq_sum);
+            sumValuesAndSquares(getSecondSpan(start_index, n_values), y_sum, y_sq_sum);
             mean = y_sum / n_values;
             // sample var = sum(y - mean) / (n_values - 1) is equivalent to (sum(y) / n_values - mean * mean) * (n_values / (n_values - 1))
             var  = (n_values <= 1 ? FLT_MAX : (y_sq_sum - mean * y_sum) / (n_values - 1));
@@ -175,12 +550,10 @@ namespace libspeedwire {
 
             // estimate mean of y-coordinate, sample variance of y coordinate and also the xy covariance
             double y_sum = 0.0, y_sq_sum = 0.0, xy_sum = 0.0;
-            for (size_t index = start_index; index <= end_index; ++index) {
-                const double value = at(index).value;
-                y_sum    += value;
-                y_sq_sum += value * value;
-                xy_sum   += value * (index - start_index);
-            }
+            const RingBufferSpan<TimestampDoublePair> first  = getFirstSpan(start_index, n_values);
+            const RingBufferSpan<TimestampDoublePair> second = getSecondSpan(start_index, n_values);
+            sumValuesAndProducts(first, 0.0, y_sum, y_sq_sum, xy_sum);
+            sumValuesAndProducts(second, (double)first.size, y_sum, y_sq_sum, xy_sum);
             mean = y_sum / n_values;
             var  = (n_values <= 1 ? FLT_MAX : (y_sq_sum - mean * y_sum) / n_values_minus_1);
 
@@ -205,8 +578,250 @@ namespace libspeedwire {
             slope = ((x_var_num * xy_var_den) != 0 ? (xy_var_num * x_var_den) / (x_var_num * xy_var_den) : 0.0);
 #endif
         }
+
+        /**
+         *  Re-calculate the running statistics from all measurements in the ring buffer.
+         *  This removes any accumulated rounding errors.
+         */
+        void rebaseRunningStatistics(void) {
+            clearRunningStatistics();
+            if (running_statistics) {
+                const size_t n_values = getNumberOfElements();
+                for (size_t i = 0; i < n_values; ++i) {
+                    const double value = at(i).value;
+                    value_sum.add(value);
+                    value_sq_sum.add(value * value);
+                    if (i > 0) {
+                        const int32_t dt = SpeedwireTime::calculateTimeDifference(at(i).time, at(i - 1).time);
+                        area_sum.add(0.5 * (at(i - 1).value + value) * dt);
+                        duration_sum += dt;
+                    }
+                }
+            }
+        }
+
+    protected:
+
+        /**
+         *  Reset all running sums to 0.
+         */
+        void clearRunningStatistics(void) {
+            value_sum.clear();
+            value_sq_sum.clear();
+            area_sum.clear();
+            duration_sum = 0;
+            additions_since_rebase = 0;
+        }
+
+        /**
+         *  Update the running sums for the given measurement before it is added to the ring buffer; this removes
+         *  the contribution of the oldest measurement, if it is about to be replaced.
+         */
+        void updateRunningStatistics(const double value, const uint32_t time) {
+            const size_t n_values = getNumberOfElements();
+            size_t n_remaining = n_values;
+            if (n_values > 0 && n_values >= getMaximumNumberOfElements()) {
+                const double oldest = at(0).value;
+                value_sum.add(-oldest);
+                value_sq_sum.add(-oldest * oldest);
+                if (n_values > 1) {
+                    const int32_t dt = SpeedwireTime::calculateTimeDifference(at(1).time, at(0).time);
+                    area_sum.add(-0.5 * (oldest + at(1).value) * dt);
+                    duration_sum -= dt;
+                }
+                --n_remaining;
+            }
+            value_sum.add(value);
+            value_sq_sum.add(value * value);
+            if (n_remaining > 0) {
+                const double newest = at(n_values - 1).value;
+                const int32_t dt = SpeedwireTime::calculateTimeDifference(time, at(n_values - 1).time);
+                area_sum.add(0.5 * (newest + value) * dt);
+                duration_sum += dt;
+            }
+        }
+
+        /**
+         *  Calculate the trapezoidal area below the measurement curve and the time span covered by the measurements.
+         */
+        void calculateArea(double& area, int64_t& duration) const {
+            area = 0.0;
+            duration = 0;
+            for (size_t i = 1; i < getNumberOfElements(); ++i) {
+                const int32_t dt = SpeedwireTime::calculateTimeDifference(at(i).time, at(i - 1).time);
+                area += 0.5 * (at(i - 1).value + at(i).value) * dt;
+                duration += dt;
+            }
+        }
+
+        // The kernels below read the values of the measurements in the given span with a stride of sizeof(TimestampDoublePair).
+        // Each sum is split into eight independent accumulators, such that consecutive additions do not wait for each
+        // other; the result does not depend on re-association of floating point operations by the compiler.
+        enum { lanes = 8 };    //!< Number of independent accumulators of each sum
+
+        /**
+         *  Calculate the sum of all values in the given span.
+         */
+        static double sumValues(const RingBufferSpan<TimestampDoublePair>& span) {
+            const TimestampDoublePair* y = span.data;
+            const size_t n = span.size;
+            double s[lanes] = { 0.0 };
+            size_t i = 0;
+            for (; i + lanes <= n; i += lanes) {
+                for (size_t k = 0; k < lanes; ++k) {
+                    s[k] += y[i + k].value;
+                }
+            }
+            for (; i < n; ++i) {
+                s[0] += y[i].value;
+            }
+            return reduce(s);
+        }
+
+        /**
+         *  Add the sum and the sum of squares of all values in the given span to y_sum and y_sq_sum.
+         */
+        static void sumValuesAndSquares(const RingBufferSpan<TimestampDoublePair>& span, double& y_sum, double& y_sq_sum) {
+            const TimestampDoublePair* y = span.data;
+            const size_t n = span.size;
+            double s[lanes] = { 0.0 }, q[lanes] = { 0.0 };
+            size_t i = 0;
+            for (; i + lanes <= n; i += lanes) {
+                for (size_t k = 0; k < lanes; ++k) {
+                    const double value = y[i + k].value;
+                    s[k] += value;
+                    q[k] += value * value;
+                }
+            }
+            for (; i < n; ++i) {
+                const double value = y[i].value;
+                s[0] += value;
+                q[0] += value * value;
+            }
+            y_sum    += reduce(s);
+            y_sq_sum += reduce(q);
+        }
+
+        /**
+         *  Add the sum, the sum of squares and the sum of products x * y of all values in the given span to y_sum,
+         *  y_sq_sum and xy_sum; x is the index relative to the start of the regression interval, starting with x0.
+         */
+        static void sumValuesAndProducts(const RingBufferSpan<TimestampDoublePair>& span, const double x0, double& y_sum, double& y_sq_sum, double& xy_sum) {
+            const TimestampDoublePair* y = span.data;
+            const size_t n = span.size;
+            double s[lanes] = { 0.0 }, q[lanes] = { 0.0 }, p[lanes] = { 0.0 };
+            double x = x0;
+            size_t i = 0;
+            for (; i + lanes <= n; i += lanes, x += lanes) {
+                for (size_t k = 0; k < lanes; ++k) {
+                    const double value = y[i + k].value;
+                    s[k] += value;
+                    q[k] += value * value;
+                    p[k] += value * (x + k);
+                }
+            }
+            for (; i < n; ++i, x += 1.0) {
+                const double value = y[i].value;
+                s[0] += value;
+                q[0] += value * value;
+                p[0] += value * x;
+            }
+            y_sum    += reduce(s);
+            y_sq_sum += reduce(q);
+            xy_sum   += reduce(p);
+        }
+
+        /**
+         *  Add up the given independent accumulators pairwise.
+         */
+        static double reduce(const double (&s)[lanes]) {
+            return ((s[0] + s[1]) + (s[2] + s[3])) + ((s[4] + s[5]) + (s[6] + s[7]));
+        }
+    };
+
+
+    /**
+     *  Class implementing a cursor to look up measurements for a sequence of monotonically increasing query times.
+     *  The cursor remembers the position of the previous query and starts a galloping search from there, such
+     *  that a monotonic sweep across the measurement values costs amortized O(1) per query. Queries in any other
+     *  order or modifications of the measurement values are allowed; they just cost more search steps.
+     */
+    class MeasurementValuesCursor {
+    protected:
+        const MeasurementValues& values;    //!< The measurement values to look up
+        size_t position;                    //!< The lower bound index of the previous query
+
+    public:
+        /**
+         * Constructor.
+         * @param mvalues the measurement values to look up
+         */
+        MeasurementValuesCursor(const MeasurementValues& mvalues) : values(mvalues), position(0) {}
+
+        /**
+         *  Move the cursor back to the oldest measurement.
+         */
+        void reset(void) {
+            position = 0;
+        }
+
+        /**
+         *  Find the index of the first measurement that is not older than the given time.
+         *  @param time the time to compare with
+         *  @return the index of the first measurement not older than time; getNumberOfElements() if there is none
+         */
+        size_t findLowerBoundIndex(const uint32_t time) {
+            const size_t n = values.getNumberOfElements();
+            size_t pos = (position < n ? position : n);
+            if (pos < n && SpeedwireTime::calculateTimeDifference(time, values.at(pos).time) > 0) {
+                // gallop forward: the measurement at pos is older than time
+                size_t step = 1;
+                while (pos + step < n && SpeedwireTime::calculateTimeDifference(time, values.at(pos + step).time) > 0) {
+                    pos += step;
+                    step *= 2;
+                }
+                position = values.findLowerBoundIndex(time, pos + 1, (pos + step < n ? pos + step : n));
+            }
+            else {
+                // gallop backward: the measurement at pos is not older than time, or pos is beyond the newest measurement
+                size_t step = 1;
+                while (pos >= step && SpeedwireTime::calculateTimeDifference(time, values.at(pos - step).time) <= 0) {
+                    pos -= step;
+                    step *= 2;
+                }
+                position = values.findLowerBoundIndex(time, (pos >= step ? pos - step + 1 : 0), pos);
+            }
+            return position;
+        }
+
+        /**
+         *  Get the index in the ring buffer time-wise closest to the given time; see MeasurementValues::findClosestIndex().
+         *  @param time the time to compare with
+         *  @return index in ring buffer; (size_t)-1 if the ring buffer is empty
+         */
+        size_t findClosestIndex(const uint32_t time) {
+            return values.findClosestIndex(time, findLowerBoundIndex(time));
+        }
+
+        /**
+         *  Interpolate the two measurement values time-wise closest to the given time; see MeasurementValues::interpolateClosestValues().
+         *  @param time the time to compare with
+         *  @return the interpolated measurement value
+         */
+        double interpolateClosestValues(const uint32_t time) {
+            return values.interpolateClosestValues(time, findClosestIndex(time));
+        }
     };
 
+
+    inline void MeasurementValues::resample(const std::vector<uint32_t>& target_times, std::vector<double>& result) const {
+        MeasurementValuesCursor cursor(*this);
+        result.resize(target_times.size());
+        for (size_t i = 0; i < target_times.size(); ++i) {
+            result[i] = cursor.interpolateClosestValues(target_times[i]);
+        }
+    }
+
 }   // namespace libspeedwire
 
 #endif
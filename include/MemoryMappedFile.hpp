@@ -0,0 +1,60 @@
+#ifndef __LIBSPEEDWIRE_MEMORYMAPPEDFILE_HPP__
+#define __LIBSPEEDWIRE_MEMORYMAPPEDFILE_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace libspeedwire {
+
+    /**
+     *  Class encapsulating a read-write or read-only memory mapping of a file.
+     *  Modifications of the mapped memory are written back to the file by the operating system's page cache;
+     *  they therefore survive a crash of the process. Use flush() to force write back to the storage device.
+     *  Writing to a read-only mapping terminates the process.
+     */
+    class MemoryMappedFile {
+    protected:
+        std::string path;
+        size_t      size;
+        uint8_t*    data;
+        bool        read_only;
+#ifdef _WIN32
+        void*       file_handle;
+        void*       mapping_handle;
+#else
+        int         file_descriptor;
+#endif
+
+    public:
+        MemoryMappedFile(void);
+        ~MemoryMappedFile(void);
+
+        // non-copyable, as the instance owns the mapping
+        MemoryMappedFile(const MemoryMappedFile&) = delete;
+        MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+        bool open(const std::string& path, const size_t size);
+        bool openReadOnly(const std::string& path);
+        void close(void);
+        bool flush(const bool synchronous);
+
+        /** Check if a file is mapped. */
+        bool isOpen(void) const { return data != NULL; }
+
+        /** Get a pointer to the mapped memory; NULL if no file is mapped. */
+        uint8_t* getData(void) const { return data; }
+
+        /** Check if the mapping is read-only. */
+        bool isReadOnly(void) const { return read_only; }
+
+        /** Get the size of the mapped memory in bytes. */
+        size_t getSize(void) const { return size; }
+
+        /** Get the path of the mapped file. */
+        const std::string& getPath(void) const { return path; }
+    };
+
+}   // namespace libspeedwire
+
+#endif
@@ -5,6 +5,7 @@
 #include <vector>
 #include <Consumer.hpp>
 #include <ObisData.hpp>
+#include <MeasurementFrame.hpp>
 #include <SpeedwireDevice.hpp>
 
 namespace libspeedwire {
@@ -17,12 +18,18 @@ namespace libspeedwire {
      *  The general idea is that the ObisData instances held by the filter will hold the most recent obis data
      *  values. Also aggregation of consecutively received obis data is done inside the ObisData instances held
      *  by the filter. Registered onsumers will recieve a reference to the ObisData instance held by the filter.
+     *
+     *  Registered frame consumers will receive a single ObisDataFrame per emeter packet, holding all filtered
+     *  obis elements of the packet, once the end of the packet has been signalled by endOfObisData().
      */
     class ObisFilter {
 
     protected:
-        std::vector<ObisConsumer*> consumerTable;   //!< Table of registered ObisConsumers
-        ObisDataMap                filterMap;       //!< Map of registered ObisData instance
+        std::vector<ObisConsumer*>         consumerTable;       //!< Table of registered ObisConsumers
+        std::vector<ObisFrameConsumer*>    frameConsumerTable;  //!< Table of registered ObisFrameConsumers
+        std::vector<ObisDataFrameElement>  frameElements;       //!< Elements of the emeter packet currently being received
+        MeasurementFrame                   measurementFrame;    //!< Numeric values of the emeter packet currently being received
+        ObisDataMap                        filterMap;           //!< Map of registered ObisData instance
 
     public:
         ObisFilter(void);
@@ -35,6 +42,7 @@ namespace libspeedwire {
         ObisDataMap& getFilter(void);
 
         void addConsumer(ObisConsumer& obisConsumer);
+        void addFrameConsumer(ObisFrameConsumer& obisFrameConsumer);
 
         bool consume(const SpeedwireDevice&device, const void* const obis, const uint32_t time);
         ObisData* const filter(const SpeedwireDevice& device, const ObisType& element);
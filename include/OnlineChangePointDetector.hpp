@@ -0,0 +1,72 @@
+#ifndef __LIBSPEEDWIRE_ONLINECHANGEPOINTDETECTOR_HPP__
+#define __LIBSPEEDWIRE_ONLINECHANGEPOINTDETECTOR_HPP__
+
+#include <cstdint>
+#include <RingBuffer.hpp>
+#include <MeasurementValues.hpp>
+#include <LineSegmentEstimator.hpp>
+
+namespace libspeedwire {
+
+    /**
+     *  Class OnlineChangePointDetector implements a streaming version of
+     *  LineSegmentEstimator::findPiecewiseConstantIntervals().
+     *
+     *  Measurements are consumed one at a time. The mean and variance of the sliding window -window_size .. 0 .. window_size
+     *  around each measurement are maintained by incrementally updated sliding sums, and the simplified total variation
+     *  minimum seeker together with the 3-sigma rule of the batch version is applied to the stream of window estimates.
+     *  Each measurement is therefore processed in O(1).
+     *
+     *  A change point after measurement m is confirmed once measurement m + 2 * window_size + 2 has been added; the
+     *  interval ending at m is then finalized and never revisited. Confirmed change points are identical to the change
+     *  points found by the batch version on the same measurements, except for the most recent 2 * window_size + 2
+     *  measurements, where the batch version evaluates truncated windows.
+     *
+     *  Interval indexes count measurements from the start of the stream, or from the most recent reset().
+     */
+    class OnlineChangePointDetector {
+    protected:
+        struct Estimate {
+            double mean;
+            double variance;
+            Estimate(void) : mean(0.0), variance(0.0) {}
+            Estimate(const double m, const double v) : mean(m), variance(v) {}
+        };
+
+        size_t   window_size;                       //!< Sliding window size: -window_size .. 0 .. window_size
+        double   min_three_sigma_squared;           //!< Change points with a smaller 9 * variance are ignored
+        RingBuffer<TimestampDoublePair> samples;    //!< Most recent 2 * window_size + 3 measurements
+        RingBuffer<Estimate> estimates;             //!< Most recent 2 * window_size + 4 window estimates
+        size_t   number_of_samples;                 //!< Number of measurements added since reset()
+        size_t   number_of_estimates;               //!< Number of window estimates calculated since reset()
+        double   window_sum;                        //!< Sliding sum of values in the current window
+        double   window_sq_sum;                     //!< Sliding sum of squared values in the current window
+        bool     downwards;                         //!< Minimum seeker state
+        size_t   interval_start;                    //!< Index of the first measurement of the open interval
+        uint32_t interval_start_time;               //!< Time of the first measurement of the open interval
+        double   interval_sum;                      //!< Sum of all values of the open interval
+
+        void addEstimate(const size_t n);
+        bool evaluate(MeasurementValueInterval& interval);
+        void rebaseWindowSums(void);
+
+    public:
+        OnlineChangePointDetector(const size_t window_size = 6, const double min_three_sigma_squared = 200.0);
+
+        void reset(void);
+        bool addMeasurement(const double value, const uint32_t time, MeasurementValueInterval& interval);
+        bool getOpenInterval(MeasurementValueInterval& interval) const;
+
+        /** Get the number of measurements added since the last reset(). */
+        size_t getNumberOfMeasurements(void) const { return number_of_samples; }
+
+        /** Get the sliding window size. */
+        size_t getWindowSize(void) const { return window_size; }
+
+        /** Get the number of measurements needed to confirm a change point, i.e. the latency of the detector. */
+        size_t getLatency(void) const { return 2 * window_size + 2; }
+    };
+
+}   // namespace libspeedwire
+
+#endif
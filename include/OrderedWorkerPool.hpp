@@ -0,0 +1,293 @@
+#ifndef __LIBSPEEDWIRE_ORDEREDWORKERPOOL_HPP__
+#define __LIBSPEEDWIRE_ORDEREDWORKERPOOL_HPP__
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+namespace libspeedwire {
+
+    //! Policy applied when a job is submitted to a full OrderedWorkerPool queue.
+    enum class OverflowPolicy : uint8_t {
+        DROP_OLDEST = 0,    //!< Drop the oldest queued job of any key and queue the new job.
+        DROP_NEWEST = 1,    //!< Drop the new job.
+        MERGE       = 2     //!< Merge the new job into the newest queued job of the same key; if there is none, queue the new job in excess of the queue size.
+    };
+
+
+    /**
+     *  Class OrderedWorkerPool implements a pool of worker threads processing jobs off the calling thread.
+     *
+     *  Each job is submitted together with a key, e.g. the serial number of the originating device. Jobs of different
+     *  keys are processed concurrently by the worker threads; jobs of the same key are processed one at a time in
+     *  submission order, such that the work function can keep state per key. Results are handed back by deliver() on
+     *  the calling thread in submission order per key. Results of different keys are independent of each other.
+     *
+     *  The job queue is bounded. Only if analysis falls behind and the queue is full, the configured OverflowPolicy
+     *  decides which job is dropped or merged. The MERGE policy combines the new job with the newest queued job of the
+     *  same key using the merge function, which by default replaces the queued job, i.e. it assumes that a newer job
+     *  supersedes an older one. MERGE never drops a job; as each key has at most one queued job in excess of the queue
+     *  size, the queue is bounded by the queue size plus the number of keys. Dropped jobs are skipped when delivering results.
+     *
+     *  If the pool is created without worker threads, queued jobs are processed by deliver() on the calling thread.
+     */
+    template<class Job, class Result> class OrderedWorkerPool {
+    public:
+        /** Work function type; it processes the job and stores the outcome in the result; worker is the index of the calling worker thread. */
+        typedef std::function<void(const Job& job, Result& result, const size_t worker)> WorkFunction;
+
+        /** Delivery callback type; it is called on the thread calling deliver(). */
+        typedef std::function<void(const uint32_t key, Result& result)> DeliveryFunction;
+        /** Merge function type; it merges the newer job into the queued job of the same key. */
+        typedef std::function<void(Job& queued, const Job& job)> MergeFunction;
+
+    protected:
+        //! A queued job.
+        struct QueueEntry {
+            uint32_t key;
+            uint64_t sequence;
+            Job      job;
+            QueueEntry(const uint32_t k, const uint64_t s, const Job& j) : key(k), sequence(s), job(j) {}
+        };
+
+        //! A finished job; dropped jobs are finished without a valid result.
+        struct Completion {
+            bool   valid;
+            Result result;
+            Completion(void) : valid(false), result() {}
+        };
+
+        //! Sequencing state of a key.
+        struct KeyState {
+            uint64_t next_sequence;                         //!< Sequence number of the next submitted job
+            uint64_t next_delivery;                         //!< Sequence number of the next delivered result
+            std::map<uint64_t, Completion> completed;       //!< Finished jobs not yet delivered
+            bool     busy;                                  //!< True while a job of the key is processed
+            KeyState(void) : next_sequence(0), next_delivery(0), busy(false) {}
+        };
+
+        WorkFunction                work;
+        MergeFunction               merge;
+        const size_t                max_queue_size;
+        const OverflowPolicy        policy;
+        std::vector<std::thread>    threads;
+        std::deque<QueueEntry>      queue;
+        std::map<uint32_t, KeyState> keys;
+        std::vector<std::pair<uint32_t, Completion> > ready;   //!< Scratch buffer for deliver(), only used by the calling thread
+        mutable std::mutex          mutex;
+        std::condition_variable     job_available;
+        std::condition_variable     idle;
+        size_t                      active;
+        size_t                      dropped;
+        bool                        stopping;
+
+        /** Mark the given job as finished without result; the mutex must be held. */
+        void dropLocked(const uint32_t key, const uint64_t sequence) {
+            keys[key].completed[sequence] = Completion();
+            ++dropped;
+        }
+
+        /** Process the given job and store its result; the mutex must not be held. */
+        void process(QueueEntry& entry, const size_t worker) {
+            Completion completion;
+            work(entry.job, completion.result, worker);
+            completion.valid = true;
+            std::lock_guard<std::mutex> lock(mutex);
+            keys[entry.key].completed[entry.sequence] = std::move(completion);
+        }
+
+        /** Find the oldest queued job whose key is not busy; the mutex must be held. */
+        typename std::deque<QueueEntry>::iterator findRunnableLocked(void) {
+            typename std::deque<QueueEntry>::iterator it = queue.begin();
+            while (it != queue.end() && keys[it->key].busy) {
+                ++it;
+            }
+            return it;
+        }
+
+        /** Worker thread main loop; queued jobs are processed until the pool is stopped and the queue is empty. */
+        void run(const size_t worker) {
+            std::unique_lock<std::mutex> lock(mutex);
+            for (;;) {
+                typename std::deque<QueueEntry>::iterator it;
+                job_available.wait(lock, [&]() { return (stopping && queue.empty()) || (it = findRunnableLocked()) != queue.end(); });
+                if (queue.empty()) {
+                    break;
+                }
+                QueueEntry entry(std::move(*it));
+                queue.erase(it);
+                keys[entry.key].busy = true;
+                ++active;
+                lock.unlock();
+                process(entry, worker);
+                lock.lock();
+                keys[entry.key].busy = false;
+                if (--active == 0 && queue.empty()) {
+                    idle.notify_all();
+                }
+                if (queue.empty() == false) {
+                    job_available.notify_all();
+                }
+            }
+        }
+
+    public:
+
+        /**
+         *  Constructor.
+         *  @param work_function the function processing a job
+         *  @param number_of_threads the number of worker threads; if 0, jobs are processed by deliver()
+         *  @param queue_size the maximum number of queued jobs; it is at least 1
+         *  @param overflow_policy the policy applied when a job is submitted to a full queue
+         *  @param merge_function the function merging jobs for OverflowPolicy::MERGE; if empty, the queued job is replaced
+         */
+        OrderedWorkerPool(const WorkFunction& work_function, const size_t number_of_threads, const size_t queue_size, const OverflowPolicy overflow_policy,
+                          const MergeFunction& merge_function = MergeFunction()) :
+            work(work_function),
+            merge(merge_function),
+            max_queue_size(queue_size > 0 ? queue_size : 1),
+            policy(overflow_policy),
+            active(0),
+            dropped(0),
+            stopping(false) {
+            for (size_t i = 0; i < number_of_threads; ++i) {
+                threads.push_back(std::thread(&OrderedWorkerPool::run, this, i));
+            }
+        }
+
+        /** Destructor; queued jobs are processed, but their results are not delivered. */
+        ~OrderedWorkerPool(void) {
+            stop();
+        }
+
+        OrderedWorkerPool(const OrderedWorkerPool&) = delete;
+        OrderedWorkerPool& operator=(const OrderedWorkerPool&) = delete;
+
+        /**
+         *  Submit a job.
+         *  @param key the key defining the delivery order, e.g. a device serial number
+         *  @param job the job
+         *  @return true if the job has been queued, false if it has been dropped
+         */
+        bool submit(const uint32_t key, const Job& job) {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (stopping) {
+                return false;
+            }
+            KeyState& state = keys[key];
+            if (queue.size() >= max_queue_size) {
+                if (policy == OverflowPolicy::MERGE) {
+                    for (typename std::deque<QueueEntry>::reverse_iterator it = queue.rbegin(); it != queue.rend(); ++it) {
+                        if (it->key == key) {
+                            dropLocked(key, it->sequence);
+                            it->sequence = state.next_sequence++;
+                            if (merge) {
+                                merge(it->job, job);
+                            } else {
+                                it->job = job;
+                            }
+                            return true;
+                        }
+                    }
+                }
+                else if (policy == OverflowPolicy::DROP_NEWEST) {
+                    ++dropped;
+                    return false;
+                }
+                else {
+                    dropLocked(queue.front().key, queue.front().sequence);
+                    queue.pop_front();
+                }
+            }
+            queue.push_back(QueueEntry(key, state.next_sequence++, job));
+            lock.unlock();
+            job_available.notify_one();
+            return true;
+        }
+
+        /**
+         *  Deliver all results that are available in submission order per key. If the pool has no worker threads,
+         *  all queued jobs are processed first.
+         *  @param callback the function called for each result
+         *  @return the number of delivered results
+         */
+        size_t deliver(const DeliveryFunction& callback) {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (threads.empty()) {
+                while (queue.empty() == false) {
+                    QueueEntry entry(std::move(queue.front()));
+                    queue.pop_front();
+                    lock.unlock();
+                    process(entry, 0);
+                    lock.lock();
+                }
+            }
+            ready.clear();
+            for (auto& key : keys) {
+                KeyState& state = key.second;
+                typename std::map<uint64_t, Completion>::iterator it;
+                while ((it = state.completed.begin()) != state.completed.end() && it->first == state.next_delivery) {
+                    if (it->second.valid) {
+                        ready.push_back(std::make_pair(key.first, std::move(it->second)));
+                    }
+                    state.completed.erase(it);
+                    ++state.next_delivery;
+                }
+            }
+            lock.unlock();
+            for (auto& entry : ready) {
+                callback(entry.first, entry.second.result);
+            }
+            return ready.size();
+        }
+
+        /**
+         *  Wait until all queued jobs have been processed; results are not delivered.
+         */
+        void waitUntilIdle(void) {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (threads.empty() == false) {
+                idle.wait(lock, [this]() { return queue.empty() && active == 0; });
+            }
+        }
+
+        /**
+         *  Stop all worker threads after processing the queued jobs; subsequently submitted jobs are dropped.
+         */
+        void stop(void) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            job_available.notify_all();
+            for (auto& thread : threads) {
+                if (thread.joinable()) {
+                    thread.join();
+                }
+            }
+        }
+
+        /** Get the number of worker threads. */
+        size_t getNumberOfThreads(void) const { return threads.size(); }
+
+        /** Get the number of queued jobs not yet being processed. */
+        size_t getNumberOfQueuedJobs(void) const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return queue.size();
+        }
+
+        /** Get the number of jobs dropped or merged due to queue overflow. */
+        size_t getNumberOfDroppedJobs(void) const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return dropped;
+        }
+    };
+
+}   // namespace libspeedwire
+
+#endif
@@ -0,0 +1,313 @@
+#ifndef __LIBSPEEDWIRE_PERSISTENTRINGBUFFER_HPP__
+#define __LIBSPEEDWIRE_PERSISTENTRINGBUFFER_HPP__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <RingBuffer.hpp>
+#include <MemoryMappedFile.hpp>
+
+namespace libspeedwire {
+
+    /**
+     *  Class encapsulating one of the two copies of the mutable state in a PersistentRingBuffer file header.
+     */
+    class PersistentRingBufferState {
+    public:
+        uint64_t generation;            //!< Incremented with each update; the valid copy with the higher generation is current
+        uint64_t write_pointer;         //!< Write pointer pointing to the next element slot to write to
+        uint64_t number_of_elements;    //!< Number of elements currently stored
+        uint32_t checksum;              //!< FNV-1a checksum of the immutable header fields and all preceding state fields
+        uint32_t reserved;
+    };
+
+
+    /**
+     *  Class encapsulating the header of a PersistentRingBuffer file.
+     *  The header is followed by the element array at offset PersistentRingBufferHeader::data_offset.
+     */
+    class PersistentRingBufferHeader {
+    public:
+        static const uint32_t magic_value = 0x42525753;     //!< "SWRB" in little endian byte order
+        static const uint32_t version_value = 2;
+        static const size_t   data_offset = 128;            //!< Byte offset of the element array, keeps elements cache line aligned
+
+        uint32_t magic;                 //!< Magic number identifying the file format
+        uint32_t version;               //!< File format version
+        uint32_t element_size;          //!< sizeof(T)
+        uint32_t reserved;
+        uint64_t capacity;              //!< Maximum number of elements; the file holds capacity + 1 element slots
+        PersistentRingBufferState states[2];    //!< Two copies of the mutable state, updated alternately
+
+        /** Calculate the checksum of the immutable header fields and the given state copy. */
+        uint32_t calculateChecksum(const PersistentRingBufferState& state) const {
+            uint32_t hash = 2166136261u;
+            const uint8_t* bytes = (const uint8_t*)this;
+            for (size_t i = 0; i < offsetof(PersistentRingBufferHeader, states); ++i) {
+                hash = (hash ^ bytes[i]) * 16777619u;
+            }
+            bytes = (const uint8_t*)&state;
+            for (size_t i = 0; i < offsetof(PersistentRingBufferState, checksum); ++i) {
+                hash = (hash ^ bytes[i]) * 16777619u;
+            }
+            return hash;
+        }
+    };
+
+
+    /**
+     *  Class encapsulating a ring buffer for elements of type T that is stored in a memory-mapped file.
+     *
+     *  The file consists of a small header followed by the element array. The header holds capacity and element
+     *  size, and two checksummed copies of the mutable state, i.e. write pointer and number of elements, together
+     *  with a generation counter. The element array has one more slot than the capacity, such that the slot at the
+     *  write pointer is never referenced by the current state. Each addition writes the element into this free slot
+     *  first, and then writes the new state into the other, non-current state copy with the next generation; the
+     *  current copy is not modified. If the process is terminated at any point, at least one state copy is valid and
+     *  references only completely written elements. After a restart, open() continues with the valid copy of the
+     *  higher generation and all elements in place; there is no serialization step. Removals are crash-safe in the same
+     *  way, see removeElements(). The operating system's page
+     *  cache writes modified pages back to the file; use flush() to force write back, e.g. to survive a power failure.
+     *
+     *  T must be trivially copyable, and the file is only portable between hosts of the same byte order.
+     */
+    template<class T> class PersistentRingBuffer {
+    protected:
+        MemoryMappedFile            file;
+        PersistentRingBufferHeader* header;
+        T*                          elements;
+        size_t                      capacity;
+        size_t                      current;    //!< Index of the current state copy
+        bool                        restored;
+
+        /** Check if the given state copy is valid for the capacity of this ring buffer. */
+        bool isValidState(const size_t i) const {
+            const PersistentRingBufferState& state = header->states[i];
+            return (state.write_pointer <= capacity &&
+                    state.number_of_elements <= capacity &&
+                    state.checksum == header->calculateChecksum(state));
+        }
+
+        /**
+         *  Write the given state into the non-current state copy and make it the current one.
+         *  @param write_pointer the new write pointer
+         *  @param number_of_elements the new number of elements
+         */
+        void commit(const size_t write_pointer, const size_t number_of_elements) {
+            const size_t next = 1 - current;
+            PersistentRingBufferState& state = header->states[next];
+            // element writes must not be reordered behind the state update
+            std::atomic_signal_fence(std::memory_order_release);
+            state.generation = header->states[current].generation + 1;
+            state.write_pointer = write_pointer;
+            state.number_of_elements = number_of_elements;
+            state.reserved = 0;
+            std::atomic_signal_fence(std::memory_order_release);
+            state.checksum = header->calculateChecksum(state);
+            current = next;
+        }
+
+        /** Get the current state copy. */
+        const PersistentRingBufferState& getState(void) const { return header->states[current]; }
+
+        /** Get the element slot index of the given ring buffer index, relative to the given slot index of the oldest element. */
+        size_t getSlot(const size_t head, const size_t i) const {
+            const size_t index = head + i;
+            return (index > capacity ? index - (capacity + 1) : index);
+        }
+
+    public:
+        /**
+         * Constructor; the ring buffer is not usable before open() succeeded.
+         */
+        PersistentRingBuffer(void) : header(NULL), elements(NULL), capacity(0), current(0), restored(false) {}
+
+        /**
+         *  Open the ring buffer file. If the file holds a valid header for the given capacity and element type,
+         *  all elements are restored; if one state copy fails its checksum, e.g. because the process was terminated
+         *  while updating it, the other copy is used. Otherwise the file is initialized as an empty ring buffer.
+         *  @param path the file path
+         *  @param new_capacity the maximum number of elements; it must be > 0
+         *  @return true on success, false otherwise
+         */
+        bool open(const std::string& path, const size_t new_capacity) {
+            close();
+            if (new_capacity == 0 || file.open(path, PersistentRingBufferHeader::data_offset + (new_capacity + 1) * sizeof(T)) == false) {
+                return false;
+            }
+            header = (PersistentRingBufferHeader*)file.getData();
+            elements = (T*)(file.getData() + PersistentRingBufferHeader::data_offset);
+            capacity = new_capacity;
+            current = 0;
+            if (header->magic == PersistentRingBufferHeader::magic_value &&
+                header->version == PersistentRingBufferHeader::version_value &&
+                header->element_size == sizeof(T) &&
+                header->capacity == capacity) {
+                const bool valid0 = isValidState(0);
+                const bool valid1 = isValidState(1);
+                restored = (valid0 || valid1);
+                current = (valid0 && valid1 ? (header->states[1].generation > header->states[0].generation ? 1 : 0) : (valid1 ? 1 : 0));
+            }
+            if (restored == false) {
+                header->magic = PersistentRingBufferHeader::magic_value;
+                header->version = PersistentRingBufferHeader::version_value;
+                header->element_size = sizeof(T);
+                header->reserved = 0;
+                header->capacity = capacity;
+                memset(header->states, 0, sizeof(header->states));
+                clear();
+            }
+            return true;
+        }
+
+        /**
+         *  Unmap and close the ring buffer file.
+         */
+        void close(void) {
+            file.close();
+            header = NULL;
+            elements = NULL;
+            capacity = 0;
+            current = 0;
+            restored = false;
+        }
+
+        /**
+         *  Force write back of modified pages to the file.
+         *  @param synchronous if true, wait until the pages are written to the storage device
+         *  @return true on success, false otherwise
+         */
+        bool flush(const bool synchronous) {
+            return file.flush(synchronous);
+        }
+
+        /** Check if the ring buffer file is open. */
+        bool isOpen(void) const { return header != NULL; }
+
+        /** Check if open() restored the content of an existing ring buffer file. */
+        bool isRestored(void) const { return restored; }
+
+        /**
+         *  Delete all elements from the ring buffer.
+         */
+        void clear(void) {
+            if (header != NULL) {
+                commit(0, 0);
+            }
+        }
+
+        /** Get maximum number of elements that can be stored in the ring buffer. */
+        size_t getMaximumNumberOfElements(void) const { return capacity; }
+
+        /** Get number of elements that are currently stored in the ring buffer. */
+        size_t getNumberOfElements(void) const { return (header != NULL ? (size_t)getState().number_of_elements : 0); }
+
+        /**
+         *  Add a new element to the ring buffer. If the buffer is full, the oldest element is replaced; it is
+         *  released by the state update, after the new element has been written into the free slot.
+         *  @param value the element value
+         */
+        void addNewElement(const T& value) {
+            if (header == NULL) {
+                return;
+            }
+            const PersistentRingBufferState& state = getState();
+            size_t write_pointer = (size_t)state.write_pointer;
+            const size_t n = (size_t)state.number_of_elements;
+            elements[write_pointer] = value;
+            if (++write_pointer > capacity) {
+                write_pointer = 0;
+            }
+            commit(write_pointer, (n < capacity ? n + 1 : capacity));
+        }
+
+        /**
+         *  Remove elements from the ring buffer. Non-existing elements are silently ignored.
+         *  Removing oldest or newest elements commits a single new state without touching any element. Removing
+         *  elements in the middle writes the remaining elements into the free slots following the newest element and
+         *  commits a single new state, if there are enough free slots; the current state does not reference these
+         *  slots, so the removal is atomic. Otherwise the shorter of the two remaining element ranges is moved in place:
+         *  a state without this range is committed first, then the range is moved into slots no longer referenced,
+         *  and then the final state is committed. If the process is terminated in between, the ring buffer holds the
+         *  longer remaining range only, i.e. a consecutive part of the measurements in order, never a torn element.
+         *  @param offs index of the first element to be removed
+         *  @param n number of elements to be removed
+         *  @return number of elements removed
+         */
+        size_t removeElements(const size_t offs, const size_t n) {
+            const size_t num = getNumberOfElements();
+            if (offs >= num || n == 0) {
+                return 0;
+            }
+            const size_t removed = (n < num - offs ? n : num - offs);
+            const size_t front = offs;
+            const size_t back = num - offs - removed;
+            const size_t write_pointer = (size_t)getState().write_pointer;
+            const size_t head = getSlot(write_pointer, capacity + 1 - num);
+            if (front == 0 || back == 0) {
+                commit(back == 0 ? getSlot(head, front) : write_pointer, front + back);
+            }
+            else if (front + back <= capacity + 1 - num) {
+                // copy all remaining elements into free slots
+                for (size_t i = 0; i < front + back; ++i) {
+                    elements[getSlot(write_pointer, i)] = elements[getSlot(head, (i < front ? i : i + removed))];
+                }
+                commit(getSlot(write_pointer, front + back), front + back);
+            }
+            else if (front < back) {
+                // drop the older range, then move it towards the newer range, newest element first
+                commit(write_pointer, back);
+                for (size_t i = front; i > 0; --i) {
+                    elements[getSlot(head, i - 1 + removed)] = elements[getSlot(head, i - 1)];
+                }
+                commit(write_pointer, front + back);
+            }
+            else {
+                // drop the newer range, then move it towards the older range, oldest element first
+                commit(getSlot(head, front), front);
+                for (size_t i = 0; i < back; ++i) {
+                    elements[getSlot(head, front + i)] = elements[getSlot(head, front + removed + i)];
+                }
+                commit(getSlot(head, front + back), front + back);
+            }
+            return removed;
+        }
+
+        /**
+         *  Get a reference to the element at the given ring buffer index position, where the index boundaries are not checked.
+         *  @param i ring buffer index, where i = 0 gets the oldest element and i = (getNumberOfElements()-1) gets the newest element.
+         *  @return reference to the element at ring buffer index
+         */
+        const T& at(const size_t i) const {
+            const PersistentRingBufferState& state = getState();
+            const size_t slots = capacity + 1;
+            const size_t write_pointer = (size_t)state.write_pointer;
+            const size_t n = (size_t)state.number_of_elements;
+            size_t index = (write_pointer >= n ? write_pointer - n : write_pointer + slots - n) + i;
+            if (index >= slots) {
+                index -= slots;
+            }
+            return elements[index];
+        }
+
+        /**
+         *  Get a reference to the element at the given ring buffer index position.
+         *  @param i ring buffer index, where i = 0 gets the oldest element and i = (getNumberOfElements()-1) gets the newest element.
+         *  @return reference to the element at ring buffer index; if the index is out of bounds, RingBuffer<T>::getIndexOutOfBoundsElement() is returned.
+         */
+        const T& operator[](const size_t i) const {
+            return (i < getNumberOfElements() ? at(i) : RingBuffer<T>::getIndexOutOfBoundsElement());
+        }
+
+        /** Get a reference to the newest element in the ring buffer. */
+        const T& getNewestElement(void) const { return operator[](getNumberOfElements() - 1); }
+
+        /** Get a reference to the oldest element in the ring buffer. */
+        const T& getOldestElement(void) const { return operator[](0); }
+    };
+
+}   // namespace libspeedwire
+
+#endif
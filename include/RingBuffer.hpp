@@ -1,12 +1,34 @@
 #ifndef __LIBSPEEDWIRE_RINGBUFFER_HPP__
 #define __LIBSPEEDWIRE_RINGBUFFER_HPP__
 
+#include <cstddef>
 #include <vector>
+#include <algorithm>
 
 namespace libspeedwire {
 
+    /**
+     *  Class encapsulating a contiguous range of ring buffer elements.
+     *  The elements of a ring buffer are stored in at most two such ranges; the first range holds the
+     *  oldest elements, the second range holds the elements that wrapped around to the start of the data vector.
+     */
+    template<class T> class RingBufferSpan {
+    public:
+        const T* data;      //!< Pointer to the first element of the range
+        size_t   size;      //!< Number of elements in the range
+
+        RingBufferSpan(const T* const d, const size_t s) : data(d), size(s) {}
+
+        const T* begin(void) const { return data; }
+        const T* end(void) const { return data + size; }
+        const T& operator[](const size_t i) const { return data[i]; }
+    };
+
+
     /**
      *  Class encapsulating a ring buffer for elements of type T.
+     *  The element storage is pre-allocated with exactly the requested capacity; adding elements does not
+     *  allocate memory and the position of an element is derived from the write pointer and the number of elements.
      */
     template<class T> class RingBuffer {
     public:
@@ -15,17 +37,16 @@ namespace libspeedwire {
         using const_reference = const T&;
         using size_type = size_t;
 
-        std::vector<T>  data_vector;    //!< Array of ring buffer elements
-        std::vector<T*> ref_vector;     //!< Array of references to ring buffer elements, it is twice as big as the array of ring buffer elements and provides contiguous access to elements without wrap around
-        size_t          write_pointer;  //!< Write pointer pointing to the next element to write to
+        std::vector<T>  data_vector;        //!< Array of ring buffer elements, its size is the capacity of the ring buffer
+        size_t          write_pointer;      //!< Write pointer pointing to the next element to write to
+        size_t          number_of_elements; //!< Number of elements currently stored in the ring buffer
 
         /**
          * Constructor.
          * @param capacity Maximum number of ring buffer elements
          */
         RingBuffer(const size_t capacity) :
-            data_vector(capacity),
-            ref_vector(2*capacity) {
+            data_vector(capacity) {
             clear();
         }
 
@@ -33,8 +54,8 @@ namespace libspeedwire {
          *  Delete all elements from the ring buffer.
          */
         void clear(void) {
-            data_vector.clear();
             write_pointer = 0;
+            number_of_elements = 0;
         }
 
         /**
@@ -42,7 +63,7 @@ namespace libspeedwire {
          *  @return the maximum number
          */
         size_t getMaximumNumberOfElements(void) const {
-            return data_vector.capacity();
+            return data_vector.size();
         }
 
         /**
@@ -52,8 +73,7 @@ namespace libspeedwire {
          */
         void setMaximumNumberOfElements(const size_t new_capacity) {
             clear();
-            data_vector.reserve(new_capacity);
-            ref_vector.reserve(2 * new_capacity);
+            data_vector.resize(new_capacity);
         }
 
         /**
@@ -61,62 +81,86 @@ namespace libspeedwire {
          *  @return the number
          */
         size_t getNumberOfElements(void) const {
-            return data_vector.size();
+            return number_of_elements;
         }
 
         /**
          *  Add a new element to the ring buffer. If the buffer is full, the oldest element is replaced.
+         *  A ring buffer with a maximum number of 0 elements is resized to hold a single element.
          *  @param value the element value
          */
         void addNewElement(const T &value) {
-            if (data_vector.size() > write_pointer) {
-                data_vector[write_pointer] = value;
-            }
-            else {
-                data_vector.push_back(value);
-                // during the initial ring buffer fill-up, update references to data elements
-                ref_vector.resize(data_vector.size() * 2, NULL);
-                for (size_t i = 0; i < data_vector.size(); ++i) {
-                    ref_vector.data()[i] = ref_vector.data()[i + data_vector.size()] = &data_vector.data()[i];
-                }
+            size_t capacity = data_vector.size();
+            if (capacity == 0) {
+                data_vector.resize(1);
+                capacity = 1;
             }
-            if (++write_pointer >= data_vector.capacity()) {
+            data_vector[write_pointer] = value;
+            if (++write_pointer >= capacity) {
                 write_pointer = 0;
             }
+            if (number_of_elements < capacity) {
+                ++number_of_elements;
+            }
         }
 
         /**
          *  Remove elements from the ring buffer. Non-existing elements are silently ignored.
+         *  Removing oldest or newest elements is O(1); removing elements in the middle moves the shorter
+         *  of the two remaining element ranges in at most two contiguous block copies. If moving the shorter
+         *  range needs three block copies, because both its source and destination wrap around, the longer
+         *  range is moved instead; its source and destination cannot both wrap around in this case.
          *  @param offs index of the first element to be removed
          *  @param n number of elements to be removed
          *  @return number of elements removed
          */
         size_t removeElements(const size_t offs, const size_t n) {
-            const size_t data_vector_size = data_vector.size();
-            std::vector<T> temp;
-            temp.reserve(data_vector_size >= n ? data_vector_size - n : 0);
-            for (size_t i = 0; i < offs && i < data_vector_size; ++i) {
-                temp.push_back(at(i));
-            }
-            for (size_t i = offs + n; i < data_vector_size; ++i) {
-                temp.push_back(at(i));
+            if (offs >= number_of_elements) {
+                return 0;
             }
-            clear();
-            const size_t temp_size = temp.size();
-            for (const auto& el : temp) {
-                data_vector.push_back(el);
+            const size_t removed = (n < number_of_elements - offs ? n : number_of_elements - offs);
+            const size_t front = offs;
+            const size_t back = number_of_elements - offs - removed;
+            // ring buffer index of the element stored at data vector index 0
+            const size_t wrap = data_vector.size() - getHeadIndex();
+            const bool front_wraps_twice = (removed < wrap && wrap < front);
+            const bool back_wraps_twice = (offs + removed < wrap && wrap < number_of_elements - removed);
+            if ((front < back && front_wraps_twice == false) || back_wraps_twice == true) {
+                // move the older elements towards the newer ones; the head index follows implicitly
+                moveElementsBackward(removed, 0, front);
             }
-            write_pointer = (temp_size >= data_vector.capacity() ? 0 : temp_size);
-            for (size_t i = 0; i < temp_size; ++i) {
-                ref_vector.data()[i] = ref_vector.data()[i + temp_size] = &data_vector.data()[i];
+            else {
+                // move the newer elements towards the older ones and withdraw the write pointer
+                moveElementsForward(offs, offs + removed, back);
+                write_pointer = (write_pointer >= removed ? write_pointer - removed : write_pointer + data_vector.size() - removed);
             }
-            return data_vector_size - temp_size;
+            number_of_elements -= removed;
+            return removed;
+        }
+
+        /**
+         *  Remove the given number of oldest elements from the ring buffer in O(1).
+         *  @param n number of elements to be removed
+         *  @return number of elements removed
+         */
+        size_t removeOldestElements(const size_t n) {
+            return removeElements(0, n);
+        }
+
+        /**
+         *  Remove the given number of newest elements from the ring buffer in O(1).
+         *  @param n number of elements to be removed
+         *  @return number of elements removed
+         */
+        size_t removeNewestElements(const size_t n) {
+            const size_t removed = (n < number_of_elements ? n : number_of_elements);
+            return removeElements(number_of_elements - removed, removed);
         }
 
         /**
          *  Get a reference to the element at the given ring buffer index position.
          *  @param i ring buffer index, where i = 0 gets the oldest element and i = (getNumberOfElements()-1) gets the newest element.
-         *  @return reference to the element at ring buffer index; if the index is out of bounds, reference getIndexOutOfBoundsElement() is returned. 
+         *  @return reference to the element at ring buffer index; if the index is out of bounds, reference getIndexOutOfBoundsElement() is returned.
          */
         const T& operator[](const size_t i) const {
             const size_t index = getDataVectorIndex(i);
@@ -130,10 +174,14 @@ namespace libspeedwire {
          *  Get a reference to the element at the given ring buffer index position, where the index boundaries are not checked for efficiency reasons.
          *  This method must only be used whenever index boundaries are guarantied to stay within 0 ... (getNumberOfElements()-1).
          *  @param i ring buffer index, where i = 0 gets the oldest element and i = (getNumberOfElements()-1) gets the newest element.
-         *  @return reference to the element at ring buffer index; if the index is out of bounds, reference getIndexOutOfBoundsElement() is returned.
+         *  @return reference to the element at ring buffer index
          */
         const T& at(const size_t i) const {
-            return *(ref_vector.data()[write_pointer + i]);
+            size_t index = getHeadIndex() + i;
+            if (index >= data_vector.size()) {
+                index -= data_vector.size();
+            }
+            return data_vector[index];
         }
 
         /**
@@ -141,7 +189,7 @@ namespace libspeedwire {
          *  @return reference to the newest element; if the ring buffer is empty, reference getIndexOutOfBoundsElement() is returned.
          */
         const T& getNewestElement(void) const {
-            return operator[](data_vector.size() - 1);
+            return operator[](number_of_elements - 1);
         }
 
         /**
@@ -152,12 +200,66 @@ namespace libspeedwire {
             return operator[](0);
         }
 
+        /**
+         *  Get the contiguous range of the oldest elements in the ring buffer.
+         *  Iterating the first span and then the second span visits all elements from oldest to newest.
+         *  @return the first span; it is empty if the ring buffer is empty.
+         */
+        RingBufferSpan<T> getFirstSpan(void) const {
+            const size_t head = getHeadIndex();
+            const size_t size = data_vector.size() - head;
+            return RingBufferSpan<T>(data_vector.data() + head, (number_of_elements < size ? number_of_elements : size));
+        }
+
+        /**
+         *  Get the contiguous range of the newest elements in the ring buffer that wrapped around to the start of the data vector.
+         *  @return the second span; it is empty if the elements do not wrap around.
+         */
+        RingBufferSpan<T> getSecondSpan(void) const {
+            const size_t size = data_vector.size() - getHeadIndex();
+            return RingBufferSpan<T>(data_vector.data(), (number_of_elements > size ? number_of_elements - size : 0));
+        }
+
+        /**
+         *  Get the contiguous range of the older part of the given subset of elements in the ring buffer.
+         *  @param offs ring buffer index of the first element of the subset
+         *  @param n number of elements in the subset; it is clipped to the number of elements available
+         *  @return the first span of the subset
+         */
+        RingBufferSpan<T> getFirstSpan(const size_t offs, const size_t n) const {
+            if (offs >= number_of_elements) {
+                return RingBufferSpan<T>(data_vector.data(), 0);
+            }
+            const size_t index = getDataVectorIndex(offs);
+            const size_t count = (n < number_of_elements - offs ? n : number_of_elements - offs);
+            const size_t size = data_vector.size() - index;
+            return RingBufferSpan<T>(data_vector.data() + index, (count < size ? count : size));
+        }
+
+        /**
+         *  Get the contiguous range of the newer part of the given subset of elements in the ring buffer that wrapped
+         *  around to the start of the data vector.
+         *  @param offs ring buffer index of the first element of the subset
+         *  @param n number of elements in the subset; it is clipped to the number of elements available
+         *  @return the second span of the subset; it is empty if the subset does not wrap around.
+         */
+        RingBufferSpan<T> getSecondSpan(const size_t offs, const size_t n) const {
+            if (offs >= number_of_elements) {
+                return RingBufferSpan<T>(data_vector.data(), 0);
+            }
+            const size_t index = getDataVectorIndex(offs);
+            const size_t count = (n < number_of_elements - offs ? n : number_of_elements - offs);
+            const size_t size = data_vector.size() - index;
+            return RingBufferSpan<T>(data_vector.data(), (count > size ? count - size : 0));
+        }
+
         //
         //  Methods exposing the internal representation
         //
 
         /**
          *  Get a reference to the underlying element array.
+         *  The array always holds getMaximumNumberOfElements() entries, including entries not yet written.
          *  @return reference to array
          */
         const std::vector<T>& getDataVector(void) const {
@@ -179,11 +281,10 @@ namespace libspeedwire {
          *  @return the data vector index, (size_t)-1 in case of index out of bounds condition.
          */
         size_t getDataVectorIndex(const size_t ring_buffer_index) const {
-            const size_t size = data_vector.size();
-            if (ring_buffer_index < size) {
-                size_t index = write_pointer + ring_buffer_index;
-                if (index >= size) {
-                    index -= size;
+            if (ring_buffer_index < number_of_elements) {
+                size_t index = getHeadIndex() + ring_buffer_index;
+                if (index >= data_vector.size()) {
+                    index -= data_vector.size();
                 }
                 return index;
             }
@@ -196,13 +297,12 @@ namespace libspeedwire {
          *  @return the ring buffer index, (size_t)-1 in case of index out of bounds condition.
          */
         size_t getRingBufferIndex(const size_t data_vector_index) const {
-            const size_t size = data_vector.size();
-            if (data_vector_index < size) {
-                size_t index = data_vector_index - write_pointer;
-                if (index >= size) {    // modulo arithmetic!
-                    index += size;
+            if (data_vector_index < data_vector.size()) {
+                const size_t head = getHeadIndex();
+                const size_t index = (data_vector_index >= head ? data_vector_index - head : data_vector_index + data_vector.size() - head);
+                if (index < number_of_elements) {
+                    return index;
                 }
-                return index;
             }
             return (size_t)-1;
         }
@@ -216,7 +316,7 @@ namespace libspeedwire {
          *  @return reference to the index out of bound element.
          */
         static const T& getIndexOutOfBoundsElement(void) {
-            static const T el;
+            static const T el = T();
             return el;
         }
 
@@ -228,6 +328,45 @@ namespace libspeedwire {
             const T& indexOutOfBoundsElement = getIndexOutOfBoundsElement();
             return (&element == &indexOutOfBoundsElement);
         }
+
+    protected:
+
+        /**
+         *  Copy n elements starting at ring buffer index src to ring buffer index dst, where dst < src.
+         *  The copy proceeds from oldest to newest in contiguous blocks split at the wrap around point.
+         */
+        void moveElementsForward(size_t dst, size_t src, size_t n) {
+            const size_t capacity = data_vector.size();
+            while (n > 0) {
+                const size_t dst_index = getDataVectorIndex(dst);
+                const size_t src_index = getDataVectorIndex(src);
+                const size_t len = std::min(n, std::min(capacity - dst_index, capacity - src_index));
+                std::copy(data_vector.begin() + src_index, data_vector.begin() + src_index + len, data_vector.begin() + dst_index);
+                dst += len; src += len; n -= len;
+            }
+        }
+
+        /**
+         *  Copy n elements starting at ring buffer index src to ring buffer index src + shift.
+         *  The copy proceeds from newest to oldest in contiguous blocks split at the wrap around point.
+         */
+        void moveElementsBackward(const size_t shift, const size_t src, size_t n) {
+            while (n > 0) {
+                const size_t dst_end = getDataVectorIndex(src + shift + n - 1) + 1;
+                const size_t src_end = getDataVectorIndex(src + n - 1) + 1;
+                const size_t len = std::min(n, std::min(dst_end, src_end));
+                std::copy_backward(data_vector.begin() + src_end - len, data_vector.begin() + src_end, data_vector.begin() + dst_end);
+                n -= len;
+            }
+        }
+
+        /**
+         *  Get the data vector index of the oldest element.
+         *  @return the data vector index
+         */
+        size_t getHeadIndex(void) const {
+            return (write_pointer >= number_of_elements ? write_pointer - number_of_elements : write_pointer + data_vector.size() - number_of_elements);
+        }
     };
 
 }   // namespace libspeedwire
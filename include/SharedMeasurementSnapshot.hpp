@@ -0,0 +1,134 @@
+#ifndef __LIBSPEEDWIRE_SHAREDMEASUREMENTSNAPSHOT_HPP__
+#define __LIBSPEEDWIRE_SHAREDMEASUREMENTSNAPSHOT_HPP__
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <Consumer.hpp>
+#include <MeasurementValues.hpp>
+#include <MemoryMappedFile.hpp>
+
+namespace libspeedwire {
+
+    /**
+     *  Class encapsulating the header of a shared measurement snapshot region.
+     */
+    class SharedSnapshotHeader {
+    public:
+        static const uint32_t magic_value = 0x53535753;     //!< "SWSS" in little endian byte order
+        static const uint32_t version_value = 2;
+
+        uint32_t magic;                 //!< Magic number identifying the region format; written last by the publisher
+        uint32_t version;               //!< Region format version
+        uint32_t number_of_slots;       //!< Number of slots in the open addressing slot table
+        uint32_t ring_size;             //!< Number of history entries per slot
+        uint32_t slot_size;             //!< Size of each slot in bytes, including its history ring
+        uint32_t generation;            //!< Incremented each time a publisher initializes the region
+        uint32_t reserved[2];
+    };
+
+
+    /**
+     *  Class encapsulating a single entry of a slot history ring.
+     */
+    class SharedSnapshotEntry {
+    public:
+        double   value;                 //!< Measurement value
+        uint32_t time;                  //!< Measurement time; ms for emeter and s for inverter devices
+        uint32_t reserved;
+    };
+
+
+    /**
+     *  Class encapsulating a slot of a shared measurement snapshot region, i.e. the latest value of a single
+     *  (device, measurement) series followed by a ring of its most recent values.
+     *
+     *  Each slot is protected by a seqlock: the publisher increments the sequence number to an odd value before
+     *  modifying the slot and to an even value afterwards. Readers copy the slot and retry if the sequence number
+     *  was odd or changed during the copy.
+     */
+    class SharedSnapshotSlot {
+    public:
+        std::atomic<uint32_t> sequence;     //!< Seqlock sequence number
+        uint32_t used;                      //!< Non-zero if the slot is in use
+        uint32_t serial_number;             //!< Device serial number
+        uint32_t key;                       //!< ObisData::toKey() or SpeedwireData::toKey() of the measurement
+        uint32_t ring_write_pointer;        //!< Next write position in the history ring
+        uint32_t ring_count;                //!< Number of valid history entries
+        SharedSnapshotEntry latest;         //!< Latest measurement value and time
+        // followed by ring_size SharedSnapshotEntry instances
+
+        /** Get a pointer to the history ring of this slot. */
+        SharedSnapshotEntry* getRing(void) { return (SharedSnapshotEntry*)(this + 1); }
+        const SharedSnapshotEntry* getRing(void) const { return (const SharedSnapshotEntry*)(this + 1); }
+    };
+
+
+    /**
+     *  Class SharedMeasurementPublisher publishes the latest measurement values of all devices into a shared memory
+     *  region, such that other processes on the same host can read them lock-free with a SharedMeasurementReader.
+     *
+     *  The region is a memory-mapped file, e.g. below /dev/shm on Linux. It holds a fixed size open addressing
+     *  table of slots keyed by device serial number and measurement key; each slot is protected by its own seqlock.
+     *  There must be a single publisher per region.
+     */
+    class SharedMeasurementPublisher : public ObisConsumer, public ObisFrameConsumer, public SpeedwireConsumer {
+    protected:
+        MemoryMappedFile      file;
+        SharedSnapshotHeader* header;
+
+        SharedSnapshotSlot* findSlot(const uint32_t serial_number, const uint32_t key, const bool insert);
+
+    public:
+        SharedMeasurementPublisher(void);
+
+        bool open(const std::string& path, const uint32_t number_of_slots, const uint32_t ring_size);
+        void close(void);
+
+        bool publish(const uint32_t serial_number, const uint32_t key, const double value, const uint32_t time);
+
+        virtual void consume(const SpeedwireDevice& device, ObisData& element);
+        virtual void consume(const SpeedwireDevice& device, const ObisDataFrame& frame);
+        virtual void consume(const SpeedwireDevice& device, SpeedwireData& element);
+    };
+
+
+    /**
+     *  Class SharedMeasurementReader reads measurement values from a shared memory region maintained by a
+     *  SharedMeasurementPublisher, possibly running in another process. Reading is lock-free and never blocks
+     *  the publisher.
+     *
+     *  The region is mapped read-only. Its geometry is copied at open(), such that the reader never indexes beyond
+     *  its mapping, even if a restarted publisher re-initializes the region with a larger slot table. A
+     *  re-initialization is detected by the region generation on each read; the reader must then be re-opened.
+     */
+    class SharedMeasurementReader {
+    protected:
+        MemoryMappedFile            file;
+        const SharedSnapshotHeader* header;
+        uint32_t                    number_of_slots;    //!< Number of slots at open()
+        uint32_t                    ring_size;          //!< Number of history entries per slot at open()
+        uint32_t                    slot_size;          //!< Size of each slot in bytes at open()
+        uint32_t                    generation;         //!< Region generation at open()
+
+        const SharedSnapshotSlot* findSlot(const uint32_t serial_number, const uint32_t key) const;
+
+    public:
+        SharedMeasurementReader(void);
+
+        bool open(const std::string& path);
+        void close(void);
+
+        /** Check if a valid region is mapped. */
+        bool isOpen(void) const { return header != NULL; }
+
+        bool isCurrent(void) const;
+
+        bool read(const uint32_t serial_number, const uint32_t key, TimestampDoublePair& result) const;
+        size_t readHistory(const uint32_t serial_number, const uint32_t key, std::vector<TimestampDoublePair>& result) const;
+    };
+
+}   // namespace libspeedwire
+
+#endif
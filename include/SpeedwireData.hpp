@@ -90,6 +90,39 @@ namespace libspeedwire {
     };
 
 
+    /**
+     *  Class providing a lightweight view onto a raw data element inside a speedwire inverter reply packet.
+     *
+     *  In contrast to SpeedwireRawData, the payload is not copied; the data pointer refers directly into the packet
+     *  buffer and is only valid as long as the packet buffer is valid.
+     */
+    class SpeedwireRawDataView {
+    public:
+        Command  command;           //!< command code
+        uint32_t id;                //!< register id
+        uint8_t  conn;              //!< connector id (mpp #1, mpp #2, ac #1)
+        SpeedwireDataType type;     //!< type
+        time_t   time;              //!< timestamp
+        const uint8_t* data;        //!< pointer to the payload data inside the packet buffer
+        size_t   data_size;         //!< payload data size in bytes
+
+        /** Return key for this instance. The key is formed by combining id and conn.
+         *  @return The key for this instance
+         */
+        uint32_t toKey(void) const { return id | conn; }
+
+        /** Get the payload size limited to the payload capacity of SpeedwireRawData; payload bytes beyond are never interpreted.
+         *  @return The payload size in bytes
+         */
+        size_t getPayloadSize(void) const { return (data_size < sizeof(SpeedwireRawData::data) ? data_size : sizeof(SpeedwireRawData::data)); }
+
+        /** Create a SpeedwireRawData instance holding a copy of the viewed data.
+         *  @return The SpeedwireRawData instance
+         */
+        SpeedwireRawData toRawData(void) const { return SpeedwireRawData(command, id, conn, type, time, data, data_size); }
+    };
+
+
     /**
      *  Wrapper class to simplify access to SpeedwireRawData of type Unsigned32
      */
@@ -353,6 +386,10 @@ namespace libspeedwire {
         SpeedwireData(void);
 
         bool consume(const SpeedwireRawData& data);
+        bool consume(const SpeedwireRawDataView& data);
+        bool matches(const SpeedwireRawData& data) const;
+        bool matches(const SpeedwireRawDataView& data) const;
+        bool consumeValue(const uint8_t* const data, const size_t data_size, const time_t data_time);
 
         std::string toString(void) const;
 
@@ -452,6 +489,10 @@ namespace libspeedwire {
         static const SpeedwireData YieldByMinute;                  //!< Energy yield in 5 minute intervals
         static const SpeedwireData YieldByDay;                     //!< Energy yield in 24 hour intervals
         static const SpeedwireData Event;                          //!< Device event
+
+
+    protected:
+        bool matches(const Command command, const uint32_t id, const uint8_t conn, const SpeedwireDataType type) const;
     };
 
 
@@ -504,6 +545,39 @@ namespace libspeedwire {
         static SpeedwireDataMap &getGlobalMap(void);
     };
 
+
+    /**
+     *  Class implementing a compact, immutable lookup index for speedwire inverter reply data definitions.
+     *
+     *  The index holds its own copy of the given SpeedwireData definitions and a sorted array of keys, which is
+     *  searched by binary search. Pointers returned by find() remain valid for the lifetime of the index.
+     *  Battery definitions with connector id 0x7 are often identical to inverter definitions with connector id 0x1;
+     *  if there is no explicit definition for connector id 0x7, the index contains an alias entry pointing to the
+     *  definition for connector id 0x1, such that both are resolved by a single lookup.
+     */
+    class SpeedwireDataIndex {
+    protected:
+        std::vector<SpeedwireData>        elements;     //!< Immutable copy of all definitions
+        std::vector<uint32_t>             keys;         //!< Sorted array of keys, including alias keys
+        std::vector<const SpeedwireData*> entries;      //!< Definitions in the same order as keys
+
+    public:
+        SpeedwireDataIndex(const std::vector<SpeedwireData>& definitions);
+
+        const SpeedwireData* find(const uint32_t key) const;
+
+        /** Find the definition for the given raw data element.
+         *  @param raw_data The raw data element
+         *  @return Pointer to the definition or NULL if there is no definition
+         */
+        const SpeedwireData* find(const SpeedwireRawData& raw_data) const { return find(raw_data.toKey()); }
+
+        /** Get the number of keys in the index, including alias keys. */
+        size_t size(void) const { return keys.size(); }
+
+        static const SpeedwireDataIndex& getPredefinedIndex(void);
+    };
+
 }   // namespace libspeedwire
 
 #endif
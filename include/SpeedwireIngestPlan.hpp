@@ -0,0 +1,69 @@
+#ifndef __LIBSPEEDWIRE_SPEEDWIREINGESTPLAN_HPP__
+#define __LIBSPEEDWIRE_SPEEDWIREINGESTPLAN_HPP__
+
+#include <cstdint>
+#include <vector>
+#include <SpeedwireCommand.hpp>
+#include <SpeedwireData.hpp>
+#include <SpeedwireInverterProtocol.hpp>
+
+namespace libspeedwire {
+
+    /**
+     *  Class SpeedwireIngestPlan maps the element positions of an inverter reply to destination SpeedwireData
+     *  instances in a SpeedwireDataMap.
+     *
+     *  Inverter replies for a given command and register range always contain the same sequence of registers. The plan
+     *  is built from the first reply by looking up each register in the map; subsequent replies are applied by a linear
+     *  pass over the reply, comparing the key and type of each element with the plan. If a reply does not match the
+     *  plan, the plan is rebuilt.
+     *
+     *  The plan holds pointers to SpeedwireData instances inside the map; it must be rebuilt or discarded whenever
+     *  elements are removed from the map.
+     */
+    class SpeedwireIngestPlan {
+    protected:
+        Command                     command;            //!< Command id of the inverter reply
+        uint32_t                    firstRegisterID;    //!< First register id of the inverter reply
+        uint32_t                    lastRegisterID;     //!< Last register id of the inverter reply
+        std::vector<uint32_t>       keys;               //!< Expected key for each element position
+        std::vector<SpeedwireDataType> types;           //!< Expected type for each element position
+        std::vector<SpeedwireData*> slots;              //!< Destination for each element position, NULL if there is none
+
+    public:
+        SpeedwireIngestPlan(const Command command, const uint32_t first_register_id, const uint32_t last_register_id);
+
+        bool matches(const SpeedwireInverterProtocol& reply) const;
+        void build(const SpeedwireInverterProtocol& reply, SpeedwireDataMap& map);
+        size_t apply(const SpeedwireInverterProtocol& reply, SpeedwireDataMap& map, std::vector<SpeedwireData*>& consumed);
+
+        /** Get the number of element positions in this plan. */
+        size_t size(void) const { return keys.size(); }
+    };
+
+
+    /**
+     *  Class SpeedwireIngest implements the bulk ingestion of inverter replies into a SpeedwireDataMap.
+     *
+     *  For each combination of command id, first and last register id, an ingest plan is created on first use and
+     *  applied to all subsequent replies.
+     */
+    class SpeedwireIngest {
+    protected:
+        SpeedwireDataMap&                map;           //!< Reference to the destination map
+        std::vector<SpeedwireIngestPlan> plans;         //!< Ingest plans for all known replies
+        std::vector<SpeedwireData*>      consumed;      //!< SpeedwireData instances updated by the most recent reply
+
+    public:
+        SpeedwireIngest(SpeedwireDataMap& map);
+
+        size_t ingest(const SpeedwireInverterProtocol& reply);
+        void invalidate(void);
+
+        /** Get the SpeedwireData instances that have been updated by the most recent call to ingest(). */
+        const std::vector<SpeedwireData*>& getConsumedElements(void) const { return consumed; }
+    };
+
+}   // namespace libspeedwire
+
+#endif
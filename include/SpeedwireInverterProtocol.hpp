@@ -68,6 +68,49 @@ namespace libspeedwire {
         unsigned long size;
 
     public:
+        /**
+         *  Forward iterator over all raw data elements in an inverter packet, yielding SpeedwireRawDataView instances.
+         */
+        class RawDataIterator {
+        protected:
+            const SpeedwireInverterProtocol* protocol;  //!< Pointer to the inverter packet
+            const void* element;                        //!< Pointer to the current raw data element, or NULL at the end
+            uint32_t length;                            //!< Length of each raw data element
+
+        public:
+            /** Constructor. */
+            RawDataIterator(const SpeedwireInverterProtocol* protocol, const void* element, const uint32_t length) : protocol(protocol), element(element), length(length) {}
+
+            /** Get a view onto the current raw data element. */
+            SpeedwireRawDataView operator*(void) const { return protocol->getRawDataView(element, length); }
+
+            /** Advance to the next raw data element. */
+            RawDataIterator& operator++(void) { element = protocol->getNextRawDataElement(element, length); return *this; }
+
+            /** Compare two iterators. */
+            bool operator==(const RawDataIterator& rhs) const { return element == rhs.element; }
+            bool operator!=(const RawDataIterator& rhs) const { return element != rhs.element; }
+        };
+
+        /**
+         *  Range of all raw data elements in an inverter packet, suitable for range-based for loops.
+         */
+        class RawDataRange {
+        protected:
+            const SpeedwireInverterProtocol* protocol;  //!< Pointer to the inverter packet
+            uint32_t length;                            //!< Length of each raw data element
+
+        public:
+            /** Constructor. */
+            RawDataRange(const SpeedwireInverterProtocol* protocol, const uint32_t length) : protocol(protocol), length(length) {}
+
+            /** Get an iterator to the first raw data element. */
+            RawDataIterator begin(void) const { return RawDataIterator(protocol, (length > 0 ? protocol->getFirstRawDataElement() : NULL), length); }
+
+            /** Get an iterator past the last raw data element. */
+            RawDataIterator end(void) const { return RawDataIterator(protocol, NULL, length); }
+        };
+
         //SpeedwireInverterProtocol(const void* const udp_packet, const unsigned long udp_packet_size);
         SpeedwireInverterProtocol(const SpeedwireHeader& prot);
         SpeedwireInverterProtocol(const SpeedwireData2Packet& data2_packet);
@@ -95,6 +138,8 @@ namespace libspeedwire {
         SpeedwireRawData getRawData(const void* const current, uint32_t length) const;
         SpeedwireRawData getRawTimelineData(const void* const current, uint32_t length, const SpeedwireDataType& data_type) const;
         SpeedwireRawData getRawConnector0Data(const void* const current, uint32_t length, const SpeedwireDataType& data_type) const;
+        SpeedwireRawDataView getRawDataView(const void* const current, uint32_t length) const;
+        RawDataRange getRawDataViews(void) const;
         std::vector<SpeedwireRawData> getRawDataElements(void) const;
         std::string toString(void) const;
 
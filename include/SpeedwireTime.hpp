@@ -6,6 +6,12 @@
 
 namespace libspeedwire {
 
+    //! Time base of the 32-bit timestamps stored in a MeasurementValues instance.
+    enum class MeasurementTimeBase : uint8_t {
+        EMETER_MS   = 0,    //!< Timestamps are the 32 least significant bits of the unix epoch time in milliseconds.
+        INVERTER_S  = 1     //!< Timestamps are the 32 least significant bits of the unix epoch time in seconds.
+    };
+
     /**
      *  Class implementing speedwire timer related accessors and conversions.
      */
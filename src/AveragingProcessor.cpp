@@ -4,6 +4,11 @@
 #include <Producer.hpp>
 using namespace libspeedwire;
 
+// calculate the preferred slot index of the given device address; the number of slots is a power of two
+static inline size_t hashAddress(const SpeedwireAddress& address, const size_t number_of_slots) {
+    return ((address.serialNumber * 0x9E3779B1u) ^ (address.susyID * 0x85EBCA6Bu)) & (number_of_slots - 1);
+}
+
 
 /**
  * Constructor of the AveragingProcessor instance.
@@ -11,7 +16,10 @@ using namespace libspeedwire;
  */
 AveragingProcessor::AveragingProcessor(const unsigned long averaging_time_obis_data, const unsigned long averaging_time_speedwire_data) :
     averagingTimeObisData(averaging_time_obis_data),
-    averagingTimeSpeedwireData(averaging_time_speedwire_data) {}
+    averagingTimeSpeedwireData(averaging_time_speedwire_data),
+    lastStateIndex(-1),
+    aggregationWindowTime(0),
+    aggregationHopTime(0) {}
 
 
 /**
@@ -22,13 +30,13 @@ AveragingProcessor::~AveragingProcessor(void) {}
 
 /**
  * Initialize/add a block of state keeping variables for averaging measurement value of the given device.
- * @param serial_number The serial number of the device.
+ * @param address The address of the device.
  * @param device_type The device identifier.
  * @return Index of the newly initialized/added variable block in vector states.
  */
-int AveragingProcessor::initializeState(const uint32_t serial_number, const DeviceType& device_type) {
+int AveragingProcessor::initializeState(const SpeedwireAddress& address, const DeviceType& device_type) {
     AveragingState device_state;
-    device_state.serialNumber            = serial_number;
+    device_state.address                 = address;
     device_state.deviceType              = device_type;
     device_state.remainder               = 0;
     device_state.currentTimestamp        = 0;
@@ -42,19 +50,55 @@ int AveragingProcessor::initializeState(const uint32_t serial_number, const Devi
         device_state.averagingTime = averagingTimeSpeedwireData / 1000;
     }
     states.push_back(device_state);
-    return (int)states.size() - 1;
+    const int index = (int)states.size() - 1;
+
+    // keep the hash table at most half full
+    if (2 * states.size() > stateTable.size()) {
+        stateTable.assign(stateTable.size() > 0 ? 2 * stateTable.size() : 16, -1);
+        for (int i = 0; i < (int)states.size(); ++i) {
+            insertStateIndex(i);
+        }
+    }
+    else {
+        insertStateIndex(index);
+    }
+    lastStateIndex = index;
+    return index;
 }
 
 
 /**
- * Find block of state keeping variables for averaging measurement value of the given device.
- * @param serial_number The serial number of the device.
+ * Insert the given state index into the hash table using linear probing.
+ * @param index Index of the variable block in vector states.
+ */
+void AveragingProcessor::insertStateIndex(const int index) {
+    const size_t mask = stateTable.size() - 1;
+    size_t slot = hashAddress(states[index].address, stateTable.size());
+    while (stateTable[slot] >= 0) {
+        slot = (slot + 1) & mask;
+    }
+    stateTable[slot] = index;
+}
+
+
+/**
+ * Find block of state keeping variables for averaging measurement value of the given device. Consecutive calls
+ * usually refer to the same device, therefore the most recently found state is checked first.
+ * @param address The address of the device.
  * @return Index of the variable block in vector states, or -1 if there is none.
  */
-int AveragingProcessor::findStateIndex(const uint32_t serial_number) {
-    for (int i = 0; i < states.size(); i++) {
-        if (states[i].serialNumber == serial_number) {
-            return i;
+int AveragingProcessor::findStateIndex(const SpeedwireAddress& address) {
+    if (lastStateIndex >= 0 && states[lastStateIndex].address == address) {
+        return lastStateIndex;
+    }
+    if (stateTable.size() == 0) {
+        return -1;
+    }
+    const size_t mask = stateTable.size() - 1;
+    for (size_t slot = hashAddress(address, stateTable.size()); stateTable[slot] >= 0; slot = (slot + 1) & mask) {
+        if (states[stateTable[slot]].address == address) {
+            lastStateIndex = stateTable[slot];
+            return lastStateIndex;
         }
     }
     return -1;
@@ -70,6 +114,15 @@ void AveragingProcessor::addConsumer(ObisConsumer& obis_consumer) {
 }
 
 
+/**
+ * Add an obis frame consumer to receive the result of the AveragingProcessor as a single frame per emeter packet.
+ * @param obis_frame_consumer Reference to the ObisFrameConsumer.
+ */
+void AveragingProcessor::addFrameConsumer(ObisFrameConsumer& obis_frame_consumer) {
+    obisFrameConsumerTable.push_back(&obis_frame_consumer);
+}
+
+
 /**
  * Add an speedwire consumer to receive the result of the AveragingProcessor.
  * @param speedwire_consumer Reference to the SpeedwireConsumer.
@@ -79,26 +132,79 @@ void AveragingProcessor::addConsumer(SpeedwireConsumer& speedwire_consumer) {
 }
 
 
+/**
+ * Add an aggregate consumer to receive time window aggregates.
+ * @param aggregate_consumer Reference to the AggregateConsumer.
+ */
+void AveragingProcessor::addAggregateConsumer(AggregateConsumer& aggregate_consumer) {
+    aggregateConsumerTable.push_back(&aggregate_consumer);
+}
+
+
+/**
+ * Enable time window aggregation of all received measurements; any previous aggregation state is discarded.
+ * @param window_time The window length in ms; 0 disables aggregation.
+ * @param hop_time The time between window ends in ms; 0 or window_time for tumbling windows, less than window_time for sliding windows.
+ */
+void AveragingProcessor::enableAggregation(const unsigned long window_time, const unsigned long hop_time) {
+    aggregationWindowTime = window_time;
+    aggregationHopTime = hop_time;
+    for (auto& state : states) {
+        state.aggregators.clear();
+    }
+}
+
+
+/**
+ * Add a measurement to the time window aggregator of the given device and measurement, and pass the aggregates
+ * of all windows closed by it to all registered AggregateConsumers. The aggregators of a device are kept in its
+ * averaging state.
+ * @param device The originating device.
+ * @param device_type The device type.
+ * @param key The measurement key.
+ * @param measurement The measurement definition.
+ * @param value The measurement value.
+ * @param time The measurement time.
+ */
+void AveragingProcessor::aggregate(const SpeedwireDevice& device, const DeviceType& device_type, const uint32_t key, const Measurement& measurement, const double value, const uint32_t time) {
+    int index = findStateIndex(device.deviceAddress);
+    if (index < 0) {
+        index = initializeState(device.deviceAddress, device_type);
+    }
+    std::map<uint32_t, MeasurementAggregator>& aggregators = states[index].aggregators;
+    std::map<uint32_t, MeasurementAggregator>::iterator it = aggregators.find(key);
+    if (it == aggregators.end()) {
+        // inverter timestamps are in seconds
+        const unsigned long scale = (device_type == DeviceType::INVERTER ? 1000 : 1);
+        const MeasurementAggregator aggregator((uint32_t)(aggregationWindowTime / scale), (uint32_t)(aggregationHopTime / scale));
+        it = aggregators.insert(std::make_pair(key, aggregator)).first;
+    }
+    aggregates.clear();
+    it->second.add(value, time, aggregates);
+    for (const auto& result : aggregates) {
+        for (int i = 0; i < aggregateConsumerTable.size(); ++i) {
+            aggregateConsumerTable[i]->consume(device, measurement, result);
+        }
+    }
+}
+
+
 /**
  * Internal implementation for temporal averaging of emeter obis values or inverter values.
  * @param device The originating inverter device.
  * @param device_type The device type.
- * @param type The measurement type.
- * @param measurement The measurement value.
+ * @param measurement_time The timestamp of the most recent measurement.
  * @return true if the averaging time perios has elapsed, false otherwise.
  */
-bool AveragingProcessor::process(const SpeedwireDevice& device, const DeviceType& device_type, Measurement& measurement) {
+bool AveragingProcessor::process(const SpeedwireDevice& device, const DeviceType& device_type, const uint32_t measurement_time) {
 
     // find device
-    int index = findStateIndex(device.deviceAddress.serialNumber);
+    int index = findStateIndex(device.deviceAddress);
     if (index < 0) {
-        index = initializeState(device.deviceAddress.serialNumber, device_type);
+        index = initializeState(device.deviceAddress, device_type);
     }
     AveragingState& state = states[index];
 
-    // get the most recent measurement timestamp
-    uint32_t measurementTime = measurement.measurementValues.getNewestElement().time;
-
     // if no averaging is intended, leave the measurement value as is
     if (state.averagingTime == 0) {
         state.averagingTimeReached = true;
@@ -110,8 +216,8 @@ bool AveragingProcessor::process(const SpeedwireDevice& device, const DeviceType
             state.averagingTimeReached = false;
         }
         // check if this is the first measurement of a new measurement block
-        else if (measurementTime != state.currentTimestamp) {
-            state.remainder += measurementTime - state.currentTimestamp;
+        else if (measurement_time != state.currentTimestamp) {
+            state.remainder += measurement_time - state.currentTimestamp;
             state.averagingTimeReached = (state.remainder >= state.averagingTime);
             //printf("averagingTimeReached %d\n", state.averagingTimeReached);
             if (state.averagingTimeReached == true) {
@@ -119,7 +225,7 @@ bool AveragingProcessor::process(const SpeedwireDevice& device, const DeviceType
             }
         }
     }
-    state.currentTimestamp = measurementTime;
+    state.currentTimestamp = measurement_time;
     state.currentTimestampIsValid = true;
 
     return state.averagingTimeReached;
@@ -133,7 +239,11 @@ bool AveragingProcessor::process(const SpeedwireDevice& device, const DeviceType
  */
 void AveragingProcessor::consume(const SpeedwireDevice& device, ObisData &element) {
     //element.print(stdout);
-    if (process(device, DeviceType::EMETER, element) == true) {
+    if (aggregationWindowTime > 0 && element.measurementValues.getNumberOfElements() > 0 && element.measurementValues.value_string.length() == 0) {
+        const TimestampDoublePair newest = element.measurementValues.getNewestElement();
+        aggregate(device, DeviceType::EMETER, element.toKey(), element, newest.value, newest.time);
+    }
+    if (process(device, DeviceType::EMETER, element.measurementValues.getNewestElement().time) == true) {
         for (int i = 0; i < obisConsumerTable.size(); ++i) {
             obisConsumerTable[i]->consume(device, element);
         }
@@ -148,7 +258,11 @@ void AveragingProcessor::consume(const SpeedwireDevice& device, ObisData &elemen
  */
 void AveragingProcessor::consume(const SpeedwireDevice& device, SpeedwireData& element) {
     //element.print(stdout); fprintf(stdout, "speedwire_currentTimestamp %ld\n", speedwire_currentTimestamp);
-    if (process(device, DeviceType::INVERTER, element) == true) {
+    if (aggregationWindowTime > 0 && element.measurementValues.getNumberOfElements() > 0 && element.measurementValues.value_string.length() == 0) {
+        const TimestampDoublePair newest = element.measurementValues.getNewestElement();
+        aggregate(device, DeviceType::INVERTER, element.toKey(), element, newest.value, newest.time);
+    }
+    if (process(device, DeviceType::INVERTER, element.measurementValues.getNewestElement().time) == true) {
         for (int i = 0; i < speedwireConsumerTable.size(); ++i) {
             speedwireConsumerTable[i]->consume(device, element);
         }
@@ -156,6 +270,38 @@ void AveragingProcessor::consume(const SpeedwireDevice& device, SpeedwireData& e
 }
 
 
+/**
+ * Callback to consume all filtered obis data of an emeter packet - implements the temporal averaging of obis values.
+ * All elements of the frame share the timestamp of the emeter packet, hence the averaging state is evaluated once per frame.
+ * @param device The originating emeter device.
+ * @param frame A reference to the obis data frame, holding output data of the ObisFilter.
+ */
+void AveragingProcessor::consume(const SpeedwireDevice& device, const ObisDataFrame& frame) {
+    if (aggregationWindowTime > 0) {
+        for (const auto& entry : frame) {
+            if (entry.element->measurementValues.value_string.length() == 0) {
+                aggregate(device, DeviceType::EMETER, entry.element->toKey(), *entry.element, entry.value, entry.time);
+            }
+        }
+    }
+    if (process(device, DeviceType::EMETER, frame.time) == true) {
+        for (int i = 0; i < obisFrameConsumerTable.size(); ++i) {
+            obisFrameConsumerTable[i]->consume(device, frame);
+        }
+        if (obisConsumerTable.size() > 0) {
+            for (const auto& entry : frame) {
+                for (int i = 0; i < obisConsumerTable.size(); ++i) {
+                    obisConsumerTable[i]->consume(device, *entry.element);
+                }
+            }
+            for (int i = 0; i < obisConsumerTable.size(); ++i) {
+                obisConsumerTable[i]->endOfObisData(device, frame.time);
+            }
+        }
+    }
+}
+
+
 /**
  * Callback to notify that the last obis data in the emeter packet has been processed.
  * @param serial_number The serial number of the originating emeter device.
@@ -163,7 +309,7 @@ void AveragingProcessor::consume(const SpeedwireDevice& device, SpeedwireData& e
  */
 void AveragingProcessor::endOfObisData(const SpeedwireDevice& device, const uint32_t time) {
     // if averaging time has been reached, signal end of obis data
-    int index = findStateIndex(device.deviceAddress.serialNumber);
+    int index = findStateIndex(device.deviceAddress);
     if (index >= 0 && states[index].averagingTimeReached == true) {
         for (int i = 0; i < obisConsumerTable.size(); ++i) {
             obisConsumerTable[i]->endOfObisData(device, time);
@@ -179,7 +325,7 @@ void AveragingProcessor::endOfObisData(const SpeedwireDevice& device, const uint
  */
 void AveragingProcessor::endOfSpeedwireData(const SpeedwireDevice& device, const uint32_t time) {
     // if averaging time has been reached, signal end of obis data
-    int index = findStateIndex(device.deviceAddress.serialNumber);
+    int index = findStateIndex(device.deviceAddress);
     if (index >= 0 && states[index].averagingTimeReached == true) {
         for (int i = 0; i < speedwireConsumerTable.size(); ++i) {
             speedwireConsumerTable[i]->endOfSpeedwireData(device, time);
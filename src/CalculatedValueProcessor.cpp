@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <CalculatedValueProcessor.hpp>
 #include <LocalHost.hpp>
 #include <SpeedwireTime.hpp>
@@ -5,21 +6,68 @@
 using namespace libspeedwire;
 
 
-// Calculate difference between all positive and negative measurement values and store it in diff values
-static void calculateValueDiffs(Measurement& diff, const Measurement& pos, const Measurement& neg) {
-    const MeasurementValues& pos_values = pos.measurementValues;
-    const MeasurementValues& neg_values = neg.measurementValues;
-    MeasurementValues& diff_values = diff.measurementValues;
-    diff_values.clear();
-    for (size_t i = 0; i < pos_values.getNumberOfElements(); ++i) {
-        if (pos_values[i].time == neg_values[i].time) {
-            double signed_value = pos_values[i].value - neg_values[i].value;
-            diff_values.addMeasurement(signed_value, pos_values[i].time);
+// Positive, negative and signed power definitions of L1, L2, L3 and total power
+static const ObisData* const signed_power_channels[][3] = {
+    { &ObisData::PositiveActivePowerL1,    &ObisData::NegativeActivePowerL1,    &ObisData::SignedActivePowerL1 },
+    { &ObisData::PositiveActivePowerL2,    &ObisData::NegativeActivePowerL2,    &ObisData::SignedActivePowerL2 },
+    { &ObisData::PositiveActivePowerL3,    &ObisData::NegativeActivePowerL3,    &ObisData::SignedActivePowerL3 },
+    { &ObisData::PositiveActivePowerTotal, &ObisData::NegativeActivePowerTotal, &ObisData::SignedActivePowerTotal }
+};
+
+
+// Append the measurement of the given series received with the analyzed packet to the analysis inputs; the obis data
+// map is shared by all devices, hence older measurements of the series may originate from other devices
+static void addNewMeasurements(SignedPowerAnalysis& analysis, const ObisData& definition, const MeasurementValues& values) {
+    if (values.getNumberOfElements() > 0 && values.getNewestElement().time == analysis.time) {
+        SignedPowerAnalysis::Series series(definition, values.getMaximumNumberOfElements());
+        series.values.push_back(values.getNewestElement());
+        analysis.inputs.push_back(series);
+    }
+}
+
+
+// Find the given obis data in the given map; if it is not yet in the map, it is added with the given capacity
+static ObisData& findOrAdd(ObisDataMap& map, const ObisData& definition, const size_t capacity) {
+    ObisDataMap::iterator it = map.find(definition.toKey());
+    if (it == map.end()) {
+        it = map.insert(ObisDataMap::value_type(definition.toKey(), definition)).first;
+        it->second.measurementValues.setMaximumNumberOfElements(capacity);
+    }
+    return it->second;
+}
+
+
+/**
+ * Merge a newer analysis of the same device into this analysis, such that the new measurements of both are analyzed.
+ * @param newer The newer analysis.
+ */
+void SignedPowerAnalysis::merge(const SignedPowerAnalysis& newer) {
+    device = newer.device;
+    time = newer.time;
+    for (const auto& series : newer.inputs) {
+        std::vector<Series>::iterator it = inputs.begin();
+        while (it != inputs.end() && it->definition != series.definition) {
+            ++it;
+        }
+        if (it != inputs.end()) {
+            it->values.insert(it->values.end(), series.values.begin(), series.values.end());
+        }
+        else {
+            inputs.push_back(series);
         }
     }
 }
 
 
+/**
+ * Constructor of the per device analysis state.
+ */
+CalculatedValueProcessor::AnalysisState::AnalysisState(void) :
+    derived_values(obis_map, speedwire_map) {
+    defineSignedPower(derived_values);
+}
+
+
 /**
  * Constructor of the CalculatedValueProcessor instance.
  * @param obis_map       Reference to the data map, where all received obis values reside.
@@ -29,7 +77,9 @@ static void calculateValueDiffs(Measurement& diff, const Measurement& pos, const
 CalculatedValueProcessor::CalculatedValueProcessor(ObisDataMap& obis_map, SpeedwireDataMap& speedwire_map, Producer& _producer) :
     obis_data_map(obis_map),
     speedwire_data_map(speedwire_map),
-    producer(_producer) {
+    producer(_producer),
+    derived_values(obis_map, speedwire_map) {
+    defineSignedPower(derived_values);
 }
 
 
@@ -39,6 +89,18 @@ CalculatedValueProcessor::CalculatedValueProcessor(ObisDataMap& obis_map, Speedw
 CalculatedValueProcessor::~CalculatedValueProcessor(void) { }
 
 
+/**
+ * Define signed power L1, L2, L3 and total power as the difference of positive and negative power; the definitions
+ * are added in the order of the signed_power_channels table.
+ * @param engine The derived value engine.
+ */
+void CalculatedValueProcessor::defineSignedPower(DerivedValueEngine& engine) {
+    for (const auto& channel : signed_power_channels) {
+        engine.define(*channel[2], DerivedOperation::DIFFERENCE, *channel[0], *channel[1]);
+    }
+}
+
+
 /**
  * Callback to produce the given obis data to the next stage in the processing pipeline.
  * @param device The originating inverter device.
@@ -59,6 +121,20 @@ void CalculatedValueProcessor::consume(const SpeedwireDevice& device, SpeedwireD
 }
 
 
+/**
+ * Callback to consume all filtered obis data of an emeter packet.
+ * @param device The originating emeter device.
+ * @param frame A reference to the obis data frame, holding output data of the ObisFilter.
+ */
+void CalculatedValueProcessor::consume(const SpeedwireDevice& device, const ObisDataFrame& frame) {
+    for (const auto& entry : frame) {
+        const ObisData& element = *entry.element;
+        producer.produce(device, element.measurementType, element.wire, element.measurementValues.estimateMean(), entry.time);
+    }
+    endOfObisData(device, frame.time);
+}
+
+
 /**
  * Callback to notify that the last obis data in the emeter packet has been processed.
  * @param device The originating inverter device.
@@ -66,73 +142,75 @@ void CalculatedValueProcessor::consume(const SpeedwireDevice& device, SpeedwireD
  */
 void CalculatedValueProcessor::endOfObisData(const SpeedwireDevice& device, const uint32_t timestamp) {
     ObisDataMap::const_iterator pos, neg, end = obis_data_map.end();
-    ObisDataMap::iterator sig;
-
-    // calculate signed power L1
-    if ((pos = obis_data_map.find(ObisData::PositiveActivePowerL1.toKey())) != end &&
-        (neg = obis_data_map.find(ObisData::NegativeActivePowerL1.toKey())) != end &&
-        (sig = obis_data_map.find(ObisData::SignedActivePowerL1.toKey())) != end) {
-        calculateValueDiffs(sig->second, pos->second, neg->second);
-        producer.produce(device, ObisData::SignedActivePowerL1.measurementType, ObisData::SignedActivePowerL1.wire, sig->second.measurementValues.estimateMean(), timestamp);
-    }
 
-    // calculate signed power L2
-    if ((pos = obis_data_map.find(ObisData::PositiveActivePowerL2.toKey())) != end &&
-        (neg = obis_data_map.find(ObisData::NegativeActivePowerL2.toKey())) != end &&
-        (sig = obis_data_map.find(ObisData::SignedActivePowerL2.toKey())) != end) {
-        calculateValueDiffs(sig->second, pos->second, neg->second);
-        producer.produce(device, ObisData::SignedActivePowerL2.measurementType, ObisData::SignedActivePowerL2.wire, sig->second.measurementValues.estimateMean(), timestamp);
+    // pass the measurements received with this packet to the worker threads and produce all results that are
+    // available by now; packets that are not newer than the previous packet of the device are not analyzed again
+    if (analysis_pool) {
+        SignedPowerAnalysis analysis;
+        analysis.device = device;
+        analysis.time = timestamp;
+        const uint64_t address = ((uint64_t)device.deviceAddress.susyID << 32) | device.deviceAddress.serialNumber;
+        std::map<uint64_t, uint32_t>::iterator watermark = analysis_watermarks.find(address);
+        if (watermark == analysis_watermarks.end() || SpeedwireTime::calculateTimeDifference(timestamp, watermark->second) > 0) {
+            for (const auto& channel : signed_power_channels) {
+                if ((pos = obis_data_map.find(channel[0]->toKey())) != end &&
+                    (neg = obis_data_map.find(channel[1]->toKey())) != end &&
+                    obis_data_map.find(channel[2]->toKey()) != end) {
+                    addNewMeasurements(analysis, *channel[0], pos->second.measurementValues);
+                    addNewMeasurements(analysis, *channel[1], neg->second.measurementValues);
+                }
+            }
+        }
+        if (analysis.inputs.size() > 0) {
+            analysis_watermarks[address] = timestamp;
+            analysis_pool->submit(device.deviceAddress.serialNumber, analysis);
+        }
+        deliverAnalysisResults();
+        producer.flush();
+        return;
     }
 
-    // calculate signed power L3
-    if ((pos = obis_data_map.find(ObisData::PositiveActivePowerL3.toKey())) != end &&
-        (neg = obis_data_map.find(ObisData::NegativeActivePowerL3.toKey())) != end &&
-        (sig = obis_data_map.find(ObisData::SignedActivePowerL3.toKey())) != end) {
-        calculateValueDiffs(sig->second, pos->second, neg->second);
-        producer.produce(device, ObisData::SignedActivePowerL3.measurementType, ObisData::SignedActivePowerL3.wire, sig->second.measurementValues.estimateMean(), timestamp);
+    // calculate signed power L1, L2, L3 and total power from the new positive and negative power measurements
+    derived_values.evaluate();
+    const Measurement* signed_total = NULL;
+    for (const auto& step : derived_values.getPlan()) {
+        if (step.isResolved()) {
+            producer.produce(device, step.result->measurementType, step.result->wire, step.result->measurementValues.estimateMean(), timestamp);
+            if (step.result_ref.key == ObisData::SignedActivePowerTotal.toKey()) {
+                signed_total = step.result;
+            }
+        }
     }
 
-    // calculate signed total power
-    if ((pos = obis_data_map.find(ObisData::PositiveActivePowerTotal.toKey())) != end &&
-        (neg = obis_data_map.find(ObisData::NegativeActivePowerTotal.toKey())) != end &&
-        (sig = obis_data_map.find(ObisData::SignedActivePowerTotal.toKey())) != end) {
-        calculateValueDiffs(sig->second, pos->second, neg->second);
-        producer.produce(device, ObisData::SignedActivePowerTotal.measurementType, ObisData::SignedActivePowerTotal.wire, sig->second.measurementValues.estimateMean(), timestamp);
+    if (signed_total != NULL) {
 
 #if 1
-        // experimental setup to feed time-accurate power measurements
-        static uint32_t last_time = 0;
+        // experimental setup to feed time-accurate power measurements; the newest measurement of each packet is fed
+        // to the online change point detector and intervals are produced once they are finalized
         SpeedwireDevice experimental_device;
         experimental_device.deviceAddress.serialNumber = 1234567890;
-        const MeasurementValues& mvalues = sig->second.measurementValues;
-        std::vector<MeasurementValueInterval> intervals;
-        LineSegmentEstimator::findPiecewiseConstantIntervals(mvalues, intervals);
-        for (auto& iv : intervals) {
-            if (SpeedwireTime::calculateTimeDifference(mvalues[iv.end_index].time, last_time) <= 0) {
-#ifdef _DEBUG
-                printf("interval %d %d - %lu %lu : %lf  => skipped\n", (int)iv.start_index, (int)iv.end_index, mvalues[iv.start_index].time, mvalues[iv.end_index].time, iv.mean_value);
-#endif
-                continue;
-            }
-            while (SpeedwireTime::calculateTimeDifference(mvalues[iv.start_index].time, last_time) <= 0 && iv.start_index < (mvalues.getNumberOfElements() - 1)) {
+        const MeasurementValues& mvalues = signed_total->measurementValues;
+        if (mvalues.getNumberOfElements() > 0) {
+            const TimestampDoublePair newest = mvalues.getNewestElement();
+            DetectorState& state = detector_states[((uint64_t)device.deviceAddress.susyID << 32) | device.deviceAddress.serialNumber];
+            if (state.detector.getNumberOfMeasurements() == 0 || SpeedwireTime::calculateTimeDifference(newest.time, state.time) > 0) {
+                state.time = newest.time;
+                MeasurementValueInterval iv;
+                if (state.detector.addMeasurement(newest.value, newest.time, iv)) {
 #ifdef _DEBUG
-                printf("interval %d %d - %lu %lu : %lf  => incremented start index\n", (int)iv.start_index, (int)iv.end_index, mvalues[iv.start_index].time, mvalues[iv.end_index].time, iv.mean_value);
+                    printf("interval %lu %lu - %lu %lu : %lf\n", (unsigned long)iv.start_index, (unsigned long)iv.end_index, (unsigned long)iv.start_time, (unsigned long)iv.end_time, iv.mean_value);
 #endif
-                iv.start_index++;
+                    producer.produce(experimental_device, ObisData::SignedActivePowerTotal.measurementType, ObisData::SignedActivePowerTotal.wire, iv.mean_value, iv.start_time);
+                    producer.produce(experimental_device, ObisData::SignedActivePowerTotal.measurementType, ObisData::SignedActivePowerTotal.wire, iv.mean_value, iv.end_time);
+                }
             }
-#ifdef _DEBUG
-            printf("interval %d %d - %lu %lu : %lf\n", (int)iv.start_index, (int)iv.end_index, mvalues[iv.start_index].time, mvalues[iv.end_index].time, iv.mean_value);
-#endif
-            producer.produce(experimental_device, ObisData::SignedActivePowerTotal.measurementType, ObisData::SignedActivePowerTotal.wire, iv.mean_value, mvalues[iv.start_index].time);
-            producer.produce(experimental_device, ObisData::SignedActivePowerTotal.measurementType, ObisData::SignedActivePowerTotal.wire, iv.mean_value, mvalues[iv.end_index].time);
         }
-        last_time = mvalues[intervals[intervals.size() - 1].end_index].time;
 #else
         static MeasurementValues experimentalValues(1024);
 
         // experimental setup to feed time-accurate power measurements
-        for (size_t i = 0; i < sig->second.measurementValues.getNumberOfElements(); ++i) {
-            const TimestampDoublePair& pair = sig->second.measurementValues.at(i);
+        for (size_t i = 0; i < signed_total->measurementValues.getNumberOfElements(); ++i) {
+            const TimestampDoublePair& pair = signed_total->measurementValues.at(i);
             experimentalValues.addMeasurement(pair.value, pair.time);
         }
         static uint32_t last_time = 0;
@@ -301,3 +379,155 @@ void CalculatedValueProcessor::endOfSpeedwireData(const SpeedwireDevice& device,
     }
     producer.flush();
 }
+
+
+/**
+ * Enable asynchronous signed power analysis. Signed power differences of L1, L2, L3 and total power and the online
+ * change point detection of the signed total power are then calculated by worker threads. Each packet passes only the
+ * measurements received since the previous packet of the same device; the workers keep the derived series and the
+ * change point detector per device. Results are produced in packet order per device.
+ * @param number_of_threads The number of worker threads; if 0, the analysis is performed by deliverAnalysisResults().
+ * @param queue_size The maximum number of packets waiting for analysis.
+ * @param policy The policy applied if the analysis falls behind and the queue is full; only OverflowPolicy::MERGE is
+ *               accepted, it appends the new measurements to the waiting packet of the same device. Other policies
+ *               drop packets, such that the per device series and change point detectors would miss measurements.
+ * @return True if the analysis workers are enabled, false if the policy is not supported.
+ */
+bool CalculatedValueProcessor::enableAnalysisWorkers(const size_t number_of_threads, const size_t queue_size, const OverflowPolicy policy) {
+    if (policy != OverflowPolicy::MERGE) {
+        return false;
+    }
+    analysis_pool.reset();
+    analysis_pool.reset(new OrderedWorkerPool<SignedPowerAnalysis, SignedPowerAnalysis>(
+        [this](const SignedPowerAnalysis& job, SignedPowerAnalysis& result, const size_t) { analyze(job, result); },
+        number_of_threads, queue_size, policy,
+        [](SignedPowerAnalysis& queued, const SignedPowerAnalysis& job) { queued.merge(job); }));
+    return true;
+}
+
+
+/**
+ * Produce all asynchronous signed power analysis results that are available by now; this is called for each received
+ * emeter packet, but it can also be called periodically by the application.
+ * @return The number of produced analysis results.
+ */
+size_t CalculatedValueProcessor::deliverAnalysisResults(void) {
+    if (!analysis_pool) {
+        return 0;
+    }
+    return analysis_pool->deliver([this](const uint32_t, SignedPowerAnalysis& result) { deliver(result); });
+}
+
+
+/**
+ * Append the new measurements of a packet to the series of its device, calculate the new signed power measurements and
+ * feed the signed total power to the change point detector of the device; this is called on a worker thread. Jobs of
+ * the same device are processed one at a time, hence the state of the device is not shared with other threads.
+ * @param job The analysis input.
+ * @param result The analysis output.
+ */
+void CalculatedValueProcessor::analyze(const SignedPowerAnalysis& job, SignedPowerAnalysis& result) {
+    AnalysisState* state;
+    {
+        std::lock_guard<std::mutex> lock(analysis_states_mutex);
+        std::unique_ptr<AnalysisState>& entry = analysis_states[((uint64_t)job.device.deviceAddress.susyID << 32) | job.device.deviceAddress.serialNumber];
+        if (!entry) {
+            entry.reset(new AnalysisState());
+        }
+        state = entry.get();
+    }
+    result.device = job.device;
+    result.time = job.time;
+    result.inputs.clear();
+    result.outputs.clear();
+    result.intervals.clear();
+
+    // add the series; signed power series are added along with their positive and negative inputs
+    size_t max_inputs = 0;
+    for (const auto& input : job.inputs) {
+        findOrAdd(state->obis_map, *input.definition, input.capacity);
+        max_inputs = std::max(max_inputs, input.values.size());
+    }
+    ObisDataMap::const_iterator pos, neg, end = state->obis_map.end();
+    for (const auto& channel : signed_power_channels) {
+        if ((pos = state->obis_map.find(channel[0]->toKey())) != end &&
+            (neg = state->obis_map.find(channel[1]->toKey())) != end) {
+            findOrAdd(state->obis_map, *channel[2], pos->second.measurementValues.getMaximumNumberOfElements());
+        }
+    }
+
+    // a merged job carries the measurements of several packets; they are appended and evaluated packet by packet,
+    // such that no measurement is evicted from a series before it has been evaluated
+    const std::vector<DerivedValueEngine::Step>& plan = state->derived_values.getPlan();
+    for (size_t packet = 0; packet < max_inputs; ++packet) {
+        for (const auto& input : job.inputs) {
+            if (packet < input.values.size()) {
+                state->obis_map.find(input.definition->toKey())->second.measurementValues.addMeasurement(input.values[packet].value, input.values[packet].time);
+            }
+        }
+
+        // calculate signed power; results newer than the watermark of a definition before the evaluation are new
+        std::vector<std::pair<bool, uint32_t> > watermarks;
+        for (const auto& step : plan) {
+            watermarks.push_back(std::make_pair(step.has_watermark, step.watermark));
+        }
+        state->derived_values.evaluate();
+        for (size_t i = 0; i < plan.size(); ++i) {
+            if (plan[i].isResolved()) {
+                const MeasurementValues& values = plan[i].result->measurementValues;
+                const size_t n = values.getNumberOfElements();
+                std::vector<SignedPowerAnalysis::Series>::iterator output = result.outputs.begin();
+                while (output != result.outputs.end() && output->definition != signed_power_channels[i][2]) {
+                    ++output;
+                }
+                if (output == result.outputs.end()) {
+                    output = result.outputs.insert(output, SignedPowerAnalysis::Series(*signed_power_channels[i][2], values.getMaximumNumberOfElements()));
+                }
+                const size_t first_new = output->values.size();
+                for (size_t j = (watermarks[i].first ? values.findLowerBoundIndex(watermarks[i].second + 1, 0, n) : 0); j < n; ++j) {
+                    output->values.push_back(values[j]);
+                }
+                output->mean = values.estimateMean();
+
+                // feed the new signed total power measurements to the change point detector and collect finalized intervals
+                if (output->definition == &ObisData::SignedActivePowerTotal) {
+                    for (size_t j = first_new; j < output->values.size(); ++j) {
+                        MeasurementValueInterval iv;
+                        if (state->detector.addMeasurement(output->values[j].value, output->values[j].time, iv)) {
+                            result.intervals.push_back(iv);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+/**
+ * Produce the results of a signed power analysis; this is called on the thread calling deliverAnalysisResults().
+ * New signed power measurements are appended to the signed power series of the obis data map.
+ * @param analysis The analysis results.
+ */
+void CalculatedValueProcessor::deliver(SignedPowerAnalysis& analysis) {
+    for (const auto& output : analysis.outputs) {
+        ObisDataMap::iterator sig = obis_data_map.find(output.definition->toKey());
+        if (sig != obis_data_map.end()) {
+            MeasurementValues& sig_values = sig->second.measurementValues;
+            for (const auto& pair : output.values) {
+                sig_values.addMeasurement(pair.value, pair.time);
+            }
+        }
+        producer.produce(analysis.device, output.definition->measurementType, output.definition->wire, output.mean, analysis.time);
+    }
+
+    // produce intervals finalized by the change point detector
+    if (analysis.intervals.size() > 0) {
+        SpeedwireDevice experimental_device;
+        experimental_device.deviceAddress.serialNumber = 1234567890;
+        for (const auto& iv : analysis.intervals) {
+            producer.produce(experimental_device, ObisData::SignedActivePowerTotal.measurementType, ObisData::SignedActivePowerTotal.wire, iv.mean_value, iv.start_time);
+            producer.produce(experimental_device, ObisData::SignedActivePowerTotal.measurementType, ObisData::SignedActivePowerTotal.wire, iv.mean_value, iv.end_time);
+        }
+    }
+}
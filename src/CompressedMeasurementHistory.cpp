@@ -0,0 +1,161 @@
+#include <CompressedMeasurementHistory.hpp>
+#include <SpeedwireTime.hpp>
+using namespace libspeedwire;
+
+
+/**
+ * Constructor.
+ * @param samples_per_block The maximum number of samples per block; it must be > 0.
+ * @param max_blocks The maximum number of blocks; if it is exceeded, the oldest block is dropped.
+ */
+CompressedMeasurementHistory::CompressedMeasurementHistory(const size_t samples_per_block, const size_t max_blocks) :
+    samples_per_block(samples_per_block > 0 ? samples_per_block : 1),
+    max_blocks(max_blocks > 0 ? max_blocks : 1),
+    divisor(1),
+    num_samples(0),
+    previous_time(0),
+    previous_time_delta(0),
+    previous_raw_value(0) {}
+
+
+/**
+ * Add a raw measurement value to the history. The value is stored with the current divisor, see getDivisor(); if it
+ * differs from the divisor of the newest block, a new block is started.
+ * @param raw_value The raw measurement value.
+ * @param time The measurement time.
+ */
+void CompressedMeasurementHistory::addMeasurement(const int64_t raw_value, const uint32_t time) {
+    if (blocks.size() == 0 || blocks.back().count >= samples_per_block || blocks.back().divisor != divisor) {
+        if (blocks.size() >= max_blocks) {
+            num_samples -= blocks.front().count;
+            blocks.pop_front();
+        }
+        blocks.push_back(Block());
+        Block& block = blocks.back();
+        block.first_time = time;
+        block.first_raw_value = (uint64_t)raw_value;
+        block.divisor = divisor;
+        block.count = 1;
+        block.data.reserve(2 * samples_per_block);
+        previous_time_delta = 0;
+    }
+    else {
+        Block& block = blocks.back();
+        const int64_t time_delta = SpeedwireTime::calculateTimeDifference(time, previous_time);
+        writeVarint(block.data, zigzagEncode(time_delta - previous_time_delta));
+        writeVarint(block.data, zigzagEncode((int64_t)((uint64_t)raw_value - previous_raw_value)));
+        ++block.count;
+        previous_time_delta = time_delta;
+    }
+    previous_time = time;
+    previous_raw_value = (uint64_t)raw_value;
+    ++num_samples;
+}
+
+
+/**
+ * Remove all samples from the history.
+ */
+void CompressedMeasurementHistory::clear(void) {
+    blocks.clear();
+    num_samples = 0;
+}
+
+
+/**
+ * Get the approximate memory footprint of the encoded samples in bytes, i.e. the block headers and the encoded data.
+ * @return The encoded size in bytes.
+ */
+size_t CompressedMeasurementHistory::getEncodedSize(void) const {
+    size_t size = 0;
+    for (const auto& block : blocks) {
+        size += sizeof(block.first_time) + sizeof(block.first_raw_value) + sizeof(block.divisor) + sizeof(block.count) + block.data.size();
+    }
+    return size;
+}
+
+
+/**
+ * Append the given value as LEB128 varint, i.e. 7 bits per byte, least significant group first.
+ */
+void CompressedMeasurementHistory::writeVarint(std::vector<uint8_t>& data, uint64_t value) {
+    while (value >= 0x80) {
+        data.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    data.push_back((uint8_t)value);
+}
+
+
+/**
+ * Read a LEB128 varint at the given offset; the offset is advanced past the varint.
+ */
+uint64_t CompressedMeasurementHistory::readVarint(const std::vector<uint8_t>& data, size_t& offset) {
+    uint64_t value = 0;
+    unsigned shift = 0;
+    uint8_t byte;
+    do {
+        byte = data[offset++];
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        shift += 7;
+    } while ((byte & 0x80) != 0);
+    return value;
+}
+
+
+/**
+ * Constructor.
+ * @param blocks Reference to the encoded blocks.
+ * @param block_index Index of the first block to decode; blocks.size() for the end iterator.
+ */
+CompressedMeasurementHistory::Iterator::Iterator(const std::deque<Block>& blocks, const size_t block_index) :
+    blocks(&blocks),
+    block_index(block_index),
+    sample_index(0),
+    data_offset(0),
+    time_delta(0) {
+    load();
+}
+
+
+/**
+ * Load the first sample of the current block, skipping empty blocks.
+ */
+void CompressedMeasurementHistory::Iterator::load(void) {
+    while (block_index < blocks->size() && (*blocks)[block_index].count == 0) {
+        ++block_index;
+    }
+    if (block_index < blocks->size()) {
+        const Block& block = (*blocks)[block_index];
+        sample.time = block.first_time;
+        sample.raw_value = (int64_t)block.first_raw_value;
+        sample.divisor = block.divisor;
+        sample_index = 0;
+        data_offset = 0;
+        time_delta = 0;
+    }
+    else {
+        block_index = blocks->size();
+        sample_index = 0;
+    }
+}
+
+
+/**
+ * Decode the next sample.
+ */
+CompressedMeasurementHistory::Iterator& CompressedMeasurementHistory::Iterator::operator++(void) {
+    if (block_index >= blocks->size()) {
+        return *this;
+    }
+    const Block& block = (*blocks)[block_index];
+    if (++sample_index >= block.count) {
+        ++block_index;
+        load();
+        return *this;
+    }
+    time_delta += zigzagDecode(readVarint(block.data, data_offset));
+    sample.time = (uint32_t)(sample.time + time_delta);
+    sample.raw_value = (int64_t)((uint64_t)sample.raw_value + (uint64_t)zigzagDecode(readVarint(block.data, data_offset)));
+    return *this;
+}
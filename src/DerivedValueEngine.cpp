@@ -0,0 +1,166 @@
+#include <DerivedValueEngine.hpp>
+#include <SpeedwireTime.hpp>
+using namespace libspeedwire;
+
+
+/**
+ * Constructor.
+ * @param obis_map Reference to the data map holding obis measurements.
+ * @param speedwire_map Reference to the data map holding speedwire measurements.
+ */
+DerivedValueEngine::DerivedValueEngine(ObisDataMap& obis_map, SpeedwireDataMap& speedwire_map) :
+    obis_data_map(obis_map),
+    speedwire_data_map(speedwire_map),
+    unresolved(0) {}
+
+
+/**
+ * Add a definition of a derived measurement; the plan is compiled by the next call to evaluate().
+ * @param result Reference to the result measurement; its measurement values are overwritten.
+ * @param operation The operation calculating the result value from the operand values.
+ * @param a Reference to the first operand measurement; result measurements carry the timestamps of this operand.
+ * @param b Reference to the second operand measurement.
+ * @param time_tolerance The maximum time difference of paired operand measurements, in units of the operand timestamps.
+ * @return The index of the definition in the evaluation plan.
+ */
+size_t DerivedValueEngine::define(const DerivedValueRef& result, const DerivedOperation operation, const DerivedValueRef& a, const DerivedValueRef& b, const uint32_t time_tolerance) {
+    plan.push_back(Step(operation, result, a, b, time_tolerance));
+    ++unresolved;
+    return plan.size() - 1;
+}
+
+
+/**
+ * Resolve all unresolved definitions into pointers to the measurements in the data maps.
+ * @return The number of unresolved definitions.
+ */
+size_t DerivedValueEngine::compile(void) {
+    unresolved = 0;
+    for (auto& step : plan) {
+        if (step.isResolved() == false) {
+            Measurement* const result = resolve(step.result_ref);
+            const Measurement* const a = resolve(step.a_ref);
+            const Measurement* const b = resolve(step.b_ref);
+            if (result != NULL && a != NULL && b != NULL) {
+                step.a = &a->measurementValues;
+                step.b = &b->measurementValues;
+                step.result = result;
+                step.has_watermark = false;
+            }
+            else {
+                ++unresolved;
+            }
+        }
+    }
+    return unresolved;
+}
+
+
+/**
+ * Evaluate the plan; unresolved definitions are compiled first.
+ * @return The total number of added result measurements.
+ */
+size_t DerivedValueEngine::evaluate(void) {
+    if (unresolved > 0) {
+        compile();
+    }
+    size_t count = 0;
+    for (auto& step : plan) {
+        if (step.isResolved()) {
+            count += evaluate(step);
+        }
+    }
+    return count;
+}
+
+
+/**
+ * Evaluate a single resolved definition for all measurements of operand a newer than its watermark.
+ * @param step The definition.
+ * @return The number of added result measurements.
+ */
+size_t DerivedValueEngine::evaluate(Step& step) const {
+    const MeasurementValues& a = *step.a;
+    const MeasurementValues& b = *step.b;
+    const size_t na = a.getNumberOfElements();
+    const size_t nb = b.getNumberOfElements();
+    if (na == 0 || nb == 0) {
+        return 0;
+    }
+    MeasurementValues& result = step.result->measurementValues;
+    if (step.has_watermark == false) {
+        result.clear();
+    }
+
+    // find the first measurement of operand a after the watermark and the first candidate measurement of operand b
+    size_t ia = (step.has_watermark ? a.findLowerBoundIndex(step.watermark + 1, 0, na) : 0);
+    if (ia == na) {
+        return 0;
+    }
+    const uint32_t tolerance = step.time_tolerance;
+    const uint32_t b_newest_time = b[nb - 1].time;
+    size_t ib = b.findLowerBoundIndex(a[ia].time - tolerance, 0, nb);
+
+    // process measurements of operand a, as long as operand b has caught up with them within the time tolerance
+    size_t count = 0;
+    for (; ia < na; ++ia) {
+        const TimestampDoublePair pa = a[ia];
+        if (SpeedwireTime::calculateTimeDifference(pa.time - tolerance, b_newest_time) > 0) {
+            break;
+        }
+        step.watermark = pa.time;
+        step.has_watermark = true;
+
+        // find the closest measurement of operand b within the time tolerance
+        while (ib + 1 < nb && SpeedwireTime::calculateTimeDifference(b[ib + 1].time, pa.time) <= 0) {
+            ++ib;
+        }
+        if (ib >= nb) {
+            continue;
+        }
+        size_t closest = ib;
+        uint32_t distance = SpeedwireTime::calculateAbsTimeDifference(b[ib].time, pa.time);
+        if (ib + 1 < nb && SpeedwireTime::calculateAbsTimeDifference(b[ib + 1].time, pa.time) < distance) {
+            closest = ib + 1;
+            distance = SpeedwireTime::calculateAbsTimeDifference(b[ib + 1].time, pa.time);
+        }
+        if (distance <= tolerance) {
+            result.addMeasurement(apply(step.operation, pa.value, b[closest].value), pa.time);
+            ++count;
+        }
+    }
+    return count;
+}
+
+
+/**
+ * Find the referenced measurement in the data maps.
+ * @param ref The reference.
+ * @return Pointer to the measurement, or NULL if it is not in the data map.
+ */
+Measurement* DerivedValueEngine::resolve(const DerivedValueRef& ref) const {
+    if (ref.source == DerivedValueSource::OBIS) {
+        ObisDataMap::iterator it = obis_data_map.find(ref.key);
+        return (it != obis_data_map.end() ? &it->second : NULL);
+    }
+    SpeedwireDataMap::iterator it = speedwire_data_map.find(ref.key);
+    return (it != speedwire_data_map.end() ? &it->second : NULL);
+}
+
+
+/**
+ * Apply the given operation to the given operand values.
+ * @param operation The operation.
+ * @param a The first operand value.
+ * @param b The second operand value.
+ * @return The result value.
+ */
+double DerivedValueEngine::apply(const DerivedOperation operation, const double a, const double b) {
+    switch (operation) {
+    case DerivedOperation::DIFFERENCE:  return a - b;
+    case DerivedOperation::SUM:         return a + b;
+    case DerivedOperation::RATIO:       return (b != 0.0 ? a / b : 0.0);
+    case DerivedOperation::PERCENTAGE:  return (b != 0.0 ? (a / b) * 100.0 : 0.0);
+    }
+    return 0.0;
+}
@@ -0,0 +1,320 @@
+#include <EnergyProcessor.hpp>
+#include <SpeedwireTime.hpp>
+using namespace libspeedwire;
+
+
+/**
+ * Constructor.
+ * @param source The quantity of the tracked measurements.
+ * @param time_base The time base of the timestamps of the tracked measurements.
+ * @param interval_in_ms The interval length in milliseconds, e.g. 15 * 60 * 1000 for 15 minute billing intervals.
+ * @param watt_seconds_per_unit The number of watt seconds per energy unit, e.g. 3600000 for kWh or 3600 for Wh.
+ * @param max_gap_in_ms The maximum time between measurements in milliseconds; longer gaps count as missing data. 0 if unlimited.
+ */
+EnergyTracker::EnergyTracker(const EnergySource source, const MeasurementTimeBase time_base, const uint64_t interval_in_ms, const double watt_seconds_per_unit,
+                             const uint64_t max_gap_in_ms) :
+    source(source),
+    time_base(time_base),
+    interval_in_ms(interval_in_ms > 0 ? interval_in_ms : 1),
+    max_gap_in_ms(max_gap_in_ms),
+    ms_per_unit(watt_seconds_per_unit * 1000.0) {
+    reset();
+}
+
+
+/**
+ * Discard all state and restart tracking with the next measurement.
+ */
+void EnergyTracker::reset(void) {
+    has_last = false;
+    last_time = 0;
+    last_time64 = 0;
+    last_value = 0.0;
+    energy.clear();
+    power = 0.0;
+    has_power = false;
+    has_interval_start = false;
+    interval_start = 0;
+    interval_start_energy = 0.0;
+}
+
+
+/**
+ * Process all measurements newer than the most recently processed measurement.
+ * @param values The measurement values; they must be added in increasing time order.
+ * @param intervals The output vector; completed intervals are appended.
+ * @param unix_epoch_time_in_ms The current unix epoch time; it is used to expand the first timestamp to 64 bits.
+ * @return The number of processed measurements.
+ */
+size_t EnergyTracker::update(const MeasurementValues& values, std::vector<EnergyInterval>& intervals, const uint64_t unix_epoch_time_in_ms) {
+    const size_t n = values.getNumberOfElements();
+    const int64_t scale = (time_base == MeasurementTimeBase::INVERTER_S ? 1000 : 1);
+    size_t count = 0;
+    for (size_t i = (has_last ? values.findLowerBoundIndex(last_time + 1, 0, n) : 0); i < n; ++i) {
+        const TimestampDoublePair measurement = values[i];
+
+        // the first measurement only defines the starting point
+        if (has_last == false) {
+            if (time_base == MeasurementTimeBase::INVERTER_S) {
+                restart(SpeedwireTime::convertInverterTimeToUnixEpochTime(measurement.time, unix_epoch_time_in_ms), measurement);
+            }
+            else {
+                restart(SpeedwireTime::convertEmeterTimeToUnixEpochTime(measurement.time, unix_epoch_time_in_ms), measurement);
+            }
+            ++count;
+            continue;
+        }
+
+        const int32_t diff = SpeedwireTime::calculateTimeDifference(measurement.time, last_time);
+        if (diff <= 0) {
+            continue;
+        }
+        const uint64_t time64 = last_time64 + diff * scale;
+
+        // a gap longer than the maximum counts as missing data; the measurement after the gap is a new starting point
+        if (max_gap_in_ms > 0 && time64 - last_time64 > max_gap_in_ms) {
+            restart(time64, measurement);
+            ++count;
+            continue;
+        }
+        const double duration = (double)(time64 - last_time64);
+        double delta;
+        if (source == EnergySource::ENERGY_COUNTER) {
+            delta = measurement.value - last_value;
+            if (delta < 0.0) {
+                delta = 0.0;    // counter reset
+            }
+            power = delta * ms_per_unit / duration;
+            has_power = true;
+        }
+        else {
+            delta = 0.5 * (last_value + measurement.value) * duration / ms_per_unit;
+            power = measurement.value;
+        }
+        const double previous_energy = energy.sum;
+        energy.add(delta);
+        addBoundaries(time64, measurement.value, previous_energy, intervals);
+
+        last_time = measurement.time;
+        last_time64 = time64;
+        last_value = measurement.value;
+        ++count;
+    }
+    return count;
+}
+
+
+/**
+ * Restart tracking from the given measurement without accounting energy; the interval in progress is discarded.
+ * @param time64 The unix epoch time of the measurement in ms.
+ * @param measurement The measurement.
+ */
+void EnergyTracker::restart(const uint64_t time64, const TimestampDoublePair& measurement) {
+    last_time = measurement.time;
+    last_time64 = time64;
+    last_value = measurement.value;
+    power = (source == EnergySource::POWER ? measurement.value : 0.0);
+    has_power = (source == EnergySource::POWER);
+    has_last = true;
+    has_interval_start = (time64 % interval_in_ms == 0);
+    interval_start = time64;
+    interval_start_energy = energy.sum;
+}
+
+
+/**
+ * Split the cumulative energy at all interval boundaries between the most recently processed measurement and the given one.
+ * @param time64 The unix epoch time of the new measurement in ms.
+ * @param value The value of the new measurement.
+ * @param previous_energy The cumulative energy at the most recently processed measurement.
+ * @param intervals The output vector; completed intervals are appended.
+ */
+void EnergyTracker::addBoundaries(const uint64_t time64, const double value, const double previous_energy, std::vector<EnergyInterval>& intervals) {
+    const double duration = (double)(time64 - last_time64);
+    for (uint64_t boundary = (last_time64 / interval_in_ms + 1) * interval_in_ms; boundary <= time64; boundary += interval_in_ms) {
+        const double elapsed = (double)(boundary - last_time64);
+        double boundary_energy;
+        if (source == EnergySource::ENERGY_COUNTER) {
+            boundary_energy = previous_energy + (energy.sum - previous_energy) * (elapsed / duration);
+        }
+        else {
+            const double boundary_power = last_value + (value - last_value) * (elapsed / duration);
+            boundary_energy = previous_energy + 0.5 * (last_value + boundary_power) * elapsed / ms_per_unit;
+        }
+        if (has_interval_start) {
+            const double interval_energy = boundary_energy - interval_start_energy;
+            intervals.push_back(EnergyInterval(interval_start, boundary, interval_energy, interval_energy * ms_per_unit / (double)(boundary - interval_start)));
+        }
+        has_interval_start = true;
+        interval_start = boundary;
+        interval_start_energy = boundary_energy;
+    }
+}
+
+
+/**
+ * Get the number of watt seconds per energy unit of the given measurement type, i.e. 3600000 for units with a kilo prefix
+ * like kWh, and 3600 otherwise.
+ * @param energy_type The measurement type.
+ * @return The number of watt seconds per energy unit.
+ */
+double EnergyTracker::getWattSecondsPerUnit(const MeasurementType& energy_type) {
+    return (energy_type.unit.length() > 0 && energy_type.unit[0] == 'k' ? 3600000.0 : 3600.0);
+}
+
+
+/**
+ * Constructor.
+ * @param producer Reference to the producer receiving derived values for each packet.
+ * @param interval_producer Reference to the producer receiving completed interval values; it can be the same as producer.
+ * @param interval_in_ms The interval length in milliseconds, e.g. 15 * 60 * 1000 for 15 minute billing intervals.
+ * @param max_gap_in_ms The maximum time between measurements in milliseconds; longer gaps count as missing data. 0 if unlimited.
+ */
+EnergyProcessor::EnergyProcessor(Producer& producer, Producer& interval_producer, const uint64_t interval_in_ms, const uint64_t max_gap_in_ms) :
+    producer(producer),
+    interval_producer(interval_producer),
+    interval_in_ms(interval_in_ms),
+    max_gap_in_ms(max_gap_in_ms) {}
+
+
+/**
+ * Register an emeter energy counter; the average power between packets is derived from the counter.
+ * @param counter The obis data definition of the energy counter.
+ * @param power_type The measurement type of the derived power values.
+ */
+void EnergyProcessor::addEnergyCounter(const ObisData& counter, const MeasurementType& power_type) {
+    definitions.push_back(Definition(counter, EnergySource::ENERGY_COUNTER, power_type, counter.measurementType, counter.wire));
+}
+
+
+/**
+ * Register an inverter energy counter; the average power between packets is derived from the counter.
+ * @param counter The speedwire data definition of the energy counter.
+ * @param power_type The measurement type of the derived power values.
+ */
+void EnergyProcessor::addEnergyCounter(const SpeedwireData& counter, const MeasurementType& power_type) {
+    definitions.push_back(Definition(counter, EnergySource::ENERGY_COUNTER, power_type, counter.measurementType, counter.wire));
+}
+
+
+/**
+ * Register an emeter power measurement; the energy is integrated from the power values.
+ * @param power The obis data definition of the power measurement.
+ * @param energy_type The measurement type of the integrated energy values.
+ */
+void EnergyProcessor::addPower(const ObisData& power, const MeasurementType& energy_type) {
+    definitions.push_back(Definition(power, EnergySource::POWER, power.measurementType, energy_type, power.wire));
+}
+
+
+/**
+ * Register an inverter power measurement; the energy is integrated from the power values.
+ * @param power The speedwire data definition of the power measurement.
+ * @param energy_type The measurement type of the integrated energy values.
+ */
+void EnergyProcessor::addPower(const SpeedwireData& power, const MeasurementType& energy_type) {
+    definitions.push_back(Definition(power, EnergySource::POWER, power.measurementType, energy_type, power.wire));
+}
+
+
+/**
+ * Update the trackers of all definitions registered for the given measurement and produce derived and interval values.
+ * @param device The originating device.
+ * @param source The data map of the measurement.
+ * @param key The key of the measurement.
+ * @param values The measurement values.
+ */
+void EnergyProcessor::process(const SpeedwireDevice& device, const DerivedValueSource source, const uint32_t key, const MeasurementValues& values) {
+    const MeasurementTimeBase time_base = (source == DerivedValueSource::OBIS ? MeasurementTimeBase::EMETER_MS : MeasurementTimeBase::INVERTER_S);
+    for (size_t i = 0; i < definitions.size(); ++i) {
+        const Definition& definition = definitions[i];
+        if (definition.input.source != source || definition.input.key != key) {
+            continue;
+        }
+        const uint64_t tracker_key = ((uint64_t)device.deviceAddress.serialNumber << 32) | (uint64_t)i;
+        std::map<uint64_t, EnergyTracker>::iterator it = trackers.find(tracker_key);
+        if (it == trackers.end()) {
+            EnergyTracker tracker(definition.source, time_base, interval_in_ms, EnergyTracker::getWattSecondsPerUnit(definition.energy_type), max_gap_in_ms);
+            it = trackers.insert(std::make_pair(tracker_key, tracker)).first;
+        }
+        EnergyTracker& tracker = it->second;
+
+        intervals.clear();
+        if (tracker.update(values, intervals) > 0) {
+            if (definition.source == EnergySource::ENERGY_COUNTER) {
+                if (tracker.hasPower()) {
+                    producer.produce(device, definition.power_type, definition.wire, tracker.getPower(), tracker.getTime());
+                }
+            }
+            else {
+                producer.produce(device, definition.energy_type, definition.wire, tracker.getEnergy(), tracker.getTime());
+            }
+        }
+        for (const auto& interval : intervals) {
+            const uint32_t end_time = (time_base == MeasurementTimeBase::INVERTER_S ?
+                SpeedwireTime::convertUnixEpochTimeToInverterTimer(interval.end_time) :
+                SpeedwireTime::convertUnixEpochTimeToEmeterTimer(interval.end_time));
+            interval_producer.produce(device, definition.energy_type, definition.wire, interval.energy, end_time);
+            interval_producer.produce(device, definition.power_type, definition.wire, interval.average_power, end_time);
+        }
+    }
+}
+
+
+/**
+ * Callback to process the given obis data.
+ * @param device The originating emeter device.
+ * @param element A reference to a received ObisData instance.
+ */
+void EnergyProcessor::consume(const SpeedwireDevice& device, ObisData& element) {
+    process(device, DerivedValueSource::OBIS, element.toKey(), element.measurementValues);
+}
+
+
+/**
+ * Callback to process all obis data of an emeter packet.
+ * @param device The originating emeter device.
+ * @param frame A reference to the obis data frame.
+ */
+void EnergyProcessor::consume(const SpeedwireDevice& device, const ObisDataFrame& frame) {
+    for (const auto& entry : frame) {
+        process(device, DerivedValueSource::OBIS, entry.element->toKey(), entry.element->measurementValues);
+    }
+    endOfObisData(device, frame.time);
+}
+
+
+/**
+ * Callback to process the given speedwire data.
+ * @param device The originating inverter device.
+ * @param element A reference to a received SpeedwireData instance.
+ */
+void EnergyProcessor::consume(const SpeedwireDevice& device, SpeedwireData& element) {
+    process(device, DerivedValueSource::SPEEDWIRE, element.toKey(), element.measurementValues);
+}
+
+
+/**
+ * Callback to notify that the last obis data in the emeter packet has been processed.
+ * @param device The originating emeter device.
+ * @param time The timestamp associated with the just finished emeter packet.
+ */
+void EnergyProcessor::endOfObisData(const SpeedwireDevice& /*device*/, const uint32_t /*time*/) {
+    producer.flush();
+    if (&interval_producer != &producer) {
+        interval_producer.flush();
+    }
+}
+
+
+/**
+ * Callback to notify that the last data in the inverter packet has been processed.
+ * @param device The originating inverter device.
+ * @param time The timestamp associated with the just finished inverter packet.
+ */
+void EnergyProcessor::endOfSpeedwireData(const SpeedwireDevice& /*device*/, const uint32_t /*time*/) {
+    producer.flush();
+    if (&interval_producer != &producer) {
+        interval_producer.flush();
+    }
+}
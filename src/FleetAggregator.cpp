@@ -0,0 +1,422 @@
+#include <FleetAggregator.hpp>
+using namespace libspeedwire;
+
+const uint32_t FleetAggregator::ColumnHeap::none;
+const uint32_t FleetAggregator::IndexTable::none;
+
+
+/**
+ * Constructor.
+ * @param stale_time_in_ms The time in milliseconds after which a device without updates is considered stale.
+ */
+FleetAggregator::FleetAggregator(const uint64_t stale_time_in_ms) :
+    stale_time(stale_time_in_ms),
+    number_of_rows(0),
+    row_capacity(0) {}
+
+
+/**
+ * Register a measurement; each registered measurement is a column of the matrix.
+ * @param measurement The obis data definition of the measurement.
+ * @return The column index of the measurement.
+ */
+uint32_t FleetAggregator::addMeasurement(const ObisData& measurement) {
+    const uint32_t key = measurement.toKey();
+    const int existing = findMeasurement(key);
+    if (existing >= 0) {
+        return (uint32_t)existing;
+    }
+    const uint32_t column = (uint32_t)columns.size();
+    columns.push_back(Column(key));
+    columns.back().min_heap.position.assign(row_capacity, ColumnHeap::none);
+    columns.back().max_heap.position.assign(row_capacity, ColumnHeap::none);
+    keys.insert(key, column);
+    values.resize(columns.size() * row_capacity, 0.0);
+    present.resize(columns.size() * row_capacity, 0);
+    return column;
+}
+
+
+/**
+ * Get the row index of the given device; a new row is added for unknown devices.
+ * @param device The device address.
+ * @return The row index of the device.
+ */
+uint32_t FleetAggregator::getDeviceRow(const SpeedwireAddress& device) {
+    const uint64_t address = ((uint64_t)device.susyID << 32) | device.serialNumber;
+    const int existing = rows.find(address);
+    if (existing >= 0) {
+        return (uint32_t)existing;
+    }
+    if (number_of_rows >= row_capacity) {
+        grow();
+    }
+    const uint32_t row = number_of_rows++;
+    row_stale.push_back(0);
+    row_time.push_back(UINT64_MAX);
+    rows.insert(address, row);
+    return row;
+}
+
+
+/**
+ * Find the index of the given key.
+ * @param key The key.
+ * @return The index, or -1 if the key is not in the table.
+ */
+int FleetAggregator::IndexTable::find(const uint64_t key) const {
+    if (size == 0) {
+        return -1;
+    }
+    const size_t mask = keys.size() - 1;
+    for (size_t slot = hash(key); indexes[slot] != none; slot = (slot + 1) & mask) {
+        if (keys[slot] == key) {
+            return (int)indexes[slot];
+        }
+    }
+    return -1;
+}
+
+
+/**
+ * Insert a key that is not yet in the table; if the table would be more than half full, it is rebuilt with twice
+ * the number of slots.
+ * @param key The key.
+ * @param index The index of the key.
+ */
+void FleetAggregator::IndexTable::insert(const uint64_t key, const uint32_t index) {
+    if (2 * (size + 1) > keys.size()) {
+        std::vector<uint64_t> old_keys;
+        std::vector<uint32_t> old_indexes;
+        old_keys.swap(keys);
+        old_indexes.swap(indexes);
+        keys.assign(old_keys.size() > 0 ? 2 * old_keys.size() : 16, 0);
+        indexes.assign(keys.size(), none);
+        size = 0;
+        for (size_t slot = 0; slot < old_keys.size(); ++slot) {
+            if (old_indexes[slot] != none) {
+                insert(old_keys[slot], old_indexes[slot]);
+            }
+        }
+    }
+    const size_t mask = keys.size() - 1;
+    size_t slot = hash(key);
+    while (indexes[slot] != none) {
+        slot = (slot + 1) & mask;
+    }
+    keys[slot] = key;
+    indexes[slot] = index;
+    ++size;
+}
+
+
+/**
+ * Double the number of rows per column; the matrix is copied column by column.
+ */
+void FleetAggregator::grow(void) {
+    const uint32_t capacity = (row_capacity > 0 ? 2 * row_capacity : 16);
+    std::vector<double>  new_values(columns.size() * capacity, 0.0);
+    std::vector<uint8_t> new_present(columns.size() * capacity, 0);
+    for (size_t column = 0; column < columns.size(); ++column) {
+        for (uint32_t row = 0; row < number_of_rows; ++row) {
+            new_values [column * capacity + row] = values [column * row_capacity + row];
+            new_present[column * capacity + row] = present[column * row_capacity + row];
+        }
+    }
+    values.swap(new_values);
+    present.swap(new_present);
+    for (auto& c : columns) {
+        c.min_heap.position.resize(capacity, ColumnHeap::none);
+        c.max_heap.position.resize(capacity, ColumnHeap::none);
+    }
+    row_capacity = capacity;
+}
+
+
+/**
+ * Set the latest value of a device and measurement and update the column totals.
+ * @param row The row index of the device, see getDeviceRow().
+ * @param column The column index of the measurement, see addMeasurement().
+ * @param value The measurement value.
+ * @param now The local time in milliseconds.
+ */
+void FleetAggregator::update(const uint32_t row, const uint32_t column, const double value, const uint64_t now) {
+    touch(row, now);
+    Column& c = columns[column];
+    const size_t i = cell(row, column);
+    const double* v = values.data() + cell(0, column);
+    if (present[i] != 0) {
+        const double previous = values[i];
+        values[i] = value;
+        addToSum(column, value - previous);
+        c.min_heap.update(v, row);
+        c.max_heap.update(v, row);
+    }
+    else {
+        present[i] = 1;
+        ++c.count;
+        values[i] = value;
+        addToSum(column, value);
+        c.min_heap.insert(v, row);
+        c.max_heap.insert(v, row);
+    }
+}
+
+
+/**
+ * Add a change to the sum of a column; after as many changes as there are rows, the sum is re-calculated instead.
+ * The values of the column must already hold the change.
+ * @param column The column index.
+ * @param delta The change of the sum.
+ */
+void FleetAggregator::addToSum(const uint32_t column, const double delta) {
+    Column& c = columns[column];
+    if (++c.changes >= number_of_rows) {
+        resum(column);
+    }
+    else {
+        c.sum.add(delta);
+    }
+}
+
+
+/**
+ * Re-calculate the sum of all live values of a column from the contiguous column; values of rows without a value
+ * are 0.0, values of stale rows are skipped. Independent accumulators allow the compiler to vectorize the loop.
+ * @param column The column index.
+ */
+void FleetAggregator::resum(const uint32_t column) {
+    enum { lanes = 8 };
+    const double* v = values.data() + cell(0, column);
+    const uint8_t* stale = row_stale.data();
+    const uint32_t n = number_of_rows;
+    double s[lanes] = { 0.0 };
+    uint32_t row = 0;
+    for (; row + lanes <= n; row += lanes) {
+        for (uint32_t k = 0; k < lanes; ++k) {
+            s[k] += (stale[row + k] != 0 ? 0.0 : v[row + k]);
+        }
+    }
+    for (; row < n; ++row) {
+        s[0] += (stale[row] != 0 ? 0.0 : v[row]);
+    }
+    Column& c = columns[column];
+    c.sum.clear();
+    c.sum.add(((s[0] + s[1]) + (s[2] + s[3])) + ((s[4] + s[5]) + (s[6] + s[7])));
+    c.changes = 0;
+}
+
+
+/**
+ * Record an update of the given device row; a stale device becomes live again.
+ * @param row The row index of the device.
+ * @param now The local time in milliseconds.
+ */
+void FleetAggregator::touch(const uint32_t row, const uint64_t now) {
+    if (row_stale[row] != 0) {
+        setStale(row, false);
+    }
+    if (row_time[row] != now) {
+        row_time[row] = now;
+        updates.push_back(RowUpdate(row, now));
+    }
+}
+
+
+/**
+ * Mark all devices as stale that have not been updated for the stale time.
+ * @param now The local time in milliseconds.
+ */
+void FleetAggregator::expire(const uint64_t now) {
+    while (updates.empty() == false && now >= updates.front().time && now - updates.front().time >= stale_time) {
+        const RowUpdate update = updates.front();
+        updates.pop_front();
+        // the row has been updated again later, if its update time has changed
+        if (row_time[update.row] == update.time && row_stale[update.row] == 0) {
+            setStale(update.row, true);
+        }
+    }
+}
+
+
+/**
+ * Remove the values of a device row from the column totals or add them again.
+ * @param row The row index of the device.
+ * @param stale True to mark the device as stale, false to mark it as live.
+ */
+void FleetAggregator::setStale(const uint32_t row, const bool stale) {
+    row_stale[row] = (stale ? 1 : 0);
+    for (uint32_t column = 0; column < columns.size(); ++column) {
+        const size_t i = cell(row, column);
+        if (present[i] == 0) {
+            continue;
+        }
+        Column& c = columns[column];
+        const double* v = values.data() + cell(0, column);
+        const double value = values[i];
+        if (stale) {
+            --c.count;
+            ++c.stale;
+            if (c.count == 0) {
+                c.sum.clear();
+            }
+            else {
+                addToSum(column, -value);
+            }
+            c.min_heap.remove(v, row);
+            c.max_heap.remove(v, row);
+        }
+        else {
+            --c.stale;
+            ++c.count;
+            addToSum(column, value);
+            c.min_heap.insert(v, row);
+            c.max_heap.insert(v, row);
+        }
+    }
+}
+
+
+/**
+ * Insert a row into the heap.
+ * @param values The values of the column by row index.
+ * @param row The row index.
+ */
+void FleetAggregator::ColumnHeap::insert(const double* values, const uint32_t row) {
+    heap.push_back(row);
+    siftUp(values, heap.size() - 1);
+}
+
+
+/**
+ * Remove a row from the heap; the last row of the heap takes its position and is moved up or down.
+ * @param values The values of the column by row index.
+ * @param row The row index.
+ */
+void FleetAggregator::ColumnHeap::remove(const double* values, const uint32_t row) {
+    const uint32_t i = position[row];
+    const uint32_t last = heap.back();
+    heap.pop_back();
+    position[row] = none;
+    if (i < heap.size()) {
+        heap[i] = last;
+        position[last] = i;
+        update(values, last);
+    }
+}
+
+
+/**
+ * Restore the heap order after the value of a row has been changed.
+ * @param values The values of the column by row index.
+ * @param row The row index.
+ */
+void FleetAggregator::ColumnHeap::update(const double* values, const uint32_t row) {
+    const size_t i = position[row];
+    if (siftUp(values, i) == i) {
+        siftDown(values, i);
+    }
+}
+
+
+/**
+ * Move the row at the given heap position towards the top, until its parent is ordered before it.
+ * @param values The values of the column by row index.
+ * @param i The heap position.
+ * @return The new heap position of the row.
+ */
+size_t FleetAggregator::ColumnHeap::siftUp(const double* values, size_t i) {
+    const uint32_t row = heap[i];
+    while (i > 0) {
+        const size_t parent = (i - 1) / 2;
+        if (before(values, row, heap[parent]) == false) {
+            break;
+        }
+        heap[i] = heap[parent];
+        position[heap[i]] = (uint32_t)i;
+        i = parent;
+    }
+    heap[i] = row;
+    position[row] = (uint32_t)i;
+    return i;
+}
+
+
+/**
+ * Move the row at the given heap position towards the bottom, until no child is ordered before it.
+ * @param values The values of the column by row index.
+ * @param i The heap position.
+ * @return The new heap position of the row.
+ */
+size_t FleetAggregator::ColumnHeap::siftDown(const double* values, size_t i) {
+    const uint32_t row = heap[i];
+    const size_t n = heap.size();
+    for (size_t child = 2 * i + 1; child < n; child = 2 * i + 1) {
+        if (child + 1 < n && before(values, heap[child + 1], heap[child])) {
+            ++child;
+        }
+        if (before(values, heap[child], row) == false) {
+            break;
+        }
+        heap[i] = heap[child];
+        position[heap[i]] = (uint32_t)i;
+        i = child;
+    }
+    heap[i] = row;
+    position[row] = (uint32_t)i;
+    return i;
+}
+
+
+/**
+ * Callback to update the latest value of the given obis data, if it is a registered measurement.
+ * @param device The originating emeter device.
+ * @param element A reference to a received ObisData instance.
+ */
+void FleetAggregator::consume(const SpeedwireDevice& device, ObisData& element) {
+    const int column = findMeasurement(element.toKey());
+    if (column >= 0 && element.measurementValues.getNumberOfElements() > 0) {
+        update(getDeviceRow(device.deviceAddress), (uint32_t)column, element.measurementValues.getNewestElement().value, LocalHost::getTickCountInMs());
+    }
+}
+
+
+/**
+ * Callback to update the latest values of all registered measurements of an emeter packet; the numeric values are
+ * taken from the columnar measurement frame, i.e. string values are skipped. If the measurement frame is truncated,
+ * the values are taken from the frame elements instead.
+ * @param device The originating emeter device.
+ * @param frame A reference to the obis data frame.
+ */
+void FleetAggregator::consume(const SpeedwireDevice& device, const ObisDataFrame& frame) {
+    const uint64_t now = LocalHost::getTickCountInMs();
+    const uint32_t row = getDeviceRow(device.deviceAddress);
+    const MeasurementFrame& measurements = frame.measurements;
+    if (measurements.truncated) {
+        for (const auto& entry : frame) {
+            const int column = findMeasurement(entry.element->toKey());
+            if (column >= 0 && entry.element->measurementValues.value_string.length() == 0) {
+                update(row, (uint32_t)column, entry.value, now);
+            }
+        }
+        endOfObisData(device, frame.time);
+        return;
+    }
+    for (uint32_t i = 0; i < measurements.size; ++i) {
+        const int column = findMeasurement(measurements.slots[i]);
+        if (column >= 0) {
+            update(row, (uint32_t)column, measurements.values[i], now);
+        }
+    }
+    endOfObisData(device, frame.time);
+}
+
+
+/**
+ * Callback to notify that the last obis data in the emeter packet has been processed; stale devices are expired.
+ * @param device The originating emeter device.
+ * @param time The timestamp associated with the just finished emeter packet.
+ */
+void FleetAggregator::endOfObisData(const SpeedwireDevice& /*device*/, const uint32_t /*time*/) {
+    expire(LocalHost::getTickCountInMs());
+}
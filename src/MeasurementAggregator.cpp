@@ -0,0 +1,150 @@
+#include <MeasurementAggregator.hpp>
+#include <SpeedwireTime.hpp>
+using namespace libspeedwire;
+
+
+/**
+ * Constructor.
+ * @param window_length The window length in timestamp units, i.e. ms for emeter and s for inverter measurements.
+ * @param hop_length The time between window ends in timestamp units; 0 or the window length for tumbling windows.
+ */
+MeasurementAggregator::MeasurementAggregator(const uint32_t window_length, const uint32_t hop_length) :
+    window_length(window_length > 0 ? window_length : 1),
+    hop_length((hop_length > 0 && hop_length < window_length) ? hop_length : (window_length > 0 ? window_length : 1)) {
+    reset();
+}
+
+
+/**
+ * Discard all measurements; the next measurement starts a new window.
+ */
+void MeasurementAggregator::reset(void) {
+    has_window = false;
+    window_end = 0;
+    count = 0;
+    sum = 0.0;
+    min = 0.0;
+    max = 0.0;
+    last = 0.0;
+    last_time = 0;
+    samples.clear();
+    minima.clear();
+    maxima.clear();
+    additions_since_rebase = 0;
+}
+
+
+/**
+ * Add a measurement; measurements not newer than the most recent measurement are ignored.
+ * @param value The measurement value.
+ * @param time The measurement time.
+ * @param aggregates The aggregates of all windows closed by this measurement are appended to this vector, oldest first.
+ * @return The number of closed windows, i.e. the number of appended aggregates.
+ */
+size_t MeasurementAggregator::add(const double value, const uint32_t time, std::vector<MeasurementAggregate>& aggregates) {
+    size_t closed = 0;
+    if (has_window == false) {
+        window_end = time + hop_length;
+        has_window = true;
+    }
+    else if (SpeedwireTime::calculateTimeDifference(time, last_time) <= 0) {
+        return 0;
+    }
+    else {
+        // close all windows ending at or before the new measurement; once no kept measurement is left, the remaining
+        // windows are empty and skipped at once
+        while (SpeedwireTime::calculateTimeDifference(time, window_end) >= 0) {
+            if (isSliding()) {
+                evict(window_end - window_length);
+            }
+            if ((isSliding() ? samples.size() : count) > 0) {
+                aggregates.push_back(MeasurementAggregate());
+                emit(aggregates.back());
+                ++closed;
+            }
+            if (isSliding() == false) {
+                count = 0;
+                sum = 0.0;
+            }
+            if (isSliding() && samples.empty() == false) {
+                window_end += hop_length;
+            }
+            else {
+                const uint32_t hops = (uint32_t)SpeedwireTime::calculateTimeDifference(time, window_end) / hop_length + 1;
+                window_end += hops * hop_length;
+            }
+        }
+        if (isSliding()) {
+            evict(window_end - window_length);
+        }
+    }
+
+    // add the measurement to the current window
+    if (isSliding()) {
+        const Sample sample(value, time);
+        samples.push_back(sample);
+        while (minima.empty() == false && minima.back().value >= value) minima.pop_back();
+        minima.push_back(sample);
+        while (maxima.empty() == false && maxima.back().value <= value) maxima.pop_back();
+        maxima.push_back(sample);
+        sum += value;
+        if (++additions_since_rebase >= samples.size()) {
+            rebase();
+        }
+    }
+    else {
+        min = (count == 0 || value < min ? value : min);
+        max = (count == 0 || value > max ? value : max);
+        ++count;
+        sum += value;
+    }
+    last = value;
+    last_time = time;
+    return closed;
+}
+
+
+/**
+ * Remove all measurements before the given start time from a sliding window.
+ * @param start_time The start time of the window.
+ */
+void MeasurementAggregator::evict(const uint32_t start_time) {
+    while (samples.empty() == false && SpeedwireTime::calculateTimeDifference(samples.front().time, start_time) < 0) {
+        const uint32_t time = samples.front().time;
+        sum -= samples.front().value;
+        if (minima.front().time == time) minima.pop_front();
+        if (maxima.front().time == time) maxima.pop_front();
+        samples.pop_front();
+    }
+    if (samples.empty()) {
+        sum = 0.0;      // avoid accumulation of rounding errors
+    }
+}
+
+
+/**
+ * Re-calculate the sum of a sliding window from its kept measurements; this removes accumulated rounding errors.
+ */
+void MeasurementAggregator::rebase(void) {
+    sum = 0.0;
+    for (const auto& sample : samples) {
+        sum += sample.value;
+    }
+    additions_since_rebase = 0;
+}
+
+
+/**
+ * Fill the aggregate of the current window.
+ * @param aggregate The aggregate.
+ */
+void MeasurementAggregator::emit(MeasurementAggregate& aggregate) const {
+    aggregate.start_time = window_end - window_length;
+    aggregate.end_time = window_end;
+    aggregate.count = (uint32_t)(isSliding() ? samples.size() : count);
+    aggregate.mean = sum / aggregate.count;
+    aggregate.min = (isSliding() ? minima.front().value : min);
+    aggregate.max = (isSliding() ? maxima.front().value : max);
+    aggregate.last = last;
+    aggregate.last_time = last_time;
+}
@@ -0,0 +1,148 @@
+#include <memory.h>         // for memcpy()
+#include <MeasurementFrame.hpp>
+#include <SpeedwireByteEncoding.hpp>
+using namespace libspeedwire;
+
+constexpr size_t MeasurementFrame::capacity;
+constexpr size_t MeasurementFrame::serialized_header_size;
+
+
+/**
+ * Constructor. Creates an empty frame.
+ */
+MeasurementFrame::MeasurementFrame(void) :
+    time(0),
+    type(MeasurementFrameType::OBIS),
+    size(0),
+    truncated(false) {}
+
+
+/**
+ * Initialize the frame for a new packet; all measurements are removed from the frame.
+ * @param device The address of the originating device.
+ * @param time The timestamp of the packet.
+ * @param type The type of the measurement slot ids.
+ */
+void MeasurementFrame::initialize(const SpeedwireAddress& device, const uint32_t time, const MeasurementFrameType type) {
+    this->device = device;
+    this->time = time;
+    this->type = type;
+    this->size = 0;
+    this->truncated = false;
+}
+
+
+/**
+ * Remove all measurements from the frame.
+ */
+void MeasurementFrame::clear(void) {
+    size = 0;
+    truncated = false;
+}
+
+
+/**
+ * Append a measurement to the frame.
+ * @param slot The measurement slot id.
+ * @param value The measurement value.
+ * @return true if the measurement has been added, false if the frame is full.
+ */
+bool MeasurementFrame::add(const uint32_t slot, const double value) {
+    if (size >= capacity) {
+        return false;
+    }
+    slots[size] = slot;
+    values[size] = value;
+    ++size;
+    return true;
+}
+
+
+/**
+ * Find the index of the given measurement slot id in the frame.
+ * @param slot The measurement slot id.
+ * @return The index of the measurement or -1 if the slot id is not part of the frame.
+ */
+int MeasurementFrame::find(const uint32_t slot) const {
+    for (uint32_t i = 0; i < size; ++i) {
+        if (slots[i] == slot) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+
+/**
+ * Get the number of bytes needed to serialize this frame.
+ * @return The size of the serialized frame in bytes.
+ */
+size_t MeasurementFrame::getSerializedSize(void) const {
+    return serialized_header_size + size * (sizeof(uint32_t) + sizeof(uint64_t));
+}
+
+
+/**
+ * Serialize this frame into the given buffer.
+ * @param buffer Pointer to the destination buffer.
+ * @param buffer_size Size of the destination buffer in bytes.
+ * @return The number of bytes written to the buffer, or 0 if the buffer is too small.
+ */
+size_t MeasurementFrame::serialize(void* const buffer, const size_t buffer_size) const {
+    const size_t serialized_size = getSerializedSize();
+    if (buffer == NULL || buffer_size < serialized_size) {
+        return 0;
+    }
+    uint8_t* ptr = (uint8_t*)buffer;
+    SpeedwireByteEncoding::setUint16LittleEndian(ptr + 0, device.susyID);
+    SpeedwireByteEncoding::setUint32LittleEndian(ptr + 2, device.serialNumber);
+    SpeedwireByteEncoding::setUint8(ptr + 6, (uint8_t)type);
+    SpeedwireByteEncoding::setUint8(ptr + 7, (truncated ? 0x01 : 0x00));
+    SpeedwireByteEncoding::setUint32LittleEndian(ptr + 8, time);
+    SpeedwireByteEncoding::setUint32LittleEndian(ptr + 12, size);
+    ptr += serialized_header_size;
+    for (uint32_t i = 0; i < size; ++i, ptr += sizeof(uint32_t)) {
+        SpeedwireByteEncoding::setUint32LittleEndian(ptr, slots[i]);
+    }
+    for (uint32_t i = 0; i < size; ++i, ptr += sizeof(uint64_t)) {
+        uint64_t bits;
+        memcpy(&bits, &values[i], sizeof(bits));
+        SpeedwireByteEncoding::setUint64LittleEndian(ptr, bits);
+    }
+    return serialized_size;
+}
+
+
+/**
+ * Deserialize this frame from the given buffer.
+ * @param buffer Pointer to the source buffer.
+ * @param buffer_size Size of the source buffer in bytes.
+ * @return true if the frame has been deserialized, false if the buffer does not contain a valid frame.
+ */
+bool MeasurementFrame::deserialize(const void* const buffer, const size_t buffer_size) {
+    if (buffer == NULL || buffer_size < serialized_header_size) {
+        return false;
+    }
+    const uint8_t* ptr = (const uint8_t*)buffer;
+    const uint32_t n = SpeedwireByteEncoding::getUint32LittleEndian(ptr + 12);
+    const uint8_t t = SpeedwireByteEncoding::getUint8(ptr + 6);
+    if (n > capacity || t > (uint8_t)MeasurementFrameType::SPEEDWIRE ||
+        buffer_size < serialized_header_size + n * (sizeof(uint32_t) + sizeof(uint64_t))) {
+        return false;
+    }
+    device.susyID       = SpeedwireByteEncoding::getUint16LittleEndian(ptr + 0);
+    device.serialNumber = SpeedwireByteEncoding::getUint32LittleEndian(ptr + 2);
+    type = (MeasurementFrameType)t;
+    truncated = ((SpeedwireByteEncoding::getUint8(ptr + 7) & 0x01) != 0);
+    time = SpeedwireByteEncoding::getUint32LittleEndian(ptr + 8);
+    size = n;
+    ptr += serialized_header_size;
+    for (uint32_t i = 0; i < size; ++i, ptr += sizeof(uint32_t)) {
+        slots[i] = SpeedwireByteEncoding::getUint32LittleEndian(ptr);
+    }
+    for (uint32_t i = 0; i < size; ++i, ptr += sizeof(uint64_t)) {
+        uint64_t bits = SpeedwireByteEncoding::getUint64LittleEndian(ptr);
+        memcpy(&values[i], &bits, sizeof(bits));
+    }
+    return true;
+}
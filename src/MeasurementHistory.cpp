@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <MeasurementHistory.hpp>
+#include <SpeedwireTime.hpp>
+using namespace libspeedwire;
+
+
+// check if the given bucket overlaps with the given time interval
+static bool overlaps(const MeasurementBucket& bucket, const uint32_t duration, const uint32_t from, const uint32_t to) {
+    return (SpeedwireTime::calculateTimeDifference(bucket.start_time + duration, from) > 0 &&
+            SpeedwireTime::calculateTimeDifference(bucket.start_time, to) <= 0);
+}
+
+
+/**
+ * Add a measurement to the open bucket of this tier; if the measurement belongs to a new bucket, the open bucket
+ * is completed first.
+ * @param value The measurement value.
+ * @param time The measurement time.
+ * @param time64 The measurement time expanded to unix epoch time in timestamp units; buckets are aligned in this time.
+ */
+void MeasurementHistoryTier::addMeasurement(const double value, const uint32_t time, const uint64_t time64) {
+    const uint32_t start_time = time - (uint32_t)(time64 % duration);
+    if (current.count > 0 && current.start_time == start_time) {
+        current.add(value, time);
+        return;
+    }
+    if (current.count > 0) {
+        buckets.addNewElement(current);
+    }
+    current = MeasurementBucket(start_time, value, time);
+}
+
+
+/**
+ * Remove all buckets from this tier.
+ */
+void MeasurementHistoryTier::clear(void) {
+    buckets.clear();
+    current = MeasurementBucket();
+}
+
+
+/**
+ * Add a rollup tier; tiers are kept sorted by increasing bucket duration.
+ * @param bucket_duration The bucket duration in timestamp units, i.e. ms for emeter and s for inverter data.
+ * @param capacity The maximum number of completed buckets kept in the tier.
+ */
+void MeasurementHistory::addTier(const uint32_t bucket_duration, const size_t capacity) {
+    if (bucket_duration == 0) {
+        return;
+    }
+    MeasurementHistoryTier tier(bucket_duration, capacity);
+    auto pos = std::upper_bound(tiers.begin(), tiers.end(), bucket_duration,
+                                [](const uint32_t d, const MeasurementHistoryTier& t) { return d < t.duration; });
+    tiers.insert(pos, tier);
+}
+
+
+/**
+ * Add a measurement to all rollup tiers; the first timestamp after construction or clear() is expanded with
+ * respect to the current unix epoch time.
+ * @param value The measurement value.
+ * @param time The measurement time.
+ */
+void MeasurementHistory::addMeasurement(const double value, const uint32_t time) {
+    addMeasurement(value, time, (has_time ? 0 : LocalHost::getUnixEpochTimeInMs()));
+}
+
+
+/**
+ * Add a measurement to all rollup tiers.
+ * @param value The measurement value.
+ * @param time The measurement time.
+ * @param unix_epoch_time_in_ms The current unix epoch time; it is only used to expand the first timestamp to 64 bits.
+ */
+void MeasurementHistory::addMeasurement(const double value, const uint32_t time, const uint64_t unix_epoch_time_in_ms) {
+    if (has_time == false) {
+        if (time_base == MeasurementTimeBase::INVERTER_S) {
+            last_time64 = SpeedwireTime::convertInverterTimeToUnixEpochTime(time, unix_epoch_time_in_ms) / 1000;
+        }
+        else {
+            last_time64 = SpeedwireTime::convertEmeterTimeToUnixEpochTime(time, unix_epoch_time_in_ms);
+        }
+        has_time = true;
+    }
+    else {
+        last_time64 += (int64_t)SpeedwireTime::calculateTimeDifference(time, last_time);
+    }
+    last_time = time;
+    for (auto& tier : tiers) {
+        tier.addMeasurement(value, time, last_time64);
+    }
+}
+
+
+/**
+ * Remove all buckets from all rollup tiers; the tier configuration is kept.
+ */
+void MeasurementHistory::clear(void) {
+    for (auto& tier : tiers) {
+        tier.clear();
+    }
+    has_time = false;
+}
+
+
+/**
+ * Find the coarsest rollup tier with a bucket duration not exceeding the given resolution.
+ * @param resolution The requested resolution in timestamp units.
+ * @return Pointer to the tier, or NULL if the requested resolution is finer than the finest tier.
+ */
+const MeasurementHistoryTier* MeasurementHistory::findTier(const uint32_t resolution) const {
+    const MeasurementHistoryTier* result = NULL;
+    for (const auto& tier : tiers) {
+        if (tier.duration <= resolution) {
+            result = &tier;
+        }
+    }
+    return result;
+}
+
+
+/**
+ * Find the coarsest rollup tier with a bucket duration not exceeding the given resolution, that covers the given
+ * start time. Coarse tiers may cover less time than finer tiers, e.g. if they have a small capacity; then the next
+ * finer tier is tried. If no tier covers the start time, the tier reaching back furthest is returned.
+ * @param resolution The requested resolution in timestamp units.
+ * @param from The start of the requested time interval.
+ * @return Pointer to the tier, or NULL if the requested resolution is finer than the finest tier.
+ */
+const MeasurementHistoryTier* MeasurementHistory::findTier(const uint32_t resolution, const uint32_t from) const {
+    const MeasurementHistoryTier* result = NULL;
+    for (size_t i = tiers.size(); i > 0; --i) {
+        const MeasurementHistoryTier& tier = tiers[i - 1];
+        if (tier.duration > resolution) {
+            continue;
+        }
+        if (tier.isEmpty()) {
+            if (result == NULL) result = &tier;
+            continue;
+        }
+        if (SpeedwireTime::calculateTimeDifference(tier.getOldestStartTime(), from) <= 0) {
+            return &tier;
+        }
+        if (result == NULL || result->isEmpty() ||
+            SpeedwireTime::calculateTimeDifference(tier.getOldestStartTime(), result->getOldestStartTime()) < 0) {
+            result = &tier;
+        }
+    }
+    return result;
+}
+
+
+/**
+ * Get all buckets of the coarsest rollup tier satisfying the given resolution and covering the given time interval,
+ * that overlap with the given time interval, see findTier(). The open bucket of the tier is included.
+ * @param from The start of the time interval.
+ * @param to The end of the time interval; it is included.
+ * @param resolution The requested resolution in timestamp units.
+ * @param result The buckets in increasing time order.
+ * @return The number of buckets; 0 if there is no suitable tier.
+ */
+size_t MeasurementHistory::query(const uint32_t from, const uint32_t to, const uint32_t resolution, std::vector<MeasurementBucket>& result) const {
+    result.clear();
+    const MeasurementHistoryTier* tier = findTier(resolution, from);
+    if (tier == NULL) {
+        return 0;
+    }
+    for (size_t i = 0; i < tier->buckets.getNumberOfElements(); ++i) {
+        const MeasurementBucket& bucket = tier->buckets.at(i);
+        if (overlaps(bucket, tier->duration, from, to)) {
+            result.push_back(bucket);
+        }
+    }
+    if (tier->current.count > 0 && overlaps(tier->current, tier->duration, from, to)) {
+        result.push_back(tier->current);
+    }
+    return result.size();
+}
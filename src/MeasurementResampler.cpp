@@ -0,0 +1,131 @@
+#include <MeasurementResampler.hpp>
+#include <SpeedwireTime.hpp>
+using namespace libspeedwire;
+
+
+/**
+ * Constructor.
+ * @param mode The interpolation method used to calculate values at grid times.
+ */
+MeasurementResampler::MeasurementResampler(const ResamplingMode mode) :
+    mode(mode) {}
+
+
+/**
+ * Register a measurement series; the series becomes the next column of the result matrix.
+ * @param values Reference to the measurement series; it must stay alive while this resampler is used.
+ * @param time_base The time base of the timestamps of the measurement series.
+ * @return The column index of the series in the result matrix.
+ */
+size_t MeasurementResampler::addSeries(const MeasurementValues& values, const MeasurementTimeBase time_base) {
+    series.push_back(Series(values, time_base));
+    return series.size() - 1;
+}
+
+
+/**
+ * Remove all registered measurement series and the result of the last call to resample().
+ */
+void MeasurementResampler::clearSeries(void) {
+    series.clear();
+    grid_times.clear();
+    matrix.clear();
+}
+
+
+/**
+ * Resample all registered measurement series onto a common time grid.
+ * The grid consists of all multiples of the given period that lie within the time interval covered by all series.
+ * @param period_in_ms The grid period in milliseconds.
+ * @param unix_epoch_time_in_ms The current unix epoch time in milliseconds; it is used to expand the 32-bit timestamps.
+ * @return The number of grid times, i.e. the number of rows of the result matrix; 0 if the series do not overlap.
+ */
+size_t MeasurementResampler::resample(const uint64_t period_in_ms, const uint64_t unix_epoch_time_in_ms) {
+    const size_t num_series = series.size();
+    grid_times.clear();
+    matrix.clear();
+    if (num_series == 0 || period_in_ms == 0) {
+        return 0;
+    }
+
+    // expand the timestamps of all series and determine the time interval covered by all series
+    expanded_offsets.resize(num_series + 1);
+    expanded_offsets[0] = 0;
+    for (size_t i = 0; i < num_series; ++i) {
+        const size_t num_values = series[i].values->getNumberOfElements();
+        if (num_values == 0) {
+            return 0;
+        }
+        expanded_offsets[i + 1] = expanded_offsets[i] + num_values;
+    }
+    expanded_times.resize(expanded_offsets[num_series]);
+    uint64_t start_time = 0;
+    uint64_t end_time = UINT64_MAX;
+    for (size_t i = 0; i < num_series; ++i) {
+        uint64_t* const times = expanded_times.data() + expanded_offsets[i];
+        const size_t last = expanded_offsets[i + 1] - expanded_offsets[i] - 1;
+        expandTimes(series[i], unix_epoch_time_in_ms, times);
+        if (times[0] > start_time) start_time = times[0];
+        if (times[last] < end_time) end_time = times[last];
+    }
+    if (start_time > end_time) {
+        return 0;
+    }
+
+    // set up the time grid
+    for (uint64_t time = ((start_time + period_in_ms - 1) / period_in_ms) * period_in_ms; time <= end_time; time += period_in_ms) {
+        grid_times.push_back(time);
+    }
+    const size_t num_times = grid_times.size();
+    matrix.resize(num_times * num_series);
+
+    // merge the grid with each series; the series index only moves forward, as both are sorted by time
+    for (size_t i = 0; i < num_series; ++i) {
+        const MeasurementValues& values = *series[i].values;
+        const uint64_t* const times = expanded_times.data() + expanded_offsets[i];
+        const size_t num_values = expanded_offsets[i + 1] - expanded_offsets[i];
+        size_t index = 0;
+        double* result = matrix.data() + i;
+        for (size_t t = 0; t < num_times; ++t, result += num_series) {
+            const uint64_t time = grid_times[t];
+            while (index + 1 < num_values && times[index + 1] <= time) {
+                ++index;
+            }
+            const double value = values.at(index).value;
+            if (mode == ResamplingMode::LINEAR && index + 1 < num_values && times[index + 1] > times[index]) {
+                const double next_value = values.at(index + 1).value;
+                const double fraction = (double)(time - times[index]) / (double)(times[index + 1] - times[index]);
+                *result = value + fraction * (next_value - value);
+            }
+            else {
+                *result = value;
+            }
+        }
+    }
+    return num_times;
+}
+
+
+/**
+ * Expand the 32-bit timestamps of the given series to 64-bit unix epoch times in milliseconds.
+ * The newest timestamp is expanded with respect to the given epoch time; all older timestamps are derived from
+ * signed differences to their successor, such that timer wrap arounds inside the series are handled correctly.
+ * @param s The measurement series.
+ * @param unix_epoch_time_in_ms The current unix epoch time in milliseconds.
+ * @param times Pointer to the destination array with room for all timestamps of the series.
+ */
+void MeasurementResampler::expandTimes(const Series& s, const uint64_t unix_epoch_time_in_ms, uint64_t* const times) const {
+    const MeasurementValues& values = *s.values;
+    const size_t last = values.getNumberOfElements() - 1;
+    const int64_t scale = (s.time_base == MeasurementTimeBase::INVERTER_S ? 1000 : 1);
+    if (s.time_base == MeasurementTimeBase::INVERTER_S) {
+        times[last] = SpeedwireTime::convertInverterTimeToUnixEpochTime(values.at(last).time, unix_epoch_time_in_ms);
+    }
+    else {
+        times[last] = SpeedwireTime::convertEmeterTimeToUnixEpochTime(values.at(last).time, unix_epoch_time_in_ms);
+    }
+    for (size_t i = last; i > 0; --i) {
+        const int64_t diff = SpeedwireTime::calculateTimeDifference(values.at(i).time, values.at(i - 1).time);
+        times[i - 1] = times[i] - diff * scale;
+    }
+}
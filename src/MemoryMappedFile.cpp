@@ -0,0 +1,225 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+#include <MemoryMappedFile.hpp>
+using namespace libspeedwire;
+
+
+/**
+ * Constructor.
+ */
+MemoryMappedFile::MemoryMappedFile(void) :
+    size(0),
+    data(NULL),
+    read_only(false),
+#ifdef _WIN32
+    file_handle(INVALID_HANDLE_VALUE),
+    mapping_handle(NULL)
+#else
+    file_descriptor(-1)
+#endif
+{}
+
+
+/**
+ * Destructor; the mapping is closed.
+ */
+MemoryMappedFile::~MemoryMappedFile(void) {
+    close();
+}
+
+
+/**
+ * Open and map the given file. If the file does not exist, it is created. If the file is smaller than the
+ * given size, it is extended with zero bytes; the existing content of the file is kept.
+ * @param path The file path.
+ * @param size The size of the mapping in bytes; it must be > 0.
+ * @return True on success, false otherwise.
+ */
+bool MemoryMappedFile::open(const std::string& path, const size_t size) {
+    close();
+    if (size == 0) {
+        return false;
+    }
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        perror("CreateFile failure");
+        return false;
+    }
+    LARGE_INTEGER file_size;
+    if (GetFileSizeEx(file, &file_size) == 0 || (uint64_t)file_size.QuadPart < (uint64_t)size) {
+        file_size.QuadPart = (LONGLONG)size;
+        if (SetFilePointerEx(file, file_size, NULL, FILE_BEGIN) == 0 || SetEndOfFile(file) == 0) {
+            perror("SetEndOfFile failure");
+            CloseHandle(file);
+            return false;
+        }
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)size, NULL);
+    if (mapping == NULL) {
+        perror("CreateFileMapping failure");
+        CloseHandle(file);
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (view == NULL) {
+        perror("MapViewOfFile failure");
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    file_handle = file;
+    mapping_handle = mapping;
+    data = (uint8_t*)view;
+#else
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        perror("open failure");
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < (uint64_t)size) {
+        if (ftruncate(fd, (off_t)size) != 0) {
+            perror("ftruncate failure");
+            ::close(fd);
+            return false;
+        }
+    }
+    void* view = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (view == MAP_FAILED) {
+        perror("mmap failure");
+        ::close(fd);
+        return false;
+    }
+    file_descriptor = fd;
+    data = (uint8_t*)view;
+#endif
+    this->path = path;
+    this->size = size;
+    this->read_only = false;
+    return true;
+}
+
+
+/**
+ * Open and map an existing file read-only; the whole file is mapped. The file is neither created nor extended, and
+ * it can be modified concurrently by another process holding a read-write mapping.
+ * @param path The file path.
+ * @return True on success, false if the file does not exist, is empty or cannot be mapped.
+ */
+bool MemoryMappedFile::openReadOnly(const std::string& path) {
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER file_size;
+    if (GetFileSizeEx(file, &file_size) == 0 || file_size.QuadPart <= 0) {
+        CloseHandle(file);
+        return false;
+    }
+    const size_t size = (size_t)file_size.QuadPart;
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL) {
+        perror("CreateFileMapping failure");
+        CloseHandle(file);
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size);
+    if (view == NULL) {
+        perror("MapViewOfFile failure");
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    file_handle = file;
+    mapping_handle = mapping;
+    data = (uint8_t*)view;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+    const size_t size = (size_t)st.st_size;
+    void* view = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (view == MAP_FAILED) {
+        perror("mmap failure");
+        ::close(fd);
+        return false;
+    }
+    file_descriptor = fd;
+    data = (uint8_t*)view;
+#endif
+    this->path = path;
+    this->size = size;
+    this->read_only = true;
+    return true;
+}
+
+
+/**
+ * Unmap and close the file. Modified pages are still written back by the operating system.
+ */
+void MemoryMappedFile::close(void) {
+#ifdef _WIN32
+    if (data != NULL) {
+        UnmapViewOfFile(data);
+    }
+    if (mapping_handle != NULL) {
+        CloseHandle(mapping_handle);
+        mapping_handle = NULL;
+    }
+    if (file_handle != INVALID_HANDLE_VALUE) {
+        CloseHandle(file_handle);
+        file_handle = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (data != NULL) {
+        munmap(data, size);
+    }
+    if (file_descriptor >= 0) {
+        ::close(file_descriptor);
+        file_descriptor = -1;
+    }
+#endif
+    data = NULL;
+    size = 0;
+    read_only = false;
+}
+
+
+/**
+ * Write modified pages back to the file.
+ * @param synchronous If true, wait until the pages are written to the storage device; otherwise just schedule the write back.
+ * @return True on success, false otherwise.
+ */
+bool MemoryMappedFile::flush(const bool synchronous) {
+    if (data == NULL || read_only) {
+        return false;
+    }
+#ifdef _WIN32
+    if (FlushViewOfFile(data, size) == 0) {
+        return false;
+    }
+    return (synchronous == false || FlushFileBuffers(file_handle) != 0);
+#else
+    return (msync(data, size, (synchronous ? MS_SYNC : MS_ASYNC)) == 0);
+#endif
+}
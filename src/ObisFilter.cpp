@@ -10,12 +10,21 @@ ObisFilter::ObisFilter(void) {
 ObisFilter::~ObisFilter(void) {
     filterMap.clear();
     consumerTable.clear();
+    frameConsumerTable.clear();
+    frameElements.clear();
 }
 
+/**
+ *  Add a filter entry. The filter keeps a copy of the given entry, including the capacity of its measurement values and
+ *  whether running statistics are enabled on them; running statistics are opt-in per entry and pay off if consumers
+ *  query estimateMean() or estimateVariance() of the entry for each packet.
+ */
 void ObisFilter::addFilter(const ObisData &entry) {
     ObisData& filter_entry = filterMap[entry.toKey()];
     filter_entry = entry;
     filter_entry.measurementValues.setMaximumNumberOfElements(entry.measurementValues.getMaximumNumberOfElements());
+    filter_entry.measurementValues.setRunningStatistics(entry.measurementValues.hasRunningStatistics());
+    frameElements.reserve(filterMap.size());
 }
 
 void ObisFilter::addFilter(const std::vector<ObisData> &entries) {
@@ -45,6 +54,13 @@ void ObisFilter::addConsumer(ObisConsumer& obisConsumer) {
     consumerTable.push_back(&obisConsumer);
 }
 
+/**
+ *  Add an obis frame consumer to receive the result of the ObisFilter as a single frame per emeter packet.
+ */
+void ObisFilter::addFrameConsumer(ObisFrameConsumer& obisFrameConsumer) {
+    frameConsumerTable.push_back(&obisFrameConsumer);
+}
+
 bool ObisFilter::consume(const SpeedwireDevice& device, const void *const obis, const uint32_t time) {
     ObisType element(SpeedwireEmeterProtocol::getObisChannel(obis),
                      SpeedwireEmeterProtocol::getObisIndex(obis),
@@ -56,6 +72,7 @@ bool ObisFilter::consume(const SpeedwireDevice& device, const void *const obis,
         switch (filteredElement->type) {
         case 0:
             filteredElement->measurementValues.value_string = SpeedwireEmeterProtocol::toValueString(obis, false);
+            frameElements.push_back(ObisDataFrameElement(filteredElement, 0.0, time));
             break;
         case 4:
             filteredElement->addMeasurement((uint32_t)SpeedwireEmeterProtocol::getObisValue4(obis), time);
@@ -69,6 +86,13 @@ bool ObisFilter::consume(const SpeedwireDevice& device, const void *const obis,
         default:
             perror("obis identifier not implemented");
         }
+        if (filteredElement->type == 4 || filteredElement->type == 7 || filteredElement->type == 8) {
+            const TimestampDoublePair& newest = filteredElement->measurementValues.getNewestElement();
+            frameElements.push_back(ObisDataFrameElement(filteredElement, newest.value, newest.time));
+            if (measurementFrame.add(filteredElement->toKey(), newest.value) == false) {
+                measurementFrame.truncated = true;  // frame consumers must fall back to the frame elements, which are complete
+            }
+        }
         produce(device, *filteredElement);
 
         return true;
@@ -91,6 +115,17 @@ void ObisFilter::produce(const SpeedwireDevice& device, ObisData &element) {
 }
 
 void ObisFilter::endOfObisData(const SpeedwireDevice& device, const uint32_t time) {
+    if (frameConsumerTable.size() > 0) {
+        measurementFrame.device = device.deviceAddress;
+        measurementFrame.time = time;
+        measurementFrame.type = MeasurementFrameType::OBIS;
+        const ObisDataFrame frame(frameElements.data(), frameElements.size(), time, measurementFrame);
+        for (std::vector<ObisFrameConsumer*>::iterator it = frameConsumerTable.begin(); it != frameConsumerTable.end(); it++) {
+            (*it)->consume(device, frame);
+        }
+    }
+    frameElements.clear();
+    measurementFrame.clear();
     for (std::vector<ObisConsumer*>::iterator it = consumerTable.begin(); it != consumerTable.end(); it++) {
         (*it)->endOfObisData(device, time);
     }
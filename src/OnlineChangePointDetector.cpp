@@ -0,0 +1,165 @@
+#include <OnlineChangePointDetector.hpp>
+using namespace libspeedwire;
+
+
+/**
+ * Constructor.
+ * @param window_size The sliding window size: -window_size .. 0 .. window_size; it is at least 1.
+ * @param min_three_sigma_squared Change points where 9 * variance is below this value are ignored, i.e. changes in almost noise-free signals.
+ */
+OnlineChangePointDetector::OnlineChangePointDetector(const size_t window_size, const double min_three_sigma_squared) :
+    window_size(window_size > 0 ? window_size : 1),
+    min_three_sigma_squared(min_three_sigma_squared),
+    samples(2 * (window_size > 0 ? window_size : 1) + 3),
+    estimates(2 * (window_size > 0 ? window_size : 1) + 4) {
+    reset();
+}
+
+
+/**
+ * Discard all measurements and restart the detector.
+ */
+void OnlineChangePointDetector::reset(void) {
+    samples.clear();
+    estimates.clear();
+    number_of_samples = 0;
+    number_of_estimates = 0;
+    window_sum = 0.0;
+    window_sq_sum = 0.0;
+    downwards = false;
+    interval_start = 0;
+    interval_start_time = 0;
+    interval_sum = 0.0;
+}
+
+
+/**
+ * Add a measurement to the detector.
+ * @param value The measurement value.
+ * @param time The measurement time.
+ * @param interval If a change point has been confirmed, the finalized interval ending at the change point.
+ * @return True if an interval has been finalized, false otherwise.
+ */
+bool OnlineChangePointDetector::addMeasurement(const double value, const uint32_t time, MeasurementValueInterval& interval) {
+    const size_t k = number_of_samples;
+    const size_t full_window = 2 * window_size + 1;
+
+    // slide the window: remove the value leaving the window and add the new one
+    if (k >= full_window) {
+        const double old_value = samples.at(samples.getNumberOfElements() - full_window).value;
+        window_sum -= old_value;
+        window_sq_sum -= old_value * old_value;
+    }
+    samples.addNewElement(TimestampDoublePair(value, time));
+    window_sum += value;
+    window_sq_sum += value * value;
+    if (k == 0) {
+        interval_start_time = time;
+    }
+    interval_sum += value;
+    ++number_of_samples;
+
+    // the estimate for measurement k - window_size becomes available with a full window; at the start of the stream,
+    // the batch version uses truncated symmetric windows 0 .. 2 * i around measurements i < window_size instead
+    if (k >= full_window - 1) {
+        if ((k & 1023) == 0) {
+            rebaseWindowSums();
+        }
+        addEstimate(full_window);
+        return evaluate(interval);
+    }
+    if ((k & 1) == 0) {
+        addEstimate(k + 1);
+        return evaluate(interval);
+    }
+    return false;
+}
+
+
+/**
+ * Get the open interval, i.e. all measurements after the most recently confirmed change point.
+ * @param interval The open interval.
+ * @return True if there is an open interval, false if no measurements have been added.
+ */
+bool OnlineChangePointDetector::getOpenInterval(MeasurementValueInterval& interval) const {
+    if (number_of_samples == 0) {
+        return false;
+    }
+    const size_t end = number_of_samples - 1;
+    interval = MeasurementValueInterval(interval_start, end, interval_sum / (double)(end - interval_start + 1), 0.0,
+                                        interval_start_time, samples.getNewestElement().time);
+    return true;
+}
+
+
+/**
+ * Calculate the window estimate from the current window sums, in the same way as LineSegmentEstimator::estimateStatistics().
+ * @param n The number of measurements in the window.
+ */
+void OnlineChangePointDetector::addEstimate(const size_t n) {
+    const double mean = window_sum / n;
+    double var = (n <= 1 ? FLT_MAX : (window_sq_sum - mean * window_sum) / (n - 1));
+    if (n > 1) var *= (2 * window_size + 1) / (n - 1);    // even more variance correction for small sample sizes
+    estimates.addNewElement(Estimate(mean, var));
+    ++number_of_estimates;
+}
+
+
+/**
+ * Apply the total variation minimum seeker and the 3-sigma rule to the most recent window estimates.
+ * @param interval The finalized interval, if a change point has been confirmed.
+ * @return True if a change point has been confirmed, false otherwise.
+ */
+bool OnlineChangePointDetector::evaluate(MeasurementValueInterval& interval) {
+    // the batch version evaluates window centers center_1 and center_2 = center_1 + 2 * window_size + 1, together
+    // with their neighbours; the oldest estimate in the ring buffer corresponds to center_1 - 1
+    if (number_of_estimates < 2 * window_size + 4) {
+        return false;
+    }
+    const size_t c1 = 1;
+    const size_t c2 = c1 + 2 * window_size + 1;
+    const double penalty_m1 = estimates.at(c1 - 1).variance + estimates.at(c2 - 1).variance;
+    const double penalty    = estimates.at(c1    ).variance + estimates.at(c2    ).variance;
+    const double penalty_p1 = estimates.at(c1 + 1).variance + estimates.at(c2 + 1).variance;
+
+    downwards = ((penalty < penalty_m1) ? true : ((penalty > penalty_m1) ? false : downwards));
+    if (downwards == false || penalty >= penalty_p1) {
+        return false;
+    }
+
+    // check if mean values differ by more than 3 * sigma, and ignore changes in almost noise-free signals
+    const double mean_diff = estimates.at(c1).mean - estimates.at(c2).mean;
+    const double three_sigma_squared = 9.0 * 0.5 * (estimates.at(c1).variance + estimates.at(c2).variance);
+    if (mean_diff * mean_diff <= three_sigma_squared || three_sigma_squared <= min_three_sigma_squared) {
+        return false;
+    }
+
+    // the change point is the last measurement before the change; samples holds the change point and all 2 * window_size + 2
+    // measurements after it
+    const size_t change_index = number_of_samples - 1 - (2 * window_size + 2);
+    double tail_sum = 0.0;
+    for (size_t i = 1; i < samples.getNumberOfElements(); ++i) {
+        tail_sum += samples.at(i).value;
+    }
+    interval = MeasurementValueInterval(interval_start, change_index, (interval_sum - tail_sum) / (double)(change_index - interval_start + 1), 0.0,
+                                        interval_start_time, samples.at(0).time);
+    interval_start = change_index + 1;
+    interval_start_time = samples.at(1).time;
+    interval_sum = tail_sum;
+    return true;
+}
+
+
+/**
+ * Re-calculate the sliding window sums from scratch to avoid accumulation of rounding errors.
+ */
+void OnlineChangePointDetector::rebaseWindowSums(void) {
+    const size_t full_window = 2 * window_size + 1;
+    window_sum = 0.0;
+    window_sq_sum = 0.0;
+    for (size_t i = samples.getNumberOfElements() - full_window; i < samples.getNumberOfElements(); ++i) {
+        const double value = samples.at(i).value;
+        window_sum += value;
+        window_sq_sum += value * value;
+    }
+}
@@ -0,0 +1,356 @@
+#include <cstring>
+#include <SharedMeasurementSnapshot.hpp>
+using namespace libspeedwire;
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "lock-free 32-bit atomics are required for inter-process seqlocks");
+
+
+// get the slot at the given index of the slot table
+static inline const SharedSnapshotSlot* getSlot(const SharedSnapshotHeader* header, const uint32_t slot_size, const uint32_t index) {
+    return (const SharedSnapshotSlot*)((const uint8_t*)(header + 1) + (size_t)index * slot_size);
+}
+
+// calculate the preferred slot index of the given series
+static inline uint32_t hashSlot(const uint32_t serial_number, const uint32_t key, const uint32_t number_of_slots) {
+    return ((serial_number * 0x9E3779B1u) ^ (key * 0x85EBCA6Bu)) % number_of_slots;
+}
+
+// copy a slot consistently; the given copy function is retried until no concurrent modification was observed
+template<class F> static inline bool readSlot(const SharedSnapshotSlot* slot, F copy) {
+    for (int retry = 0; retry < 10000; ++retry) {
+        const uint32_t sequence = slot->sequence.load(std::memory_order_acquire);
+        if ((sequence & 1) != 0) {
+            continue;
+        }
+        copy();
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot->sequence.load(std::memory_order_relaxed) == sequence) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/**
+ * Constructor.
+ */
+SharedMeasurementPublisher::SharedMeasurementPublisher(void) : header(NULL) {}
+
+
+/**
+ * Open and initialize the shared memory region. Any previous content of the region is discarded; the region
+ * generation is incremented, such that open readers detect the re-initialization.
+ * @param path The path of the region file, e.g. "/dev/shm/speedwire" on Linux.
+ * @param number_of_slots The number of slots; it limits the number of (device, measurement) series that can be published.
+ * @param ring_size The number of recent values kept per series in addition to the latest value.
+ * @return True on success, false otherwise.
+ */
+bool SharedMeasurementPublisher::open(const std::string& path, const uint32_t number_of_slots, const uint32_t ring_size) {
+    close();
+    if (number_of_slots == 0) {
+        return false;
+    }
+    const uint32_t slot_size = (uint32_t)(sizeof(SharedSnapshotSlot) + ring_size * sizeof(SharedSnapshotEntry));
+    const size_t size = sizeof(SharedSnapshotHeader) + (size_t)number_of_slots * slot_size;
+    if (file.open(path, size) == false) {
+        return false;
+    }
+    header = (SharedSnapshotHeader*)file.getData();
+    header->magic = 0;
+    std::atomic_thread_fence(std::memory_order_release);
+    memset(file.getData() + sizeof(SharedSnapshotHeader), 0, size - sizeof(SharedSnapshotHeader));
+    header->version = SharedSnapshotHeader::version_value;
+    header->number_of_slots = number_of_slots;
+    header->ring_size = ring_size;
+    header->slot_size = slot_size;
+    header->generation = header->generation + 1;
+    header->reserved[0] = header->reserved[1] = 0;
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = SharedSnapshotHeader::magic_value;
+    return true;
+}
+
+
+/**
+ * Close the shared memory region; the region file is kept, such that readers can still access the last values.
+ */
+void SharedMeasurementPublisher::close(void) {
+    file.close();
+    header = NULL;
+}
+
+
+/**
+ * Find the slot of the given series using linear probing.
+ * @param serial_number The device serial number.
+ * @param key The measurement key.
+ * @param insert If true, an unused slot is claimed for the series if it is not yet in the slot table.
+ * @return Pointer to the slot, or NULL if the series is not found and no slot could be claimed.
+ */
+SharedSnapshotSlot* SharedMeasurementPublisher::findSlot(const uint32_t serial_number, const uint32_t key, const bool insert) {
+    const uint32_t n = header->number_of_slots;
+    uint32_t index = hashSlot(serial_number, key, n);
+    for (uint32_t i = 0; i < n; ++i) {
+        SharedSnapshotSlot* slot = (SharedSnapshotSlot*)getSlot(header, header->slot_size, index);
+        if (slot->used == 0) {
+            if (insert == false) {
+                return NULL;
+            }
+            const uint32_t sequence = slot->sequence.load(std::memory_order_relaxed);
+            slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            slot->serial_number = serial_number;
+            slot->key = key;
+            slot->used = 1;
+            slot->sequence.store(sequence + 2, std::memory_order_release);
+            return slot;
+        }
+        if (slot->serial_number == serial_number && slot->key == key) {
+            return slot;
+        }
+        if (++index >= n) {
+            index = 0;
+        }
+    }
+    return NULL;
+}
+
+
+/**
+ * Publish a measurement value of the given series.
+ * @param serial_number The device serial number.
+ * @param key The measurement key, i.e. ObisData::toKey() or SpeedwireData::toKey().
+ * @param value The measurement value.
+ * @param time The measurement time.
+ * @return True on success, false if the region is not open or the slot table is full.
+ */
+bool SharedMeasurementPublisher::publish(const uint32_t serial_number, const uint32_t key, const double value, const uint32_t time) {
+    if (header == NULL) {
+        return false;
+    }
+    SharedSnapshotSlot* slot = findSlot(serial_number, key, true);
+    if (slot == NULL) {
+        return false;
+    }
+    const uint32_t sequence = slot->sequence.load(std::memory_order_relaxed);
+    slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot->latest.value = value;
+    slot->latest.time = time;
+    const uint32_t ring_size = header->ring_size;
+    if (ring_size > 0) {
+        SharedSnapshotEntry& entry = slot->getRing()[slot->ring_write_pointer];
+        entry.value = value;
+        entry.time = time;
+        if (++slot->ring_write_pointer >= ring_size) {
+            slot->ring_write_pointer = 0;
+        }
+        if (slot->ring_count < ring_size) {
+            ++slot->ring_count;
+        }
+    }
+    slot->sequence.store(sequence + 2, std::memory_order_release);
+    return true;
+}
+
+
+/**
+ * Callback to publish the given obis data.
+ * @param device The originating emeter device.
+ * @param element The obis data.
+ */
+void SharedMeasurementPublisher::consume(const SpeedwireDevice& device, ObisData& element) {
+    if (element.measurementValues.getNumberOfElements() > 0) {
+        const TimestampDoublePair newest = element.measurementValues.getNewestElement();
+        publish(device.deviceAddress.serialNumber, element.toKey(), newest.value, newest.time);
+    }
+}
+
+
+/**
+ * Callback to publish all obis data of an emeter packet.
+ * @param device The originating emeter device.
+ * @param frame The obis data frame.
+ */
+void SharedMeasurementPublisher::consume(const SpeedwireDevice& device, const ObisDataFrame& frame) {
+    for (const auto& entry : frame) {
+        if (entry.element->measurementValues.value_string.length() == 0) {
+            publish(device.deviceAddress.serialNumber, entry.element->toKey(), entry.value, entry.time);
+        }
+    }
+}
+
+
+/**
+ * Callback to publish the given speedwire data.
+ * @param device The originating inverter device.
+ * @param element The speedwire data.
+ */
+void SharedMeasurementPublisher::consume(const SpeedwireDevice& device, SpeedwireData& element) {
+    if (element.measurementValues.getNumberOfElements() > 0) {
+        const TimestampDoublePair newest = element.measurementValues.getNewestElement();
+        publish(device.deviceAddress.serialNumber, element.toKey(), newest.value, newest.time);
+    }
+}
+
+
+/**
+ * Constructor.
+ */
+SharedMeasurementReader::SharedMeasurementReader(void) : header(NULL), number_of_slots(0), ring_size(0), slot_size(0), generation(0) {}
+
+
+/**
+ * Open an existing shared memory region read-only; the region geometry is copied, such that later changes by a
+ * restarted publisher cannot make the reader index beyond its mapping.
+ * @param path The path of the region file.
+ * @return True on success, false if the file does not exist or does not hold an initialized region.
+ */
+bool SharedMeasurementReader::open(const std::string& path) {
+    close();
+    if (file.openReadOnly(path) == false) {
+        return false;
+    }
+    const size_t size = file.getSize();
+    if (size < sizeof(SharedSnapshotHeader)) {
+        file.close();
+        return false;
+    }
+    const SharedSnapshotHeader* h = (const SharedSnapshotHeader*)file.getData();
+    const uint32_t h_magic = h->magic;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    number_of_slots = h->number_of_slots;
+    ring_size = h->ring_size;
+    slot_size = h->slot_size;
+    generation = h->generation;
+    const bool valid = (h_magic == SharedSnapshotHeader::magic_value &&
+                        h->version == SharedSnapshotHeader::version_value &&
+                        number_of_slots > 0 &&
+                        (uint64_t)slot_size == sizeof(SharedSnapshotSlot) + (uint64_t)ring_size * sizeof(SharedSnapshotEntry) &&
+                        sizeof(SharedSnapshotHeader) + (uint64_t)number_of_slots * slot_size <= (uint64_t)size);
+    if (valid == false) {
+        close();
+        return false;
+    }
+    header = h;
+    if (isCurrent() == false) {     // re-initialized while copying the geometry
+        close();
+        return false;
+    }
+    return true;
+}
+
+
+/**
+ * Close the shared memory region.
+ */
+void SharedMeasurementReader::close(void) {
+    file.close();
+    header = NULL;
+    number_of_slots = ring_size = slot_size = generation = 0;
+}
+
+
+/**
+ * Check if the region still has the geometry copied at open(), i.e. it has not been re-initialized by a publisher
+ * since; otherwise all reads fail and the reader must be re-opened.
+ * @return True if the region is current, false otherwise.
+ */
+bool SharedMeasurementReader::isCurrent(void) const {
+    if (header == NULL) {
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return (header->magic == SharedSnapshotHeader::magic_value && header->generation == generation);
+}
+
+
+/**
+ * Find the slot of the given series using linear probing.
+ * @param serial_number The device serial number.
+ * @param key The measurement key.
+ * @return Pointer to the slot, or NULL if the series has not been published.
+ */
+const SharedSnapshotSlot* SharedMeasurementReader::findSlot(const uint32_t serial_number, const uint32_t key) const {
+    const uint32_t n = number_of_slots;
+    uint32_t index = hashSlot(serial_number, key, n);
+    for (uint32_t i = 0; i < n; ++i) {
+        const SharedSnapshotSlot* slot = getSlot(header, slot_size, index);
+        uint32_t used = 0, slot_serial_number = 0, slot_key = 0;
+        if (readSlot(slot, [&]() { used = slot->used; slot_serial_number = slot->serial_number; slot_key = slot->key; }) == false || used == 0) {
+            return NULL;
+        }
+        if (slot_serial_number == serial_number && slot_key == key) {
+            return slot;
+        }
+        if (++index >= n) {
+            index = 0;
+        }
+    }
+    return NULL;
+}
+
+
+/**
+ * Read the latest measurement value of the given series.
+ * @param serial_number The device serial number.
+ * @param key The measurement key, i.e. ObisData::toKey() or SpeedwireData::toKey().
+ * @param result The latest measurement value and time.
+ * @return True on success, false if the series has not been published or the region has been re-initialized, see isCurrent().
+ */
+bool SharedMeasurementReader::read(const uint32_t serial_number, const uint32_t key, TimestampDoublePair& result) const {
+    if (isCurrent() == false) {
+        return false;
+    }
+    const SharedSnapshotSlot* slot = findSlot(serial_number, key);
+    if (slot == NULL) {
+        return false;
+    }
+    SharedSnapshotEntry latest;
+    if (readSlot(slot, [&]() { latest = slot->latest; }) == false || isCurrent() == false) {
+        return false;
+    }
+    result = TimestampDoublePair(latest.value, latest.time);
+    return true;
+}
+
+
+/**
+ * Read the recent measurement values of the given series.
+ * @param serial_number The device serial number.
+ * @param key The measurement key, i.e. ObisData::toKey() or SpeedwireData::toKey().
+ * @param result The measurement values from oldest to newest.
+ * @return The number of measurement values; 0 if the series has not been published or the region has been re-initialized, see isCurrent().
+ */
+size_t SharedMeasurementReader::readHistory(const uint32_t serial_number, const uint32_t key, std::vector<TimestampDoublePair>& result) const {
+    result.clear();
+    if (isCurrent() == false) {
+        return 0;
+    }
+    const SharedSnapshotSlot* slot = findSlot(serial_number, key);
+    if (slot == NULL) {
+        return 0;
+    }
+    std::vector<SharedSnapshotEntry> ring(ring_size);
+    uint32_t write_pointer = 0, count = 0;
+    const bool success = readSlot(slot, [&]() {
+        write_pointer = slot->ring_write_pointer;
+        count = slot->ring_count;
+        if (ring_size > 0) {
+            memcpy(ring.data(), slot->getRing(), ring_size * sizeof(SharedSnapshotEntry));
+        }
+    });
+    if (success == false || isCurrent() == false || count > ring_size || write_pointer >= ring_size) {
+        return 0;
+    }
+    result.reserve(count);
+    size_t index = (write_pointer >= count ? write_pointer - count : write_pointer + ring_size - count);
+    for (uint32_t i = 0; i < count; ++i) {
+        result.push_back(TimestampDoublePair(ring[index].value, ring[index].time));
+        if (++index >= ring_size) {
+            index = 0;
+        }
+    }
+    return result.size();
+}
@@ -239,11 +239,10 @@ SpeedwireDevice SpeedwireCommand::queryDeviceType(const SpeedwireDevice& peer, c
                 //LocalHost::hexdump(udp_packet, nbytes);
                 //printf("%s\n", inverter_packet.toString().c_str());
 
-                std::vector<SpeedwireRawData> raw_data_vector = inverter_packet.getRawDataElements();
-
                 // augment the device information with data obtained the peer
-                for (auto& raw_data : raw_data_vector) {
-                    if (raw_data.id == SpeedwireData::InverterDeviceClass.id && (raw_data.type & SpeedwireDataType::TypeMask) == SpeedwireDataType::Status32) {
+                for (const SpeedwireRawDataView& raw_view : inverter_packet.getRawDataViews()) {
+                    if (raw_view.id == SpeedwireData::InverterDeviceClass.id && (raw_view.type & SpeedwireDataType::TypeMask) == SpeedwireDataType::Status32) {
+                        SpeedwireRawData raw_data = raw_view.toRawData();
                         SpeedwireRawDataStatus32 status_data(raw_data);
                         size_t index = status_data.getSelectionIndex();
                         if (index != (size_t)-1) {
@@ -251,7 +250,8 @@ SpeedwireDevice SpeedwireCommand::queryDeviceType(const SpeedwireDevice& peer, c
                             info.deviceClass = libspeedwire::toString(device_class);
                         }
                     }
-                    else if (raw_data.id == SpeedwireData::InverterDeviceType.id && (raw_data.type & SpeedwireDataType::TypeMask) == SpeedwireDataType::Status32) {
+                    else if (raw_view.id == SpeedwireData::InverterDeviceType.id && (raw_view.type & SpeedwireDataType::TypeMask) == SpeedwireDataType::Status32) {
+                        SpeedwireRawData raw_data = raw_view.toRawData();
                         SpeedwireRawDataStatus32 status_data(raw_data);
                         size_t index = status_data.getSelectionIndex();
                         if (index != (size_t)-1) {
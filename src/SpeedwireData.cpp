@@ -1,5 +1,6 @@
 #define  _CRT_SECURE_NO_WARNINGS (1)
 #include <memory.h>
+#include <algorithm>
 #include <time.h>
 #include <SpeedwireByteEncoding.hpp>
 #include <SpeedwireData.hpp>
@@ -106,15 +107,21 @@ std::string SpeedwireRawData::toHexString(void) const {
 std::string SpeedwireRawData::toString(void) const {
     // check if this raw data element is one of the predefined elements, if so get description string 
     std::string description = "unknown";
-    const SpeedwireDataMap &data_map = SpeedwireDataMap::getGlobalMap();
-    auto iterator = data_map.find(toKey());
-    if (conn == 0x7 && iterator == data_map.end()) {
-        // battery connection id is 0x7, however some definitions are identical to inverter connection id 0x1, check if this can be used
-        iterator = data_map.find(toKey() ^ 0x6);
+    // battery connection id is 0x7, however some definitions are identical to inverter connection id 0x1; the index resolves both
+    const SpeedwireData* definition = SpeedwireDataIndex::getPredefinedIndex().find(toKey());
+    if (definition != NULL) {
+        description = definition->name;
     }
-    if (iterator != data_map.end()) {
-        description = iterator->second.name;
-        //unsigned long divisor = iterator->second.measurementType.divisor;
+    else {
+        // definitions added at runtime are only known to the global map
+        const SpeedwireDataMap& data_map = SpeedwireDataMap::getGlobalMap();
+        auto iterator = data_map.find(toKey());
+        if (conn == 0x7 && iterator == data_map.end()) {
+            iterator = data_map.find(toKey() ^ 0x6);
+        }
+        if (iterator != data_map.end()) {
+            description = iterator->second.name;
+        }
     }
 
     // assemble a string from the header fields
@@ -581,15 +588,74 @@ SpeedwireData::SpeedwireData(void) :
  *  @result true if the data was successfuly consumed, false otherwise
  */
 bool SpeedwireData::consume(const SpeedwireRawData& data) {
-    if (!isSameSignature(data)) return false;
-    if (data.data == NULL || data.data_size < 20) return false;
+    if (!matches(data)) return false;
+    return consumeValue(data.data, data.data_size, data.time);
+}
+
+
+/**
+ *  Consume the value and timer of the given inverter raw data view into this instance.
+ *  @param data The SpeedwireRawDataView instance to be consumed into this instance
+ *  @result true if the data was successfuly consumed, false otherwise
+ */
+bool SpeedwireData::consume(const SpeedwireRawDataView& data) {
+    if (!matches(data)) return false;
+    return consumeValue(data.data, data.getPayloadSize(), data.time);
+}
+
+
+/**
+ *  Check if the given inverter raw data belongs to this instance.
+ *  @param data The SpeedwireRawData instance
+ *  @result true if the data belongs to this instance, false otherwise
+ */
+bool SpeedwireData::matches(const SpeedwireRawData& data) const {
+    return matches(data.command, data.id, data.conn, data.type);
+}
+
+
+/**
+ *  Check if the given inverter raw data view belongs to this instance.
+ *  @param data The SpeedwireRawDataView instance
+ *  @result true if the data belongs to this instance, false otherwise
+ */
+bool SpeedwireData::matches(const SpeedwireRawDataView& data) const {
+    return matches(data.command, data.id, data.conn, data.type);
+}
+
+
+/**
+ *  Check if the given signature belongs to this instance. This is the single matching rule for raw data, raw data
+ *  views and ingest plans. Register id, connector id and type must be identical; command ids must be identical except
+ *  for the request type bits, which distinguish queries and responses.
+ *  @param command The command id
+ *  @param id The register id
+ *  @param conn The connector id
+ *  @param type The data type
+ *  @result true if the signature belongs to this instance, false otherwise
+ */
+bool SpeedwireData::matches(const Command command, const uint32_t id, const uint8_t conn, const SpeedwireDataType type) const {
+    return ((((uint32_t)this->command ^ (uint32_t)command) & ~(uint32_t)Command::REQUEST_TYPE_MASK) == 0 && this->id == id && this->conn == conn && this->type == type);
+}
+
+
+/**
+ *  Consume the given payload data and timer into this instance. The payload is interpreted according to the
+ *  register id and type of this instance; the caller is responsible for checking that the payload belongs to this
+ *  instance, e.g. by comparing signatures.
+ *  @param data Pointer to the payload data bytes
+ *  @param data_size Size of the payload data in bytes
+ *  @param data_time Timestamp of the payload data
+ *  @result true if the data was successfuly consumed, false otherwise
+ */
+bool SpeedwireData::consumeValue(const uint8_t* const data, const size_t data_size, const time_t data_time) {
+    if (data == NULL || data_size < 20) return false;
 
     switch (type & SpeedwireDataType::TypeMask) {
 
     case SpeedwireDataType::Signed32: {
-        SpeedwireRawDataSigned32 rd((SpeedwireRawData&)data);
-        int32_t value = rd.getValue(0);
-        if (rd.isNanValue(value)) value = 0;  // received during darkness: NaN value is 0x80000000
+        int32_t value = (int32_t)SpeedwireByteEncoding::getUint32LittleEndian(data);
+        if (value == SpeedwireRawDataSigned32::nan) value = 0;  // received during darkness: NaN value is 0x80000000
 #if 0   // simulate some values for debugging
         if (id == 0x00251e00) value = 0x57;
         if (id == 0x00451f00) value = 0x6105;
@@ -599,31 +665,37 @@ bool SpeedwireData::consume(const SpeedwireRawData& data) {
         if (id == 0x00464b00 || id == 0x00464c00 || id == 0x00464d00) value = 0x9b3c;
         if (id == 0x00465300 || id == 0x00465400 || id == 0x00465500) value = 0x011e;
 #endif
-        addMeasurement(value, (uint32_t)data.time);
-        time = data.time;
+        addMeasurement(value, (uint32_t)data_time);
+        time = data_time;
         break;
     }
 
     case SpeedwireDataType::Unsigned32: {
-        SpeedwireRawDataUnsigned32 rd((SpeedwireRawData&)data);
-        int32_t value = rd.getValue(0);
-        if (rd.isNanValue(value)) value = 0;  // received during darkness: NaN value is 0xffffffff
-        addMeasurement(value, (uint32_t)data.time);
-        time = data.time;
+        int32_t value = (int32_t)SpeedwireByteEncoding::getUint32LittleEndian(data);
+        if ((uint32_t)value == SpeedwireRawDataUnsigned32::nan) value = 0;  // received during darkness: NaN value is 0xffffffff
+        addMeasurement(value, (uint32_t)data_time);
+        time = data_time;
         break;
     }
 
     case SpeedwireDataType::Status32: {
-        SpeedwireRawDataStatus32 rd((SpeedwireRawData &)data);
+        // get the index of the data value marked with 0x01000000; this is the selected value in the list of values
+        size_t index = (size_t)-1;
+        uint32_t value = 0;
+        for (size_t i = 0; i < data_size / SpeedwireRawDataStatus32::value_size; ++i) {
+            value = SpeedwireByteEncoding::getUint32LittleEndian(data + i * SpeedwireRawDataStatus32::value_size);
+            if ((value & SpeedwireRawDataStatus32::marker_mask) == SpeedwireRawDataStatus32::sel) {
+                index = i;
+                break;
+            }
+        }
         switch (id) {
         case 0x00214800: {   // device status
             bool ok = false;
-            size_t index = rd.getSelectionIndex();
             if (index != (size_t)-1) {
-                uint32_t value = rd.getValue(index);
                 ok = ((value & 0x00ffffff) == 0x133);  // 307 <=> OK (from: Technische Beschreibung SC - COM Modbus - Schnittstelle)
             }
-            addMeasurement(ok, (uint32_t)data.time);
+            addMeasurement(ok, (uint32_t)data_time);
             break;
         }
         case 0x00416400: {  // grid relay status
@@ -634,13 +706,11 @@ bool SpeedwireData::consume(const SpeedwireRawData& data) {
             // the inverter replies with a list of 3 status value: 0x33 (on), 0x137 (open) 0x00fffffd (NaN) (from: Technische Beschreibung SC-COM Modbus-Schnittstelle)
             // one of the value has a 0x01000000 marker; this is the one that is valid
             bool on = false;
-            size_t index = rd.getSelectionIndex();
             if (index != (size_t)-1) {
-                uint32_t value = rd.getValue(index);
                 on = ((value & 0x00ffffff) == 0x000033);
             }
-            addMeasurement(on, (uint32_t)data.time);
-            time = data.time;
+            addMeasurement(on, (uint32_t)data_time);
+            time = data_time;
             break;
         }
         default:
@@ -886,3 +956,80 @@ SpeedwireDataMap& SpeedwireDataMap::getGlobalMap(void) {
     return globalMap;
 }
 
+
+
+/*******************************
+ *  Class holding a lookup index of SpeedwireData definitions.
+ ********************************/
+
+/**
+ *  Construct a new index from the given vector of SpeedwireData definitions. If there are several definitions
+ *  for the same key, the last one is used; this is consistent with SpeedwireDataMap.
+ *  @param definitions the vector of SpeedwireData definitions
+ */
+SpeedwireDataIndex::SpeedwireDataIndex(const std::vector<SpeedwireData>& definitions) :
+    elements(definitions) {
+    typedef std::pair<uint32_t, size_t> KeyIndexPair;
+    auto less = [](const KeyIndexPair& a, const KeyIndexPair& b) { return a.first < b.first; };
+
+    // collect (key, element index) pairs and sort them by key; keep the last definition for duplicate keys
+    std::vector<KeyIndexPair> sorted;
+    sorted.reserve(elements.size());
+    for (size_t i = 0; i < elements.size(); ++i) {
+        sorted.push_back(KeyIndexPair(elements[i].toKey(), i));
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), less);
+    std::vector<KeyIndexPair> unique;
+    unique.reserve(2 * sorted.size());
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        if (i + 1 < sorted.size() && sorted[i + 1].first == sorted[i].first) continue;
+        unique.push_back(sorted[i]);
+    }
+
+    // add alias keys for connector id 0x7 referring to definitions with connector id 0x1
+    const size_t num_unique = unique.size();
+    for (size_t i = 0; i < num_unique; ++i) {
+        if (elements[unique[i].second].conn == 0x1) {
+            const KeyIndexPair alias(unique[i].first ^ 0x6, unique[i].second);
+            auto it = std::lower_bound(unique.begin(), unique.begin() + num_unique, alias, less);
+            if (it == unique.begin() + num_unique || it->first != alias.first) {
+                unique.push_back(alias);
+            }
+        }
+    }
+    std::sort(unique.begin(), unique.end(), less);
+
+    // fill the key and pointer arrays
+    keys.reserve(unique.size());
+    entries.reserve(unique.size());
+    for (const auto& entry : unique) {
+        keys.push_back(entry.first);
+        entries.push_back(&elements[entry.second]);
+    }
+}
+
+
+/**
+ *  Find the definition for the given key.
+ *  @param key The key, i.e. the combination of register id and connector id
+ *  @return Pointer to the definition or NULL if there is no definition
+ */
+const SpeedwireData* SpeedwireDataIndex::find(const uint32_t key) const {
+    const uint32_t* const begin = keys.data();
+    const uint32_t* const end = begin + keys.size();
+    const uint32_t* const it = std::lower_bound(begin, end, key);
+    if (it != end && *it == key) {
+        return entries[it - begin];
+    }
+    return NULL;
+}
+
+
+/**
+ *  Get a reference to the SpeedwireDataIndex containing all predefined elements. The index is created on first use.
+ *  @return the index
+ */
+const SpeedwireDataIndex& SpeedwireDataIndex::getPredefinedIndex(void) {
+    static const SpeedwireDataIndex predefinedIndex(SpeedwireData::getAllPredefined());
+    return predefinedIndex;
+}
@@ -0,0 +1,109 @@
+#include <SpeedwireIngestPlan.hpp>
+using namespace libspeedwire;
+
+
+/**
+ * Constructor.
+ * @param command The command id of the inverter reply.
+ * @param first_register_id The first register id of the inverter reply.
+ * @param last_register_id The last register id of the inverter reply.
+ */
+SpeedwireIngestPlan::SpeedwireIngestPlan(const Command command, const uint32_t first_register_id, const uint32_t last_register_id) :
+    command(command),
+    firstRegisterID(first_register_id),
+    lastRegisterID(last_register_id) {}
+
+
+/**
+ * Check if this plan is intended for the given inverter reply.
+ * @param reply The inverter reply.
+ * @return true if command id, first and last register id are identical, false otherwise.
+ */
+bool SpeedwireIngestPlan::matches(const SpeedwireInverterProtocol& reply) const {
+    return (reply.getCommandID() == command && reply.getFirstRegisterID() == firstRegisterID && reply.getLastRegisterID() == lastRegisterID);
+}
+
+
+/**
+ * Build the plan from the given inverter reply by looking up each of its elements in the given map.
+ * Elements are mapped if SpeedwireData::matches() accepts them, i.e. by the same rule as SpeedwireData::consume().
+ * @param reply The inverter reply.
+ * @param map The destination map.
+ */
+void SpeedwireIngestPlan::build(const SpeedwireInverterProtocol& reply, SpeedwireDataMap& map) {
+    keys.clear();
+    types.clear();
+    slots.clear();
+    for (const SpeedwireRawDataView& view : reply.getRawDataViews()) {
+        SpeedwireData* slot = NULL;
+        SpeedwireDataMap::iterator it = map.find(view.toKey());
+        if (it != map.end() && it->second.matches(view)) {
+            slot = &it->second;
+        }
+        keys.push_back(view.toKey());
+        types.push_back(view.type);
+        slots.push_back(slot);
+    }
+}
+
+
+/**
+ * Apply the given inverter reply to the destination SpeedwireData instances. If the reply does not match the plan,
+ * the plan is rebuilt.
+ * @param reply The inverter reply.
+ * @param map The destination map; it is only used if the plan needs to be rebuilt.
+ * @param consumed Vector receiving pointers to all updated SpeedwireData instances.
+ * @return The number of updated SpeedwireData instances.
+ */
+size_t SpeedwireIngestPlan::apply(const SpeedwireInverterProtocol& reply, SpeedwireDataMap& map, std::vector<SpeedwireData*>& consumed) {
+    size_t num_consumed = 0;
+    size_t position = 0;
+    for (const SpeedwireRawDataView& view : reply.getRawDataViews()) {
+        if (position >= keys.size() || keys[position] != view.toKey() || types[position] != view.type) {
+            build(reply, map);
+            if (position >= keys.size()) break;
+        }
+        SpeedwireData* const slot = slots[position];
+        if (slot != NULL && slot->consumeValue(view.data, view.getPayloadSize(), view.time) == true) {
+            consumed.push_back(slot);
+            ++num_consumed;
+        }
+        ++position;
+    }
+    return num_consumed;
+}
+
+
+/**
+ * Constructor.
+ * @param map Reference to the destination map.
+ */
+SpeedwireIngest::SpeedwireIngest(SpeedwireDataMap& map) :
+    map(map) {}
+
+
+/**
+ * Ingest the given inverter reply into the destination map.
+ * @param reply The inverter reply.
+ * @return The number of updated SpeedwireData instances; see also getConsumedElements().
+ */
+size_t SpeedwireIngest::ingest(const SpeedwireInverterProtocol& reply) {
+    consumed.clear();
+    for (auto& plan : plans) {
+        if (plan.matches(reply)) {
+            return plan.apply(reply, map, consumed);
+        }
+    }
+    plans.push_back(SpeedwireIngestPlan(reply.getCommandID(), reply.getFirstRegisterID(), reply.getLastRegisterID()));
+    plans.back().build(reply, map);
+    return plans.back().apply(reply, map, consumed);
+}
+
+
+/**
+ * Discard all ingest plans; this must be called whenever elements are removed from the destination map.
+ */
+void SpeedwireIngest::invalidate(void) {
+    plans.clear();
+    consumed.clear();
+}
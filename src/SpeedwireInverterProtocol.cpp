@@ -218,35 +218,53 @@ SpeedwireRawData SpeedwireInverterProtocol::getRawTimelineData(const void* const
         element_length - 4);                    // data size
 }
 
+/** Get a view onto the given raw data element, without copying its payload. The interpretation of the raw data element
+ *  depends on the command id; see getRawData(), getRawConnector0Data() and getRawTimelineData(). */
+SpeedwireRawDataView SpeedwireInverterProtocol::getRawDataView(const void* const current_element, uint32_t element_length) const {
+    SpeedwireRawDataView view;
+    const uint32_t first_word = (current_element != NULL && element_length >= 4 ? SpeedwireByteEncoding::getUint32LittleEndian(current_element) : 0xffffffff);
+    const Command  command_id = getCommandID();
+    view.command = command_id;
+    if ((command_id & Command::ID_MASK) == (Command::EVENT_QUERY & Command::ID_MASK) ||             // EVENT_QUERY => timeline with event records
+        (command_id & Command::ID_MASK) == (Command::YIELD_BY_MINUTE_QUERY & Command::ID_MASK) ||   // COMMAND_YIELD => timeline with energy yield data
+        (command_id & Command::ID_MASK) == (Command::YIELD_BY_DAY_QUERY    & Command::ID_MASK)) {
+        view.id   = (uint32_t)command_id & 0xffffff00;
+        view.conn = 0x00;
+        view.type = ((command_id & Command::ID_MASK) == (Command::EVENT_QUERY & Command::ID_MASK) ? SpeedwireDataType::Event : SpeedwireDataType::Yield);
+        view.time = first_word;
+        view.data = (const uint8_t*)current_element + 4;
+        view.data_size = (current_element != NULL && element_length >= 4 ? element_length - 4 : 0);
+    }
+    else if ((command_id & Command::REQUEST_TYPE_MASK) == Command::NONE) { // connector id is 0x00 => data fields without timestamp
+        view.id   = first_word & 0x00ffff00;
+        view.conn = (uint8_t)(first_word & 0x000000ff);
+        view.type = SpeedwireDataType(first_word >> 24);
+        view.time = first_word;
+        view.data = (const uint8_t*)current_element + 4;
+        view.data_size = (current_element != NULL && element_length >= 4 ? element_length - 4 : 0);
+    }
+    else {
+        const uint32_t second_word = (current_element != NULL && element_length >= 8 ? SpeedwireByteEncoding::getUint32LittleEndian((const uint8_t*)current_element + 4) : 0xffffffff);
+        view.id   = (element_length >= 8 ? first_word & 0x00ffff00 : 0x00ffff00);
+        view.conn = (element_length >= 8 ? (uint8_t)(first_word & 0x000000ff) : 0xff);
+        view.type = SpeedwireDataType(element_length >= 8 ? first_word >> 24 : 0xff);
+        view.time = second_word;
+        view.data = (const uint8_t*)current_element + 8;
+        view.data_size = (current_element != NULL && element_length >= 8 ? element_length - 8 : 0);
+    }
+    return view;
+}
+
+/** Get a range of views onto all raw data elements given in this inverter packet; the views refer directly into the packet buffer. */
+SpeedwireInverterProtocol::RawDataRange SpeedwireInverterProtocol::getRawDataViews(void) const {
+    return RawDataRange(this, getRawDataLength());
+}
+
 /** Get a vector of all raw data elements given in this inverter packet */
 std::vector<SpeedwireRawData> SpeedwireInverterProtocol::getRawDataElements(void) const {
     std::vector<SpeedwireRawData> elements;
-    uint32_t element_length = getRawDataLength();
-    if (element_length > 0) {
-        const void* current_element = getFirstRawDataElement();
-        while (current_element != NULL) {
-            uint32_t first_word = SpeedwireByteEncoding::getUint32LittleEndian(current_element);
-            Command  command_id = getCommandID();
-            if ((command_id & Command::ID_MASK) == (Command::EVENT_QUERY & Command::ID_MASK)) { // EVENT_QUERY => timeline with event records
-                SpeedwireRawData data = getRawTimelineData(current_element, element_length, SpeedwireDataType::Event);
-                elements.push_back(data);
-            }
-            else if ((command_id & Command::ID_MASK) == (Command::YIELD_BY_MINUTE_QUERY & Command::ID_MASK) ||
-                     (command_id & Command::ID_MASK) == (Command::YIELD_BY_DAY_QUERY    & Command::ID_MASK)) { // COMMAND_YIELD => timeline with energy yield data
-                SpeedwireRawData data = getRawTimelineData(current_element, element_length, SpeedwireDataType::Yield);
-                elements.push_back(data);
-            }
-            else if ((command_id & Command::REQUEST_TYPE_MASK) == Command::NONE) { // connector id is 0x00 => data fields without timestamp
-                SpeedwireRawData data = getRawConnector0Data(current_element, element_length, SpeedwireDataType(first_word >> 24));
-                elements.push_back(data);
-            }
-            else {
-                SpeedwireRawData data = getRawData(current_element, element_length);
-                elements.push_back(data);
-                //fprintf(stdout, "%s\n", data.toString().c_str());
-            }
-            current_element = getNextRawDataElement(current_element, element_length);
-        }
+    for (const SpeedwireRawDataView& view : getRawDataViews()) {
+        elements.push_back(view.toRawData());
     }
     if (elements.size() != 0 && elements.size() != (getLastRegisterID() - getFirstRegisterID() + 1)) {
         fprintf(stdout, "missing register\n");
@@ -266,10 +284,9 @@ std::string SpeedwireInverterProtocol::toString(void) const {
     std::string result(buffer);
 
     //LocalHost::hexdump(udp + sma_data_offset, (size >= sma_data_offset ? size - sma_data_offset : 0));
-    std::vector<SpeedwireRawData> elements = getRawDataElements();
     uint32_t register_id = getFirstRegisterID();
-    for (const auto &el : elements) {
-        snprintf(buffer, sizeof(buffer), "0x%08lx: %s\n", register_id, el.toString().c_str());
+    for (const SpeedwireRawDataView& view : getRawDataViews()) {
+        snprintf(buffer, sizeof(buffer), "0x%08lx: %s\n", register_id, view.toRawData().toString().c_str());
         result.append(std::string(buffer));
         register_id++;
     }
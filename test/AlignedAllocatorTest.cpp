@@ -0,0 +1,29 @@
+#include <cstdint>
+#include <vector>
+#include <gtest/gtest.h>
+#include <AlignedAllocator.hpp>
+
+using namespace libspeedwire;
+
+struct alignas(64) CacheLine {
+    uint32_t value;
+};
+
+// test that all elements of a growing vector are cache line aligned
+TEST(AlignedAllocatorTest, VectorAlignment) {
+    ASSERT_EQ(sizeof(CacheLine), 64);
+    std::vector<CacheLine, AlignedAllocator<CacheLine, 64> > lines;
+    for (uint32_t i = 0; i < 100; ++i) {
+        CacheLine line;
+        line.value = i;
+        lines.push_back(line);
+        ASSERT_EQ((uintptr_t)lines.data() % 64, 0);
+    }
+    for (uint32_t i = 0; i < 100; ++i) {
+        ASSERT_EQ((uintptr_t)&lines[i] % 64, 0);
+        ASSERT_EQ(lines[i].value, i);
+    }
+    std::vector<CacheLine, AlignedAllocator<CacheLine, 64> > copy(lines);
+    ASSERT_EQ((uintptr_t)copy.data() % 64, 0);
+    ASSERT_EQ(copy.back().value, 99);
+}
@@ -0,0 +1,137 @@
+#include <vector>
+#include <gtest/gtest.h>
+#include <AveragingProcessor.hpp>
+#include <ObisFilter.hpp>
+#include <SpeedwireEmeterProtocol.hpp>
+
+using namespace libspeedwire;
+
+// aggregate consumer recording all aggregates together with the originating device address
+class AggregateRecorder : public AggregateConsumer {
+public:
+    struct Record {
+        SpeedwireAddress     address;
+        std::string          name;
+        MeasurementAggregate aggregate;
+    };
+    std::vector<Record> records;
+    virtual void consume(const SpeedwireDevice& device, const Measurement& measurement, const MeasurementAggregate& aggregate) {
+        Record record = { device.deviceAddress, measurement.measurementType.name, aggregate };
+        records.push_back(record);
+    }
+};
+
+// feed an emeter packet with a positive active power element through the given filter
+static void feedPacket(ObisFilter& filter, const SpeedwireDevice& device, const uint32_t time, const double power) {
+    uint8_t obis[12] = { 0 };
+    SpeedwireEmeterProtocol::setObisChannel(obis, ObisData::PositiveActivePowerTotal.channel);
+    SpeedwireEmeterProtocol::setObisIndex(obis, ObisData::PositiveActivePowerTotal.index);
+    SpeedwireEmeterProtocol::setObisType(obis, ObisData::PositiveActivePowerTotal.type);
+    SpeedwireEmeterProtocol::setObisTariff(obis, ObisData::PositiveActivePowerTotal.tariff);
+    SpeedwireEmeterProtocol::setObisValue4(obis, (uint32_t)(power * 10.0));
+    filter.consume(device, obis, time);
+    filter.endOfObisData(device, time);
+}
+
+// test tumbling window aggregates for the element and the frame path, for two emeters with the same serial number
+TEST(AveragingProcessorTest, Aggregation) {
+    ObisFilter filter;
+    ObisData entry(ObisData::PositiveActivePowerTotal);
+    entry.measurementValues.setMaximumNumberOfElements(8);
+    filter.addFilter(entry);
+
+    AveragingProcessor elements(0, 0), frames(0, 0);
+    AggregateRecorder element_aggregates, frame_aggregates;
+    elements.enableAggregation(10000);
+    elements.addAggregateConsumer(element_aggregates);
+    frames.enableAggregation(10000);
+    frames.addAggregateConsumer(frame_aggregates);
+    filter.addConsumer(elements);
+    filter.addFrameConsumer(frames);
+
+    // device b differs from device a by its susy id only; its power is offset by 100 W
+    SpeedwireDevice devices[2];
+    devices[0].deviceAddress = SpeedwireAddress(0x15d, 1234567890);
+    devices[1].deviceAddress = SpeedwireAddress(0x15e, 1234567890);
+    for (uint32_t t = 0; t < 35; ++t) {
+        for (uint32_t d = 0; d < 2; ++d) {
+            feedPacket(filter, devices[d], 1000000 + 1000 * t + d, t + 100.0 * d);
+        }
+    }
+
+    // three closed windows per device; both paths see the same aggregates
+    ASSERT_EQ(element_aggregates.records.size(), 6);
+    ASSERT_EQ(frame_aggregates.records.size(), 6);
+    for (size_t i = 0; i < 6; ++i) {
+        const AggregateRecorder::Record& record = element_aggregates.records[i];
+        const AggregateRecorder::Record& frame_record = frame_aggregates.records[i];
+        const uint32_t d = (uint32_t)(i % 2);
+        const double window = (double)(i / 2) * 10.0;
+        ASSERT_TRUE(record.address == devices[d].deviceAddress);
+        ASSERT_EQ(record.name, ObisData::PositiveActivePowerTotal.measurementType.name);
+        ASSERT_EQ(record.aggregate.start_time, 1000000 + 10000 * (i / 2) + d);
+        ASSERT_EQ(record.aggregate.end_time, record.aggregate.start_time + 10000);
+        ASSERT_EQ(record.aggregate.count, 10);
+        ASSERT_NEAR(record.aggregate.mean, window + 4.5 + 100.0 * d, 1e-9);
+        ASSERT_NEAR(record.aggregate.min, window + 100.0 * d, 1e-9);
+        ASSERT_NEAR(record.aggregate.max, window + 9.0 + 100.0 * d, 1e-9);
+        ASSERT_NEAR(record.aggregate.last, window + 9.0 + 100.0 * d, 1e-9);
+
+        ASSERT_TRUE(frame_record.address == record.address);
+        ASSERT_EQ(frame_record.name, record.name);
+        ASSERT_EQ(frame_record.aggregate.start_time, record.aggregate.start_time);
+        ASSERT_EQ(frame_record.aggregate.count, record.aggregate.count);
+        ASSERT_EQ(frame_record.aggregate.mean, record.aggregate.mean);
+        ASSERT_EQ(frame_record.aggregate.min, record.aggregate.min);
+        ASSERT_EQ(frame_record.aggregate.max, record.aggregate.max);
+        ASSERT_EQ(frame_record.aggregate.last_time, record.aggregate.last_time);
+    }
+
+    // re-enabling aggregation discards open windows
+    elements.enableAggregation(10000);
+    feedPacket(filter, devices[0], 1000000 + 35000, 35.0);
+    ASSERT_EQ(element_aggregates.records.size(), 6);
+}
+
+// averaging processor exposing its open addressing state table
+class StateTableProbe : public AveragingProcessor {
+public:
+    StateTableProbe(void) : AveragingProcessor(0, 0) {}
+    int add(const SpeedwireAddress& address) { return initializeState(address, DeviceType::EMETER); }
+    int find(const SpeedwireAddress& address) { return findStateIndex(address); }
+    size_t getTableSize(void) const { return stateTable.size(); }
+    int getLastStateIndex(void) const { return lastStateIndex; }
+};
+
+// test growth and rebuild of the state table, devices with the same serial number, and the most recently found state shortcut
+TEST(AveragingProcessorTest, StateTable) {
+    StateTableProbe probe;
+    std::vector<SpeedwireAddress> addresses;
+    for (uint32_t i = 0; i < 20; ++i) {
+        addresses.push_back(SpeedwireAddress(0x15d, 1900000000 + i));
+        addresses.push_back(SpeedwireAddress(0x15e, 1900000000 + i));
+    }
+    ASSERT_EQ(probe.find(addresses[0]), -1);
+
+    for (size_t n = 0; n < addresses.size(); ++n) {
+        const size_t table_size = probe.getTableSize();
+        ASSERT_EQ(probe.add(addresses[n]), (int)n);
+        ASSERT_EQ(probe.getLastStateIndex(), (int)n);
+
+        // the table is rebuilt with twice the size if it would be more than half full
+        ASSERT_EQ(probe.getTableSize(), (n == 0 ? 16 : (2 * (n + 1) > table_size ? 2 * table_size : table_size)));
+        ASSERT_EQ(probe.getTableSize() & (probe.getTableSize() - 1), 0);
+
+        // right after a rebuild, the added state is found by the shortcut, and all other states by the table
+        ASSERT_EQ(probe.find(addresses[n]), (int)n);
+        for (size_t i = 0; i <= n; ++i) {
+            ASSERT_EQ(probe.find(addresses[i]), (int)i);
+            ASSERT_EQ(probe.getLastStateIndex(), (int)i);
+        }
+
+        // unknown devices, including known serial numbers with another susy id, are not found and keep the shortcut
+        ASSERT_EQ(probe.find(SpeedwireAddress(0x15f, addresses[n].serialNumber)), -1);
+        ASSERT_EQ(probe.getLastStateIndex(), (int)n);
+    }
+    ASSERT_EQ(probe.getTableSize(), 128);
+}
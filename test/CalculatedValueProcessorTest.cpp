@@ -0,0 +1,147 @@
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <CalculatedValueProcessor.hpp>
+
+using namespace libspeedwire;
+
+// produced value, identified by device serial number, measurement name and wire
+struct ProducedValue {
+    uint32_t    serial;
+    std::string name;
+    Wire        wire;
+    double      value;
+    uint32_t    time;
+    bool operator==(const ProducedValue& other) const {
+        return serial == other.serial && name == other.name && wire == other.wire && value == other.value && time == other.time;
+    }
+    bool operator<(const ProducedValue& other) const {
+        return time != other.time ? time < other.time : (wire != other.wire ? wire < other.wire : value < other.value);
+    }
+};
+
+// producer recording all produced values
+class RecordingProducer : public Producer {
+public:
+    std::vector<ProducedValue> values;
+    virtual void flush(void) {}
+    virtual void produce(const SpeedwireDevice& device, const MeasurementType& type, const Wire wire, const double value, const uint32_t time) {
+        ProducedValue produced = { device.deviceAddress.serialNumber, type.name, wire, value, time };
+        values.push_back(produced);
+    }
+    // get the values produced for the given device serial number in production order
+    std::vector<ProducedValue> get(const uint32_t serial) const {
+        std::vector<ProducedValue> result;
+        for (const auto& value : values) {
+            if (value.serial == serial) {
+                result.push_back(value);
+            }
+        }
+        return result;
+    }
+};
+
+static const ObisData* const power_definitions[] = {
+    &ObisData::PositiveActivePowerL1, &ObisData::PositiveActivePowerL2, &ObisData::PositiveActivePowerL3, &ObisData::PositiveActivePowerTotal,
+    &ObisData::NegativeActivePowerL1, &ObisData::NegativeActivePowerL2, &ObisData::NegativeActivePowerL3, &ObisData::NegativeActivePowerTotal,
+    &ObisData::SignedActivePowerL1,   &ObisData::SignedActivePowerL2,   &ObisData::SignedActivePowerL3,   &ObisData::SignedActivePowerTotal
+};
+
+static const uint32_t serials[2] = { 1900000001, 1900000002 };
+static const uint32_t number_of_packets = 400;
+static const uint32_t experimental_serial = 1234567890;
+
+// feed interleaved packets of two emeters through the shared obis data map, with power levels changing every 50 packets
+static void feedPackets(CalculatedValueProcessor& processor, ObisDataMap& obis_map) {
+    for (uint32_t packet = 0; packet < number_of_packets; ++packet) {
+        for (uint32_t device = 0; device < 2; ++device) {
+            SpeedwireDevice emeter;
+            emeter.deviceAddress = SpeedwireAddress(0x15d, serials[device]);
+            const uint32_t time = 1000 * packet + 500 * device;
+            const double level = (double)(((packet / 50) * 7 + device * 3) % 5) * 400.0 - 600.0;
+            const double noise = ((double)((packet * 13 + device * 5) % 7) - 3.0) * 10.0;
+            for (uint32_t wire = 0; wire < 4; ++wire) {
+                const double power = (wire < 3 ? (level + noise) / 3.0 : level + noise);
+                obis_map.find(power_definitions[wire]->toKey())->second.measurementValues.addMeasurement(power > 0.0 ? power : 0.0, time);
+                obis_map.find(power_definitions[wire + 4]->toKey())->second.measurementValues.addMeasurement(power < 0.0 ? -power : 0.0, time);
+            }
+            processor.endOfObisData(emeter, time);
+        }
+    }
+}
+
+// check if the signed power of the last packet of both emeters has been produced
+static bool isComplete(const RecordingProducer& producer) {
+    for (uint32_t device = 0; device < 2; ++device) {
+        const std::vector<ProducedValue> values = producer.get(serials[device]);
+        if (values.size() == 0 || values.back().time != 1000 * (number_of_packets - 1) + 500 * device) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// run interleaved packets of two emeters through a processor and return the produced values
+static RecordingProducer run(const bool asynchronous, const size_t number_of_threads, const size_t queue_size = 1000) {
+    ObisDataMap obis_map;
+    SpeedwireDataMap speedwire_map;
+    for (const ObisData* definition : power_definitions) {
+        ObisData element(*definition);
+        element.measurementValues.setMaximumNumberOfElements(1);
+        obis_map.add(element);
+    }
+    RecordingProducer producer;
+    CalculatedValueProcessor processor(obis_map, speedwire_map, producer);
+    if (asynchronous) {
+        EXPECT_TRUE(processor.enableAnalysisWorkers(number_of_threads, queue_size));
+    }
+    feedPackets(processor, obis_map);
+
+    // wait until the signed power of all packets has been produced
+    for (int i = 0; i < 10000 && !isComplete(producer); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        processor.deliverAnalysisResults();
+    }
+    return producer;
+}
+
+// test that the asynchronous analysis with and without worker threads produces the values and intervals of the synchronous path
+TEST(CalculatedValueProcessorTest, AsynchronousMatchesSynchronous) {
+    const RecordingProducer sync = run(false, 0);
+    for (uint32_t serial : serials) {
+        ASSERT_EQ(sync.get(serial).size(), 4 * number_of_packets);
+    }
+    std::vector<ProducedValue> sync_intervals = sync.get(experimental_serial);
+    ASSERT_GT(sync_intervals.size(), 2 * 2 * (number_of_packets / 50 - 2));
+    std::sort(sync_intervals.begin(), sync_intervals.end());
+
+    for (size_t threads : { 0, 4 }) {
+        const RecordingProducer async = run(true, threads);
+        for (uint32_t serial : serials) {
+            ASSERT_EQ(async.get(serial), sync.get(serial));
+        }
+        // intervals of both devices are produced to the same experimental device, their mutual order depends on the threads
+        std::vector<ProducedValue> async_intervals = async.get(experimental_serial);
+        std::sort(async_intervals.begin(), async_intervals.end());
+        ASSERT_EQ(async_intervals, sync_intervals);
+    }
+
+    // with a single queued packet, packets are merged if the analysis falls behind; no measurement is lost
+    const RecordingProducer merged = run(true, 1, 1);
+    std::vector<ProducedValue> merged_intervals = merged.get(experimental_serial);
+    std::sort(merged_intervals.begin(), merged_intervals.end());
+    ASSERT_EQ(merged_intervals, sync_intervals);
+}
+
+// test that overflow policies dropping packets are rejected
+TEST(CalculatedValueProcessorTest, OverflowPolicy) {
+    ObisDataMap obis_map;
+    SpeedwireDataMap speedwire_map;
+    RecordingProducer producer;
+    CalculatedValueProcessor processor(obis_map, speedwire_map, producer);
+    ASSERT_FALSE(processor.enableAnalysisWorkers(0, 16, OverflowPolicy::DROP_OLDEST));
+    ASSERT_FALSE(processor.enableAnalysisWorkers(0, 16, OverflowPolicy::DROP_NEWEST));
+    ASSERT_EQ(processor.deliverAnalysisResults(), 0);
+    ASSERT_TRUE(processor.enableAnalysisWorkers(0, 16, OverflowPolicy::MERGE));
+}
@@ -0,0 +1,196 @@
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <Measurement.hpp>
+#include <CompressedMeasurementHistory.hpp>
+
+using namespace libspeedwire;
+
+// collect all decoded samples of the given history
+static std::vector<CompressedMeasurementSample> decode(const CompressedMeasurementHistory& history) {
+    std::vector<CompressedMeasurementSample> result;
+    for (auto it = history.begin(); it != history.end(); ++it) {
+        result.push_back(*it);
+    }
+    return result;
+}
+
+// test lossless roundtrip including timer wrap around, jitter, large jumps and negative values
+TEST(CompressedMeasurementHistoryTest, Roundtrip) {
+    CompressedMeasurementHistory history(16, 100);
+    ASSERT_EQ(history.getNumberOfSamples(), 0);
+    ASSERT_TRUE(history.begin() == history.end());
+
+    std::vector<CompressedMeasurementSample> expected;
+    uint32_t time = 0xffffffff - 20000;
+    int64_t value = 1000;
+    for (int i = 0; i < 100; ++i) {
+        CompressedMeasurementSample sample;
+        time += 1000 + (i % 3) - 1;
+        if (i == 50) value = INT64_MIN + 5;
+        else if (i == 51) value = INT64_MAX - 5;
+        else if (i == 52) value = -123456789;
+        else value += (i % 7) - 3;
+        sample.time = time;
+        sample.raw_value = value;
+        expected.push_back(sample);
+        history.addMeasurement(value, time);
+    }
+    ASSERT_EQ(history.getNumberOfSamples(), 100);
+    ASSERT_EQ(history.getNumberOfBlocks(), 7);
+
+    std::vector<CompressedMeasurementSample> decoded = decode(history);
+    ASSERT_EQ(decoded.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_EQ(decoded[i].time, expected[i].time);
+        ASSERT_EQ(decoded[i].raw_value, expected[i].raw_value);
+    }
+
+    history.clear();
+    ASSERT_EQ(history.getNumberOfSamples(), 0);
+    ASSERT_EQ(history.getEncodedSize(), 0);
+    ASSERT_TRUE(history.begin() == history.end());
+}
+
+// test that the oldest block is dropped when the maximum number of blocks is exceeded
+TEST(CompressedMeasurementHistoryTest, Eviction) {
+    CompressedMeasurementHistory history(10, 3);
+    for (int i = 0; i < 45; ++i) {
+        history.addMeasurement(i, i * 1000);
+    }
+    ASSERT_EQ(history.getNumberOfBlocks(), 3);
+    ASSERT_EQ(history.getNumberOfSamples(), 25);
+    std::vector<CompressedMeasurementSample> decoded = decode(history);
+    ASSERT_EQ(decoded.size(), 25);
+    ASSERT_EQ(decoded.front().raw_value, 20);
+    ASSERT_EQ(decoded.front().time, 20000);
+    ASSERT_EQ(decoded.back().raw_value, 44);
+    ASSERT_EQ(decoded.back().time, 44000);
+}
+
+// test the history as backend of a measurement
+TEST(CompressedMeasurementHistoryTest, MeasurementBackend) {
+    Measurement measurement(MeasurementType::EmeterPositiveActiveEnergy(), Wire::TOTAL);
+    CompressedMeasurementHistory history(1024, 10);
+    measurement.measurementValues.setHistory(&history);
+    measurement.addMeasurement((uint64_t)36000000, 1000);
+    measurement.addMeasurement((uint64_t)36000100, 2000);
+    ASSERT_EQ(history.getNumberOfSamples(), 2);
+    ASSERT_EQ(history.getDivisor(), 3600000);
+    auto it = history.begin();
+    ASSERT_EQ(it->raw_value, 36000000);
+    ++it;
+    ASSERT_EQ(it->raw_value, 36000100);
+    ASSERT_EQ(it->time, 2000);
+    ASSERT_DOUBLE_EQ(measurement.measurementValues.getNewestElement().value, 36000100.0 / 3600000.0);
+}
+
+// test that each block keeps the divisor of its raw values, also for measurement values added without a raw representation
+TEST(CompressedMeasurementHistoryTest, Divisor) {
+    CompressedMeasurementHistory history(16, 10);
+    history.addRawMeasurement(100, 10, 1000);
+    history.addRawMeasurement(200, 10, 2000);
+    history.addRawMeasurement(3000, 1000, 3000);
+    history.addMeasurementValue(3.5, 4000);
+    history.addRawMeasurement(50, 10, 5000);
+    ASSERT_EQ(history.getNumberOfSamples(), 5);
+    ASSERT_EQ(history.getNumberOfBlocks(), 3);
+
+    std::vector<CompressedMeasurementSample> decoded = decode(history);
+    const double expected_values[] = { 10.0, 20.0, 3.0, 3.5, 5.0 };
+    const uint32_t expected_divisors[] = { 10, 10, 1000, 1000, 10 };
+    ASSERT_EQ(decoded.size(), 5);
+    for (size_t i = 0; i < decoded.size(); ++i) {
+        ASSERT_EQ(decoded[i].divisor, expected_divisors[i]);
+        ASSERT_DOUBLE_EQ(decoded[i].getValue(), expected_values[i]);
+    }
+    ASSERT_EQ(decoded[3].raw_value, 3500);
+}
+
+// read a captured trace with one "<time> <raw value>" sample per line; lines starting with '#' are ignored
+static bool readTrace(const char* const path, std::vector<CompressedMeasurementSample>& samples) {
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        CompressedMeasurementSample sample;
+        long long raw_value;
+        if (line.size() > 0 && line[0] != '#' && (fields >> sample.time >> raw_value)) {
+            sample.raw_value = raw_value;
+            samples.push_back(sample);
+        }
+    }
+    return samples.size() > 0;
+}
+
+// generate a synthetic 24 h emeter trace: power with noise, a slowly increasing energy counter and +-1 ms timestamp
+// jitter at 1000 ms intervals
+static void generateTrace(std::vector<CompressedMeasurementSample>& power, std::vector<CompressedMeasurementSample>& energy) {
+    const size_t n = 24 * 3600;
+    uint32_t time = 123456;
+    int64_t counter = 123456789000LL;
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < n; ++i) {
+        seed = seed * 1103515245 + 12345;
+        const int64_t p = 15000 + (int64_t)((seed >> 16) % 400) - 200;
+        counter += p / 10;
+        time += 1000 + (seed >> 8) % 3 - 1;
+        CompressedMeasurementSample sample;
+        sample.time = time;
+        sample.raw_value = p;
+        power.push_back(sample);
+        sample.raw_value = counter;
+        energy.push_back(sample);
+    }
+}
+
+// measure compression ratio and decode throughput of the given trace
+static void benchmarkTrace(const std::string& name, const std::vector<CompressedMeasurementSample>& samples) {
+    const size_t n = samples.size();
+    CompressedMeasurementHistory history(1024, n / 1024 + 1);
+    for (const auto& sample : samples) {
+        history.addMeasurement(sample.raw_value, sample.time);
+    }
+    const double raw_size = (double)n * sizeof(TimestampDoublePair);
+
+    auto start = std::chrono::steady_clock::now();
+    int64_t sum = 0;
+    const int repetitions = 20;
+    for (int r = 0; r < repetitions; ++r) {
+        for (auto it = history.begin(); it != history.end(); ++it) {
+            sum += it->raw_value + it->time;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    printf("%s: %zu samples, %.2f bytes/sample, ratio %.1f, decode %.2f ns/sample\n", name.c_str(), n,
+        (double)history.getEncodedSize() / n, raw_size / history.getEncodedSize(), std::chrono::duration<double, std::nano>(end - start).count() / (n * repetitions));
+    ASSERT_EQ(decode(history).size(), n);
+    ASSERT_NE(sum, 0);
+}
+
+// measure compression ratio and decode throughput; captured traces are read from the files listed in the environment
+// variable SPEEDWIRE_TRACES, separated by ':', e.g. exported emeter power and energy series; without captured traces,
+// a synthetic trace is used
+TEST(CompressedMeasurementHistoryTest, DISABLED_Benchmark) {
+    const char* const traces = getenv("SPEEDWIRE_TRACES");
+    if (traces != NULL) {
+        std::istringstream paths(traces);
+        std::string path;
+        while (std::getline(paths, path, ':')) {
+            std::vector<CompressedMeasurementSample> samples;
+            ASSERT_TRUE(readTrace(path.c_str(), samples)) << "cannot read trace " << path;
+            benchmarkTrace(path, samples);
+        }
+        return;
+    }
+    printf("no captured traces given in SPEEDWIRE_TRACES, using a synthetic trace\n");
+    std::vector<CompressedMeasurementSample> power, energy;
+    generateTrace(power, energy);
+    benchmarkTrace("synthetic power", power);
+    benchmarkTrace("synthetic energy", energy);
+}
@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+#include <DerivedValueEngine.hpp>
+
+using namespace libspeedwire;
+
+static void addObisData(ObisDataMap& map, const ObisData& definition, const size_t capacity) {
+    ObisData element(definition);
+    element.measurementValues.setMaximumNumberOfElements(capacity);
+    map.add(element);
+}
+
+static MeasurementValues& getValues(ObisDataMap& map, const ObisData& definition) {
+    return map.find(definition.toKey())->second.measurementValues;
+}
+
+// test incremental evaluation of chained definitions
+TEST(DerivedValueEngineTest, IncrementalEvaluation) {
+    ObisDataMap obis_map;
+    SpeedwireDataMap speedwire_map;
+    addObisData(obis_map, ObisData::PositiveActivePowerTotal, 8);
+    addObisData(obis_map, ObisData::SignedActivePowerTotal, 8);
+    addObisData(obis_map, ObisData::SignedActivePowerL1, 8);
+
+    DerivedValueEngine engine(obis_map, speedwire_map);
+    ASSERT_EQ(engine.define(ObisData::SignedActivePowerTotal, DerivedOperation::DIFFERENCE, ObisData::PositiveActivePowerTotal, ObisData::NegativeActivePowerTotal), 0);
+    ASSERT_EQ(engine.define(ObisData::SignedActivePowerL1, DerivedOperation::PERCENTAGE, ObisData::SignedActivePowerTotal, ObisData::PositiveActivePowerTotal), 1);
+
+    // the negative power is not yet in the data map
+    ASSERT_EQ(engine.evaluate(), 0);
+    ASSERT_EQ(engine.getNumberOfUnresolvedSteps(), 1);
+    addObisData(obis_map, ObisData::NegativeActivePowerTotal, 8);
+
+    MeasurementValues& pos = getValues(obis_map, ObisData::PositiveActivePowerTotal);
+    MeasurementValues& neg = getValues(obis_map, ObisData::NegativeActivePowerTotal);
+    const MeasurementValues& sig = getValues(obis_map, ObisData::SignedActivePowerTotal);
+    const MeasurementValues& pct = getValues(obis_map, ObisData::SignedActivePowerL1);
+    for (uint32_t t = 1; t <= 5; ++t) {
+        pos.addMeasurement(100.0 * t, t * 1000);
+        if (t != 3) {
+            neg.addMeasurement(10.0 * t, t * 1000);
+        }
+    }
+    ASSERT_EQ(engine.evaluate(), 8);
+    ASSERT_EQ(engine.getNumberOfUnresolvedSteps(), 0);
+    ASSERT_EQ(sig.getNumberOfElements(), 4);
+    ASSERT_EQ(sig[2].value, 360.0);
+    ASSERT_EQ(sig[2].time, 4000);
+    ASSERT_EQ(pct[3].value, 90.0);
+
+    // only new measurements are evaluated
+    ASSERT_EQ(engine.evaluate(), 0);
+    pos.addMeasurement(600.0, 6000);
+    ASSERT_EQ(engine.evaluate(), 0);
+    neg.addMeasurement(60.0, 6000);
+    ASSERT_EQ(engine.evaluate(), 2);
+    ASSERT_EQ(sig.getNewestElement().value, 540.0);
+    ASSERT_EQ(sig.getNewestElement().time, 6000);
+
+    // after many evaluations, the result equals a full recalculation of the ring buffers
+    for (uint32_t t = 7; t < 100; ++t) {
+        pos.addMeasurement(100.0 * t, t * 1000);
+        neg.addMeasurement(10.0 * t, t * 1000);
+        if (t % 5 == 0) {
+            engine.evaluate();
+        }
+    }
+    engine.evaluate();
+    ASSERT_EQ(sig.getNumberOfElements(), 8);
+    for (size_t i = 0; i < sig.getNumberOfElements(); ++i) {
+        ASSERT_EQ(sig[i].time, pos[i].time);
+        ASSERT_EQ(sig[i].value, pos[i].value - neg[i].value);
+    }
+}
+
+// test operations
+TEST(DerivedValueEngineTest, Operations) {
+    ASSERT_EQ(DerivedValueEngine::apply(DerivedOperation::DIFFERENCE, 5.0, 2.0), 3.0);
+    ASSERT_EQ(DerivedValueEngine::apply(DerivedOperation::SUM, 5.0, 2.0), 7.0);
+    ASSERT_EQ(DerivedValueEngine::apply(DerivedOperation::RATIO, 5.0, 2.0), 2.5);
+    ASSERT_EQ(DerivedValueEngine::apply(DerivedOperation::RATIO, 5.0, 0.0), 0.0);
+    ASSERT_EQ(DerivedValueEngine::apply(DerivedOperation::PERCENTAGE, 1.0, 4.0), 25.0);
+    ASSERT_EQ(DerivedValueEngine::apply(DerivedOperation::PERCENTAGE, 1.0, 0.0), 0.0);
+}
+
+// test pairing of misaligned operand timestamps
+TEST(DerivedValueEngineTest, MisalignedTimestamps) {
+    ObisDataMap obis_map;
+    SpeedwireDataMap speedwire_map;
+    addObisData(obis_map, ObisData::PositiveActivePowerL1, 16);
+    addObisData(obis_map, ObisData::NegativeActivePowerL1, 16);
+    addObisData(obis_map, ObisData::SignedActivePowerL1, 16);
+    addObisData(obis_map, ObisData::PositiveActivePowerL2, 16);
+    addObisData(obis_map, ObisData::NegativeActivePowerL2, 16);
+    addObisData(obis_map, ObisData::SignedActivePowerL2, 16);
+    MeasurementValues& pos1 = getValues(obis_map, ObisData::PositiveActivePowerL1);
+    MeasurementValues& neg1 = getValues(obis_map, ObisData::NegativeActivePowerL1);
+    MeasurementValues& pos2 = getValues(obis_map, ObisData::PositiveActivePowerL2);
+    MeasurementValues& neg2 = getValues(obis_map, ObisData::NegativeActivePowerL2);
+    const MeasurementValues& sig1 = getValues(obis_map, ObisData::SignedActivePowerL1);
+    const MeasurementValues& sig2 = getValues(obis_map, ObisData::SignedActivePowerL2);
+
+    DerivedValueEngine engine(obis_map, speedwire_map);
+    engine.define(ObisData::SignedActivePowerL1, DerivedOperation::DIFFERENCE, ObisData::PositiveActivePowerL1, ObisData::NegativeActivePowerL1);
+    engine.define(ObisData::SignedActivePowerL2, DerivedOperation::DIFFERENCE, ObisData::PositiveActivePowerL2, ObisData::NegativeActivePowerL2, 5);
+
+    // the negative buffer misses the first measurements and one in the middle; index-based pairing would not find any pair
+    for (uint32_t t = 1; t <= 8; ++t) {
+        pos1.addMeasurement(10.0 * t, t * 1000);
+        if (t > 2 && t != 5) {
+            neg1.addMeasurement(1.0 * t, t * 1000);
+        }
+    }
+    // the negative buffer timestamps are jittered by a few milliseconds; 4 is off by more than the tolerance
+    const int32_t jitter[] = { 1, -2, 5, 9, -3 };
+    for (uint32_t t = 1; t <= 5; ++t) {
+        pos2.addMeasurement(10.0 * t, t * 1000);
+        neg2.addMeasurement(1.0 * t, t * 1000 + jitter[t - 1]);
+    }
+    engine.evaluate();
+    ASSERT_EQ(sig1.getNumberOfElements(), 5);
+    ASSERT_EQ(sig1[0].time, 3000);
+    ASSERT_EQ(sig1[0].value, 27.0);
+    ASSERT_EQ(sig1[2].time, 6000);
+    ASSERT_EQ(sig2.getNumberOfElements(), 4);
+    ASSERT_EQ(sig2[2].time, 3000);
+    ASSERT_EQ(sig2[3].time, 5000);
+    ASSERT_EQ(sig2[3].value, 45.0);
+
+    // measurements are not processed before the other operand has caught up
+    pos2.addMeasurement(60.0, 6000);
+    ASSERT_EQ(engine.evaluate(), 0);
+    neg2.addMeasurement(6.0, 6004);
+    ASSERT_EQ(engine.evaluate(), 1);
+    ASSERT_EQ(sig2.getNewestElement().time, 6000);
+    ASSERT_EQ(sig2.getNewestElement().value, 54.0);
+}
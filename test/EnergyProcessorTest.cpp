@@ -0,0 +1,220 @@
+#include <gtest/gtest.h>
+#include <EnergyProcessor.hpp>
+#include <SpeedwireTime.hpp>
+
+using namespace libspeedwire;
+
+// unix epoch time in ms, such that the 32-bit emeter timer wraps around 5 seconds later
+static const uint64_t wrap_time = (UINT64_C(1700000000000) & ~UINT64_C(0xffffffff)) + UINT64_C(0xffffffff) - 5000;
+
+// test power derived from an emeter energy counter across the 32-bit timer wrap around
+TEST(EnergyProcessorTest, EnergyCounter) {
+    const uint64_t interval = 10000;
+    EnergyTracker tracker(EnergySource::ENERGY_COUNTER, MeasurementTimeBase::EMETER_MS, interval);
+    MeasurementValues counter(16);
+    std::vector<EnergyInterval> intervals;
+
+    // 1800 W for 60 seconds, one reading per second, in kWh
+    const uint64_t start = wrap_time - 3;
+    for (uint64_t t = 0; t <= 60; ++t) {
+        counter.addMeasurement(100.0 + 1800.0 * t / 3600.0 / 1000.0, (uint32_t)(start + t * 1000));
+        ASSERT_EQ(tracker.update(counter, intervals, start), 1);
+        if (t > 0) {
+            ASSERT_TRUE(tracker.hasPower());
+            ASSERT_NEAR(tracker.getPower(), 1800.0, 1e-6);
+        }
+    }
+    ASSERT_EQ(tracker.update(counter, intervals, start), 0);
+    ASSERT_NEAR(tracker.getEnergy(), 1800.0 * 60 / 3600.0 / 1000.0, 1e-12);
+
+    // intervals are aligned to multiples of 10 seconds in unix epoch time; the first partial interval is not reported
+    ASSERT_EQ(intervals.size(), 5);
+    for (const auto& iv : intervals) {
+        ASSERT_EQ(iv.start_time % interval, 0);
+        ASSERT_EQ(iv.end_time - iv.start_time, interval);
+        ASSERT_NEAR(iv.energy, 1800.0 * 10 / 3600.0 / 1000.0, 1e-12);
+        ASSERT_NEAR(iv.average_power, 1800.0, 1e-6);
+    }
+    ASSERT_GT(intervals[0].start_time, start);
+    ASSERT_LE(intervals[0].start_time, start + interval);
+
+    // a counter reset does not contribute energy
+    counter.addMeasurement(0.0, (uint32_t)(start + 61000));
+    ASSERT_EQ(tracker.update(counter, intervals, start), 1);
+    ASSERT_EQ(tracker.getPower(), 0.0);
+    ASSERT_NEAR(tracker.getEnergy(), 1800.0 * 60 / 3600.0 / 1000.0, 1e-12);
+}
+
+// test energy integrated from inverter power values with linear ramps, split at interval boundaries
+TEST(EnergyProcessorTest, PowerIntegration) {
+    const uint64_t interval = 15 * 60 * 1000;
+    const uint64_t now = UINT64_C(1700000000000);
+    const uint32_t start = (uint32_t)(now / 1000 / 900 * 900 - 450);   // inverter time in seconds, half an interval before a boundary
+
+    // power rises linearly from 0 W to 3600 W within 3600 s; readings every 7 s
+    EnergyTracker tracker(EnergySource::POWER, MeasurementTimeBase::INVERTER_S, interval, 3600.0);
+    EnergyTracker single(EnergySource::POWER, MeasurementTimeBase::INVERTER_S, interval, 3600.0);
+    MeasurementValues power(8);
+    MeasurementValues all(1024);
+    std::vector<EnergyInterval> intervals, single_intervals;
+    for (uint32_t t = 0; t <= 3600; t += 7) {
+        power.addMeasurement((double)t, start + t);
+        all.addMeasurement((double)t, start + t);
+        tracker.update(power, intervals, now);
+    }
+    single.update(all, single_intervals, now);
+    ASSERT_NEAR(tracker.getEnergy(), single.getEnergy(), 1e-9);
+
+    // energy of [a, b] seconds in Wh is integral of t dt / 3600
+    ASSERT_EQ(intervals.size(), 3);
+    ASSERT_EQ(single_intervals.size(), intervals.size());
+    for (size_t i = 0; i < intervals.size(); ++i) {
+        const double a = 450.0 + 900.0 * i;
+        const double b = a + 900.0;
+        const double expected = (b * b - a * a) / 2.0 / 3600.0;
+        ASSERT_NEAR(intervals[i].energy, expected, 1e-9);
+        ASSERT_NEAR(intervals[i].average_power, (a + b) / 2.0, 1e-6);
+        ASSERT_NEAR(single_intervals[i].energy, intervals[i].energy, 1e-9);
+    }
+}
+
+// test that gaps longer than the maximum gap count as missing data, and tracking restarts after the gap
+TEST(EnergyProcessorTest, MaximumGap) {
+    const uint64_t interval = 10000;
+    const uint64_t base = UINT64_C(1700000000000);
+    for (EnergySource source : { EnergySource::ENERGY_COUNTER, EnergySource::POWER }) {
+        EnergyTracker tracker(source, MeasurementTimeBase::EMETER_MS, interval, 3600000.0, 5000);
+        EnergyTracker unlimited(source, MeasurementTimeBase::EMETER_MS, interval, 3600000.0, 0);
+        ASSERT_EQ(tracker.getMaximumGap(), 5000);
+        MeasurementValues values(16);
+        std::vector<EnergyInterval> intervals, unlimited_intervals;
+
+        // 3600 W, i.e. 0.001 kWh per second, for 25 seconds, no data for 35 seconds, then again for 25 seconds
+        for (uint64_t t = 0; t <= 85; ++t) {
+            if (t > 25 && t < 60) {
+                continue;
+            }
+            values.addMeasurement(source == EnergySource::ENERGY_COUNTER ? 0.001 * t : 3600.0, (uint32_t)(base + 500 + t * 1000));
+            ASSERT_EQ(tracker.update(values, intervals, base), 1);
+            ASSERT_EQ(unlimited.update(values, unlimited_intervals, base), 1);
+            if (source == EnergySource::ENERGY_COUNTER) {
+                ASSERT_EQ(tracker.hasPower(), t != 0 && t != 60);
+            }
+        }
+        ASSERT_NEAR(tracker.getEnergy(), 0.05, 1e-12);
+        ASSERT_NEAR(unlimited.getEnergy(), 0.085, 1e-12);
+
+        // the intervals overlapping the gap and the first partial interval after the gap are not reported
+        ASSERT_EQ(intervals.size(), 2);
+        ASSERT_EQ(intervals[0].start_time, base + 10000);
+        ASSERT_EQ(intervals[1].start_time, base + 70000);
+        for (const auto& iv : intervals) {
+            ASSERT_EQ(iv.end_time - iv.start_time, interval);
+            ASSERT_NEAR(iv.energy, 0.01, 1e-12);
+            ASSERT_NEAR(iv.average_power, 3600.0, 1e-6);
+        }
+        ASSERT_EQ(unlimited_intervals.size(), 7);
+    }
+}
+
+// producer recording all produced values
+class EnergyRecorder : public Producer {
+public:
+    struct Value {
+        uint32_t    serial;
+        std::string name;
+        double      value;
+        uint32_t    time;
+    };
+    std::vector<Value> values;
+    virtual void flush(void) {}
+    virtual void produce(const SpeedwireDevice& device, const MeasurementType& type, const Wire wire, const double value, const uint32_t time) {
+        Value produced = { device.deviceAddress.serialNumber, type.name, value, time };
+        values.push_back(produced);
+    }
+};
+
+// test per device trackers, definition matching, the interval producer and the conversion of interval end times to emeter timers
+TEST(EnergyProcessorTest, EmeterProcessor) {
+    const uint64_t interval = 10000;
+    EnergyRecorder producer, interval_producer;
+    EnergyProcessor processor(producer, interval_producer, interval);
+    processor.addEnergyCounter(ObisData::PositiveActiveEnergyTotal, MeasurementType::EmeterPositiveActivePower());
+
+    // two emeters with 1800 W and 3600 W, each with its own energy counter, and an unregistered negative energy counter
+    SpeedwireDevice devices[2];
+    ObisData counters[2] = { ObisData::PositiveActiveEnergyTotal, ObisData::PositiveActiveEnergyTotal };
+    ObisData unregistered(ObisData::NegativeActiveEnergyTotal);
+    unregistered.measurementValues.setMaximumNumberOfElements(4);
+    for (uint32_t d = 0; d < 2; ++d) {
+        devices[d].deviceAddress = SpeedwireAddress(0x15d, 1900000001 + d);
+        counters[d].measurementValues.setMaximumNumberOfElements(4);
+    }
+    const uint64_t start = LocalHost::getUnixEpochTimeInMs() / interval * interval - 60000 + 250;
+    for (uint64_t t = 0; t <= 40; ++t) {
+        for (uint32_t d = 0; d < 2; ++d) {
+            const uint32_t time = (uint32_t)(start + t * 1000 + d * 100);
+            counters[d].measurementValues.addMeasurement(0.0005 * (d + 1) * t, time);
+            unregistered.measurementValues.addMeasurement(0.001 * t, time);
+            processor.consume(devices[d], counters[d]);
+            processor.consume(devices[d], unregistered);
+            processor.endOfObisData(devices[d], time);
+        }
+    }
+
+    // derived power for each reading after the first one of each device
+    ASSERT_EQ(producer.values.size(), 2 * 40);
+    for (const auto& value : producer.values) {
+        ASSERT_EQ(value.name, MeasurementType::EmeterPositiveActivePower().name);
+        ASSERT_NEAR(value.value, 1800.0 * (value.serial - 1900000000), 1e-6);
+    }
+
+    // energy and average power of the three complete intervals of each device, timestamped by the emeter timer of the interval end
+    ASSERT_EQ(interval_producer.values.size(), 2 * 3 * 2);
+    for (size_t i = 0; i < interval_producer.values.size(); i += 2) {
+        const EnergyRecorder::Value& energy = interval_producer.values[i];
+        const EnergyRecorder::Value& power = interval_producer.values[i + 1];
+        const double expected_power = 1800.0 * (energy.serial - 1900000000);
+        ASSERT_EQ(energy.name, ObisData::PositiveActiveEnergyTotal.measurementType.name);
+        ASSERT_EQ(power.name, MeasurementType::EmeterPositiveActivePower().name);
+        ASSERT_EQ(power.serial, energy.serial);
+        ASSERT_EQ(power.time, energy.time);
+        ASSERT_NEAR(energy.value, expected_power * 10.0 / 3600.0 / 1000.0, 1e-12);
+        ASSERT_NEAR(power.value, expected_power, 1e-6);
+        const uint64_t end_time = SpeedwireTime::convertEmeterTimeToUnixEpochTime(energy.time, start);
+        ASSERT_EQ(end_time % interval, 0);
+        ASSERT_EQ(end_time, start - 250 + interval * (2 + i / 4));
+    }
+}
+
+// test the conversion of interval end times to inverter timers for integrated inverter power
+TEST(EnergyProcessorTest, InverterProcessor) {
+    const uint64_t interval = 60000;
+    EnergyRecorder producer;
+    EnergyProcessor processor(producer, producer, interval);
+    processor.addPower(SpeedwireData::InverterPowerACTotal, MeasurementType::InverterEnergy());
+
+    SpeedwireDevice device;
+    device.deviceAddress = SpeedwireAddress(0x80, 3000000001);
+    SpeedwireData power(SpeedwireData::InverterPowerACTotal);
+    power.measurementValues.setMaximumNumberOfElements(4);
+    const uint32_t start = (uint32_t)(LocalHost::getUnixEpochTimeInMs() / 1000 / 60 * 60 - 600 + 5);
+    for (uint32_t t = 0; t <= 180; t += 10) {
+        power.measurementValues.addMeasurement(1200.0, start + t);
+        processor.consume(device, power);
+        processor.endOfSpeedwireData(device, start + t);
+    }
+
+    // cumulative energy for each reading, followed by energy and average power of the two complete intervals
+    std::vector<uint32_t> interval_times;
+    for (const auto& value : producer.values) {
+        if (value.name == MeasurementType::InverterPower().name) {
+            ASSERT_NEAR(value.value, 1200.0, 1e-9);
+            interval_times.push_back(value.time);
+        }
+    }
+    ASSERT_EQ(producer.values.size(), 19 + 2 * 2);
+    ASSERT_EQ(interval_times, std::vector<uint32_t>({ start - 5 + 120, start - 5 + 180 }));
+    ASSERT_NEAR(producer.values.back().value, 1200.0, 1e-9);
+    ASSERT_NEAR(producer.values[producer.values.size() - 2].value, 1200.0 * 60.0 / 3600.0, 1e-9);
+}
@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+#include <FleetAggregator.hpp>
+
+using namespace libspeedwire;
+
+// test incremental totals against a brute force calculation, including row growth and replaced extreme values
+TEST(FleetAggregatorTest, Totals) {
+    FleetAggregator fleet(5000);
+    const uint32_t power = fleet.addMeasurement(ObisData::PositiveActivePowerTotal);
+    const uint32_t energy = fleet.addMeasurement(ObisData::PositiveActiveEnergyTotal);
+    ASSERT_EQ(fleet.addMeasurement(ObisData::PositiveActivePowerTotal), power);
+    ASSERT_EQ(fleet.findMeasurement(ObisData::PositiveActiveEnergyTotal.toKey()), (int)energy);
+    ASSERT_EQ(fleet.findMeasurement(ObisData::NegativeActivePowerTotal.toKey()), -1);
+
+    const uint32_t devices = 250;
+    std::vector<double> latest(devices, 0.0);
+    uint32_t seed = 12345;
+    for (uint32_t step = 0; step < 5000; ++step) {
+        seed = seed * 1103515245u + 12345u;
+        const uint32_t device = (seed >> 8) % devices;
+        const double value = (double)((seed >> 4) % 1000) - 200.0;
+        const uint32_t row = fleet.getDeviceRow(SpeedwireAddress(0x15d, 3000000000u + device));
+        fleet.update(row, power, value, 1000);
+        latest[row] = value;
+
+        if (step % 97 == 0 || step == 4999) {
+            double sum = 0.0, min = 1e9, max = -1e9;
+            uint32_t count = 0;
+            for (uint32_t r = 0; r < fleet.getNumberOfDevices(); ++r) {
+                sum += latest[r]; min = std::min(min, latest[r]); max = std::max(max, latest[r]); ++count;
+            }
+            ASSERT_EQ(fleet.getCount(power), count);
+            ASSERT_NEAR(fleet.getSum(power), sum, 1e-6);
+            ASSERT_EQ(fleet.getMinimum(power), min);
+            ASSERT_EQ(fleet.getMaximum(power), max);
+        }
+    }
+    ASSERT_EQ(fleet.getNumberOfDevices(), devices);
+    ASSERT_EQ(fleet.getCount(energy), 0);
+    ASSERT_EQ(fleet.getSum(energy), 0.0);
+}
+
+// test that stale devices are removed from the totals and added again when they are updated
+TEST(FleetAggregatorTest, StaleDevices) {
+    FleetAggregator fleet(5000);
+    const uint32_t power = fleet.addMeasurement(ObisData::PositiveActivePowerTotal);
+    const uint32_t a = fleet.getDeviceRow(SpeedwireAddress(0x15d, 1));
+    const uint32_t b = fleet.getDeviceRow(SpeedwireAddress(0x15d, 2));
+    const uint32_t c = fleet.getDeviceRow(SpeedwireAddress(0x15d, 3));
+    ASSERT_EQ(fleet.getDeviceRow(SpeedwireAddress(0x15d, 2)), b);
+
+    fleet.update(a, power, 100.0, 0);
+    fleet.update(b, power, 300.0, 0);
+    fleet.update(c, power, 200.0, 0);
+    fleet.expire(1000);
+    ASSERT_EQ(fleet.getCount(power), 3);
+    ASSERT_DOUBLE_EQ(fleet.getSum(power), 600.0);
+
+    // b stops reporting
+    fleet.update(a, power, 110.0, 3000);
+    fleet.update(c, power, 210.0, 3000);
+    fleet.expire(5000);
+    ASSERT_EQ(fleet.getCount(power), 2);
+    ASSERT_EQ(fleet.getNumberOfStaleDevices(power), 1);
+    ASSERT_DOUBLE_EQ(fleet.getSum(power), 320.0);
+    ASSERT_EQ(fleet.getMaximum(power), 210.0);
+    ASSERT_EQ(fleet.getMinimum(power), 110.0);
+
+    // all devices become stale
+    fleet.expire(8000);
+    ASSERT_EQ(fleet.getCount(power), 0);
+    ASSERT_EQ(fleet.getNumberOfStaleDevices(power), 3);
+    ASSERT_EQ(fleet.getSum(power), 0.0);
+
+    // b reports again
+    fleet.update(b, power, 50.0, 9000);
+    ASSERT_EQ(fleet.getCount(power), 1);
+    ASSERT_EQ(fleet.getNumberOfStaleDevices(power), 2);
+    ASSERT_DOUBLE_EQ(fleet.getSum(power), 50.0);
+    ASSERT_EQ(fleet.getMinimum(power), 50.0);
+    ASSERT_EQ(fleet.getMaximum(power), 50.0);
+}
+
+// test that the periodic re-calculation of the sum removes rounding errors of incremental changes
+TEST(FleetAggregatorTest, Resum) {
+    FleetAggregator fleet(5000);
+    const uint32_t power = fleet.addMeasurement(ObisData::PositiveActivePowerTotal);
+    std::vector<uint32_t> rows;
+    for (uint32_t device = 0; device < 20; ++device) {
+        rows.push_back(fleet.getDeviceRow(SpeedwireAddress(0x15d, 3000000000u + device)));
+        fleet.update(rows.back(), power, 0.1 * device, 1000);
+    }
+
+    // values of very different magnitudes, such that incremental changes lose the small values
+    for (uint32_t step = 0; step < 1000; ++step) {
+        fleet.update(rows[step % 20], power, (step % 3 == 0 ? 1e17 : 0.1) * (step + 1), 1000);
+    }
+    double exact = 0.0;
+    for (uint32_t step = 980; step < 1000; ++step) {
+        exact += (step % 3 == 0 ? 1e17 : 0.1) * (step + 1);
+    }
+    ASSERT_NEAR(fleet.getSum(power), exact, exact * 1e-15);
+
+    // the small values are lost by the incremental changes once the large values are replaced; the sum is exact
+    // again, as soon as it has been re-calculated within as many further changes as there are devices
+    for (uint32_t device = 0; device < 20; ++device) {
+        fleet.update(rows[device], power, 0.5 * device, 1000);
+    }
+    for (uint32_t device = 0; device < 20; ++device) {
+        fleet.update(rows[device], power, 0.5 * device, 1000);
+    }
+    ASSERT_EQ(fleet.getSum(power), 95.0);
+
+    // stale devices are skipped by the re-calculation
+    fleet.update(rows[0], power, 1.0, 4000);
+    fleet.expire(6000);
+    ASSERT_EQ(fleet.getCount(power), 1);
+    for (uint32_t i = 0; i < 25; ++i) {
+        fleet.update(rows[0], power, 1.0 + i, 6000);
+    }
+    ASSERT_EQ(fleet.getSum(power), 25.0);
+}
+
+// test that many measurements and devices are mapped to their columns and rows
+TEST(FleetAggregatorTest, IndexTables) {
+    FleetAggregator fleet(5000);
+    std::vector<ObisData> measurements;
+    for (uint8_t index = 1; index <= 40; ++index) {
+        measurements.push_back(ObisData(0, index, 4, 0, MeasurementType::EmeterPositiveActivePower(), Wire::TOTAL));
+        measurements.push_back(ObisData(0, index, 8, 0, MeasurementType::EmeterPositiveActiveEnergy(), Wire::TOTAL));
+    }
+    for (size_t i = 0; i < measurements.size(); ++i) {
+        ASSERT_EQ(fleet.addMeasurement(measurements[i]), (uint32_t)i);
+        for (size_t j = 0; j <= i; ++j) {
+            ASSERT_EQ(fleet.findMeasurement(measurements[j].toKey()), (int)j);
+        }
+    }
+    ASSERT_EQ(fleet.findMeasurement(ObisData(0, 41, 4, 0, MeasurementType::EmeterPositiveActivePower(), Wire::TOTAL).toKey()), -1);
+
+    // devices with the same serial number and different susy ids have different rows
+    for (uint32_t device = 0; device < 100; ++device) {
+        ASSERT_EQ(fleet.getDeviceRow(SpeedwireAddress(0x15d + device % 2, 3000000000u + device / 2)), device);
+    }
+    for (uint32_t device = 0; device < 100; ++device) {
+        ASSERT_EQ(fleet.getDeviceRow(SpeedwireAddress(0x15d + device % 2, 3000000000u + device / 2)), device);
+    }
+    ASSERT_EQ(fleet.getNumberOfDevices(), 100);
+}
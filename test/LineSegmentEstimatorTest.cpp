@@ -1,6 +1,9 @@
+#include <chrono>
+#include <cmath>
 #include <gtest/gtest.h>
 #include <MeasurementValues.hpp>
 #include <LineSegmentEstimator.hpp>
+#include <OnlineChangePointDetector.hpp>
 
 using namespace libspeedwire;
 
@@ -80,4 +83,241 @@ TEST(LineSegmentEstimatorTest, approximateSlopeFunctions3) {
     std::vector<size_t> steps;
     LineSegmentEstimator::findChangePointsOfLinearRegressionValues(mv, steps);
 }
-#endif
\ No newline at end of file
+#endif
+// fill the given measurement values with a noisy step function, where the level changes every 20 to 60 measurements
+static void fillStepFunction(MeasurementValues& mv, const size_t n, const double noise) {
+    double level = 300.0;
+    size_t next_step = 40;
+    for (size_t i = 0; i < n; ++i) {
+        if (i == next_step) {
+            level = 300.0 + (std::rand() % 10) * 300.0;
+            next_step += 20 + std::rand() % 40;
+        }
+        double value = level + noise * (((double)std::rand() - (RAND_MAX / 2)) / RAND_MAX);
+        mv.addMeasurement(value, (uint32_t)(i * 1000));
+    }
+}
+
+// test that the online change point detector confirms the same change points as the batch version
+static void checkOnlineEquivalence(const MeasurementValues& mv) {
+    const size_t n = mv.getNumberOfElements();
+    std::vector<size_t> batch_changes;
+    LineSegmentEstimator::findChangePointsOfMeanValues(mv, batch_changes);
+    std::vector<MeasurementValueInterval> batch_intervals;
+    LineSegmentEstimator::findPiecewiseConstantIntervals(mv, batch_intervals);
+
+    OnlineChangePointDetector detector;
+    std::vector<MeasurementValueInterval> online_intervals;
+    for (size_t i = 0; i < n; ++i) {
+        MeasurementValueInterval interval;
+        if (detector.addMeasurement(mv.at(i).value, mv.at(i).time, interval)) {
+            online_intervals.push_back(interval);
+        }
+    }
+
+    // the batch version evaluates truncated windows for the most recent measurements
+    size_t num_confirmed = 0;
+    while (num_confirmed < batch_changes.size() && batch_changes[num_confirmed] + detector.getLatency() <= n - 1) {
+        ++num_confirmed;
+    }
+    ASSERT_EQ(online_intervals.size(), num_confirmed);
+    for (size_t i = 0; i < num_confirmed; ++i) {
+        ASSERT_EQ(online_intervals[i].end_index, batch_changes[i]);
+        ASSERT_EQ(online_intervals[i].start_index, batch_intervals[i].start_index);
+        ASSERT_EQ(online_intervals[i].start_time, batch_intervals[i].start_time);
+        ASSERT_EQ(online_intervals[i].end_time, batch_intervals[i].end_time);
+        ASSERT_NEAR(online_intervals[i].mean_value, batch_intervals[i].mean_value, 1e-6);
+    }
+
+    MeasurementValueInterval open_interval;
+    ASSERT_TRUE(detector.getOpenInterval(open_interval));
+    ASSERT_EQ(open_interval.start_index, (num_confirmed > 0 ? batch_changes[num_confirmed - 1] + 1 : 0));
+    ASSERT_EQ(open_interval.end_index, n - 1);
+    ASSERT_NEAR(open_interval.mean_value, mv.estimateMean(open_interval.start_index, n - 1), 1e-6);
+}
+
+// test online change point detection on the data of test approximateStepFunctions
+TEST(LineSegmentEstimatorTest, OnlineEquivalenceSingleStep) {
+    std::srand(1);
+    const double noise = 300.0;
+    MeasurementValues mv(60);
+    for (size_t i = 0; i < mv.getMaximumNumberOfElements(); ++i) {
+        double value = (i < 30 ? 300.0 : 600.0) + noise * (((double)std::rand() - (RAND_MAX / 2)) / RAND_MAX);
+        mv.addMeasurement(value, (uint32_t)(i * 1000));
+    }
+    checkOnlineEquivalence(mv);
+}
+
+// test online change point detection on a longer sequence of steps
+TEST(LineSegmentEstimatorTest, OnlineEquivalenceMultipleSteps) {
+    for (unsigned seed = 1; seed <= 20; ++seed) {
+        std::srand(seed);
+        MeasurementValues mv(1000);
+        fillStepFunction(mv, 1000, 300.0);
+        checkOnlineEquivalence(mv);
+    }
+}
+
+// compare per-packet cost of the batch version on a 60 measurement window with the online detector
+TEST(LineSegmentEstimatorTest, DISABLED_OnlineBenchmark) {
+    std::srand(1);
+    const size_t n = 100000;
+    MeasurementValues input(n);
+    fillStepFunction(input, n, 300.0);
+
+    MeasurementValues window(60);
+    size_t batch_intervals = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n; ++i) {
+        window.addMeasurement(input.at(i).value, input.at(i).time);
+        std::vector<MeasurementValueInterval> intervals;
+        batch_intervals += LineSegmentEstimator::findPiecewiseConstantIntervals(window, intervals);
+    }
+    auto batch_end = std::chrono::steady_clock::now();
+
+    OnlineChangePointDetector detector;
+    size_t online_intervals = 0;
+    for (size_t i = 0; i < n; ++i) {
+        MeasurementValueInterval interval;
+        online_intervals += (detector.addMeasurement(input.at(i).value, input.at(i).time, interval) ? 1 : 0);
+    }
+    auto online_end = std::chrono::steady_clock::now();
+
+    printf("batch:  %.0f ns/measurement\n", std::chrono::duration<double, std::nano>(batch_end - start).count() / n);
+    printf("online: %.0f ns/measurement  (%lu intervals)\n", std::chrono::duration<double, std::nano>(online_end - batch_end).count() / n, (unsigned long)online_intervals);
+    ASSERT_GT(batch_intervals, 0);
+    ASSERT_GT(online_intervals, 0);
+}
+
+// expose the protected estimateStatistics() method
+class LineSegmentEstimatorAccess : public LineSegmentEstimator {
+public:
+    using LineSegmentEstimator::estimateStatistics;
+};
+
+// reference implementation of estimateStatistics(), recalculating each window from scratch
+static void estimateStatisticsReference(const MeasurementValues& mvalues, const size_t window_size, const bool enable_linear_regression, std::vector<StatisticalEstimates>& estimates) {
+    const size_t num_values = mvalues.getNumberOfElements();
+    for (size_t i = 0; i < num_values; ++i) {
+        const size_t truncated_size = (i > (num_values - window_size - 1) ? (num_values - i - 1) : (i < window_size ? i : window_size));
+        const size_t from = i - truncated_size;
+        const size_t to = i + truncated_size;
+        const size_t n = to - from + 1;
+        double y_mean, y_var, slope = 0.0, slope_var = 0.0;
+        if (enable_linear_regression == false) {
+            mvalues.estimateMeanAndVariance(from, to, y_mean, y_var);
+            if (n > 1) y_var *= (2 * window_size + 1) / (n - 1);
+        }
+        else {
+            mvalues.estimateLinearRegression(from, to, y_mean, y_var, slope);
+            double y_dist_sum = 0.0;
+            for (size_t w = from; w <= to; ++w) {
+                const double y_dist = mvalues.at(w).value - (((int)w - (int)i) * slope + y_mean);
+                y_dist_sum += y_dist * y_dist;
+            }
+            slope_var = FLT_MAX;
+            if (n > 1) {
+                y_var *= (2 * window_size + 1) / (n - 1);
+                slope_var = (y_dist_sum / n) * std::pow(2.0, (double)(window_size - truncated_size));
+                if (i == 1 || i == num_values - 2) slope_var = FLT_MAX / 1e18;
+            }
+        }
+        estimates.push_back(StatisticalEstimates(y_mean, y_var, slope, slope_var));
+    }
+}
+
+// check that two values agree within a tolerance relative to the given scale
+static void expectClose(const double expected, const double actual, const double scale) {
+    ASSERT_NEAR(actual, expected, 1e-9 * std::max(1.0, std::max(std::fabs(expected), scale)));
+}
+
+// test the O(n) estimateStatistics() against the reference implementation, including wrapped ring buffers
+TEST(LineSegmentEstimatorTest, EstimateStatistics) {
+    std::srand(3);
+    for (size_t window_size : { 1, 3, 6, 10, 70 }) {     // 2^70 scaling of truncated windows exceeds the range of size_t
+        MeasurementValues mv(200);
+        for (size_t i = 0; i < 250; ++i) {
+            const double value = 5000.0 + (i % 80 < 40 ? 20.0 * i : -10.0 * i) + 300.0 * (((double)std::rand() - (RAND_MAX / 2)) / RAND_MAX);
+            mv.addMeasurement(value, (uint32_t)(i * 1000));
+        }
+        for (bool regression : { false, true }) {
+            std::vector<StatisticalEstimates> expected, actual;
+            estimateStatisticsReference(mv, window_size, regression, expected);
+            LineSegmentEstimatorAccess::estimateStatistics(mv, window_size, regression, actual);
+            ASSERT_EQ(actual.size(), expected.size());
+            for (size_t i = 0; i < expected.size(); ++i) {
+                expectClose(expected[i].mean, actual[i].mean, 0.0);
+                expectClose(expected[i].variance, actual[i].variance, 0.0);
+                expectClose(expected[i].slope, actual[i].slope, expected[i].mean);    // slopes are subject to cancellation at the value scale
+                if (expected[i].sloped_variance != FLT_MAX && expected[i].sloped_variance != FLT_MAX / 1e18) {
+                    ASSERT_NEAR(actual[i].sloped_variance, expected[i].sloped_variance, std::max(1e-6 * std::max(1.0, expected[i].variance), 1e-9 * expected[i].sloped_variance));
+                }
+                else {
+                    ASSERT_EQ(actual[i].sloped_variance, expected[i].sloped_variance);
+                }
+            }
+        }
+    }
+}
+
+// expose scratch buffers to check their reuse
+class LineSegmentEstimatorScratch : public LineSegmentEstimator {
+public:
+    const StatisticalEstimates* getEstimatesData(void) const { return estimates.data(); }
+    const double* getPrefixSumsData(void) const { return prefix_sums.y.data(); }
+};
+
+static void checkIntervalsEqual(const std::vector<MeasurementValueInterval>& expected, const std::vector<MeasurementValueInterval>& actual) {
+    ASSERT_EQ(actual.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_EQ(actual[i].start_index, expected[i].start_index);
+        ASSERT_EQ(actual[i].end_index, expected[i].end_index);
+        ASSERT_EQ(actual[i].start_time, expected[i].start_time);
+        ASSERT_EQ(actual[i].end_time, expected[i].end_time);
+        ASSERT_EQ(actual[i].mean_value, expected[i].mean_value);
+        ASSERT_EQ(actual[i].slope, expected[i].slope);
+    }
+}
+
+// test that a reused estimator instance yields the same intervals as the static methods and reuses its scratch buffers
+TEST(LineSegmentEstimatorTest, InstanceReuse) {
+    std::srand(3);
+    std::vector<MeasurementValues> values(8, MeasurementValues(120));
+    std::vector<const MeasurementValues*> series;
+    for (auto& mv : values) {
+        fillStepFunction(mv, 120, 300.0);
+        series.push_back(&mv);
+    }
+
+    LineSegmentEstimatorScratch estimator;
+    std::vector<std::vector<MeasurementValueInterval> > constant, linear;
+    estimator.findConstantIntervals(series, constant);
+    const StatisticalEstimates* estimates_data = estimator.getEstimatesData();
+    const double* prefix_sums_data = estimator.getPrefixSumsData();
+    estimator.findLinearIntervals(series, linear);
+    ASSERT_EQ(constant.size(), series.size());
+    ASSERT_EQ(linear.size(), series.size());
+
+    for (int pass = 0; pass < 2; ++pass) {
+        for (size_t i = 0; i < series.size(); ++i) {
+            std::vector<MeasurementValueInterval> expected;
+            LineSegmentEstimator::findPiecewiseConstantIntervals(*series[i], expected);
+            checkIntervalsEqual(expected, constant[i]);
+            expected.clear();
+            LineSegmentEstimator::findPiecewiseLinearIntervals(*series[i], expected);
+            checkIntervalsEqual(expected, linear[i]);
+        }
+        estimator.findConstantIntervals(series, constant);
+        estimator.findLinearIntervals(series, linear);
+        ASSERT_EQ(estimator.getEstimatesData(), estimates_data);
+        ASSERT_EQ(estimator.getPrefixSumsData(), prefix_sums_data);
+    }
+
+    // a mean ratio larger than any step suppresses all change points
+    LineSegmentEstimatorConfig config;
+    config.mean_ratio = 1e12;
+    LineSegmentEstimator strict(config);
+    std::vector<MeasurementValueInterval> intervals;
+    ASSERT_EQ(strict.findConstantIntervals(*series[0], intervals), 1);
+    ASSERT_EQ(intervals[0].end_index, series[0]->getNumberOfElements() - 1);
+}
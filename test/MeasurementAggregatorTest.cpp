@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+#include <MeasurementAggregator.hpp>
+
+using namespace libspeedwire;
+
+// test tumbling windows, including windows without measurements
+TEST(MeasurementAggregatorTest, Tumbling) {
+    MeasurementAggregator aggregator(1000);
+    std::vector<MeasurementAggregate> aggregates;
+    ASSERT_EQ(aggregator.getHopLength(), 1000);
+
+    // window [100, 1100): values 1..4
+    ASSERT_EQ(aggregator.add(1.0, 100, aggregates), 0);
+    ASSERT_EQ(aggregator.add(4.0, 400, aggregates), 0);
+    ASSERT_EQ(aggregator.add(2.0, 700, aggregates), 0);
+    ASSERT_EQ(aggregator.add(2.0, 700, aggregates), 0);     // duplicate, ignored
+    ASSERT_EQ(aggregator.add(3.0, 1000, aggregates), 0);
+    ASSERT_EQ(aggregator.add(5.0, 1100, aggregates), 1);
+    ASSERT_EQ(aggregates.size(), 1);
+    const MeasurementAggregate& aggregate = aggregates[0];
+    ASSERT_EQ(aggregate.start_time, 100);
+    ASSERT_EQ(aggregate.end_time, 1100);
+    ASSERT_EQ(aggregate.count, 4);
+    ASSERT_DOUBLE_EQ(aggregate.mean, 2.5);
+    ASSERT_DOUBLE_EQ(aggregate.min, 1.0);
+    ASSERT_DOUBLE_EQ(aggregate.max, 4.0);
+    ASSERT_DOUBLE_EQ(aggregate.last, 3.0);
+    ASSERT_EQ(aggregate.last_time, 1000);
+
+    // window [1100, 2100) holds a single value; windows until 4100 are empty and not reported
+    aggregates.clear();
+    ASSERT_EQ(aggregator.add(7.0, 4500, aggregates), 1);
+    ASSERT_EQ(aggregates[0].start_time, 1100);
+    ASSERT_EQ(aggregates[0].count, 1);
+    ASSERT_DOUBLE_EQ(aggregates[0].mean, 5.0);
+    aggregates.clear();
+    ASSERT_EQ(aggregator.add(8.0, 5100, aggregates), 1);
+    ASSERT_EQ(aggregates[0].start_time, 4100);
+    ASSERT_EQ(aggregates[0].end_time, 5100);
+    ASSERT_DOUBLE_EQ(aggregates[0].mean, 7.0);
+
+    aggregator.reset();
+    ASSERT_EQ(aggregator.add(1.0, 0, aggregates), 0);
+}
+
+// test sliding windows against a brute force calculation
+TEST(MeasurementAggregatorTest, Sliding) {
+    const uint32_t window = 1000, hop = 250;
+    MeasurementAggregator aggregator(window, hop);
+    std::vector<MeasurementAggregate> aggregates;
+    std::vector<std::pair<uint32_t, double>> history;
+    size_t emitted = 0;
+
+    for (uint32_t i = 0; i < 200; ++i) {
+        const uint32_t time = i * 70 + (i / 50) * 1600;    // with gaps spanning several hops
+        const double value = (double)((i * 37) % 23) - 11.0;
+        aggregates.clear();
+        const size_t closed = aggregator.add(value, time, aggregates);
+        ASSERT_EQ(closed, aggregates.size());
+        for (const auto& aggregate : aggregates) {
+            ASSERT_EQ(aggregate.end_time - aggregate.start_time, window);
+            ASSERT_EQ(aggregate.end_time % hop, 0);
+            double sum = 0.0, min = 1e9, max = -1e9;
+            uint32_t count = 0;
+            for (const auto& h : history) {
+                if ((int32_t)(h.first - aggregate.start_time) >= 0 && (int32_t)(h.first - aggregate.end_time) < 0) {
+                    sum += h.second; min = std::min(min, h.second); max = std::max(max, h.second); ++count;
+                }
+            }
+            ASSERT_EQ(aggregate.count, count);
+            ASSERT_NEAR(aggregate.mean, sum / count, 1e-9);
+            ASSERT_DOUBLE_EQ(aggregate.min, min);
+            ASSERT_DOUBLE_EQ(aggregate.max, max);
+            ++emitted;
+        }
+        history.push_back(std::make_pair(time, value));
+    }
+    ASSERT_GT(emitted, 40);
+}
+
+// test that a single measurement after a gap closes all sliding windows that held measurements
+TEST(MeasurementAggregatorTest, SlidingGap) {
+    MeasurementAggregator aggregator(1000, 250);
+    std::vector<MeasurementAggregate> aggregates;
+    ASSERT_EQ(aggregator.add(1.0, 0, aggregates), 0);
+    ASSERT_EQ(aggregator.add(3.0, 100, aggregates), 0);
+    ASSERT_EQ(aggregator.add(5.0, 5000, aggregates), 4);
+    for (size_t i = 0; i < aggregates.size(); ++i) {
+        ASSERT_EQ(aggregates[i].end_time, 250 * (i + 1));
+        ASSERT_EQ(aggregates[i].count, 2);
+        ASSERT_DOUBLE_EQ(aggregates[i].mean, 2.0);
+    }
+    aggregates.clear();
+    ASSERT_EQ(aggregator.add(7.0, 5250, aggregates), 1);
+    ASSERT_EQ(aggregates[0].end_time, 5250);
+    ASSERT_EQ(aggregates[0].count, 1);
+    ASSERT_DOUBLE_EQ(aggregates[0].mean, 5.0);
+}
+
+// test that the sliding sum does not accumulate rounding errors of evicted measurements
+TEST(MeasurementAggregatorTest, SlidingRebase) {
+    MeasurementAggregator aggregator(1000, 100);
+    std::vector<MeasurementAggregate> aggregates;
+    for (uint32_t i = 0; i < 100000; ++i) {
+        aggregator.add((i & 1) != 0 ? 1e12 : 0.1, i * 50, aggregates);
+    }
+    aggregates.clear();
+    for (uint32_t i = 0; i < 30; ++i) {
+        aggregator.add(0.1, 5000000 + i * 50, aggregates);
+    }
+    ASSERT_DOUBLE_EQ(aggregates.back().mean, 0.1);
+}
+
+// test window boundaries across the 32-bit timer wrap around
+TEST(MeasurementAggregatorTest, WrapAround) {
+    MeasurementAggregator aggregator(1000, 500);
+    std::vector<MeasurementAggregate> aggregates;
+    const uint32_t start = 0xffffffff - 1200;
+    for (uint32_t t = 0; t <= 3000; t += 100) {
+        aggregator.add(1.0, start + t, aggregates);
+    }
+    ASSERT_EQ(aggregates.size(), 6);
+    for (size_t i = 0; i < aggregates.size(); ++i) {
+        ASSERT_EQ(aggregates[i].end_time - aggregates[i].start_time, 1000);
+        ASSERT_EQ(aggregates[i].count, i == 0 ? 5 : 10);
+        ASSERT_DOUBLE_EQ(aggregates[i].mean, 1.0);
+    }
+}
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include <MeasurementFrame.hpp>
+
+using namespace libspeedwire;
+
+// test adding and finding measurements
+TEST(MeasurementFrameTest, AddAndFind) {
+    MeasurementFrame frame;
+    ASSERT_TRUE(frame.isEmpty());
+    ASSERT_FALSE(frame.isFull());
+
+    frame.initialize(SpeedwireAddress(0x15D, 1234567890), 1000, MeasurementFrameType::OBIS);
+    ASSERT_EQ(frame.device.susyID, 0x15D);
+    ASSERT_EQ(frame.device.serialNumber, 1234567890);
+    ASSERT_EQ(frame.time, 1000);
+    ASSERT_EQ(frame.size, 0);
+
+    ASSERT_TRUE(frame.add(0x00010400, 123.0));
+    ASSERT_TRUE(frame.add(0x00020400, 456.0));
+    ASSERT_EQ(frame.size, 2);
+    ASSERT_EQ(frame.find(0x00010400), 0);
+    ASSERT_EQ(frame.find(0x00020400), 1);
+    ASSERT_EQ(frame.find(0x00030400), -1);
+    ASSERT_EQ(frame.values[frame.find(0x00020400)], 456.0);
+
+    frame.clear();
+    ASSERT_TRUE(frame.isEmpty());
+    ASSERT_EQ(frame.find(0x00010400), -1);
+}
+
+// test capacity limits
+TEST(MeasurementFrameTest, Capacity) {
+    MeasurementFrame frame;
+    for (size_t i = 0; i < MeasurementFrame::capacity; ++i) {
+        ASSERT_TRUE(frame.add((uint32_t)i, (double)i));
+    }
+    ASSERT_TRUE(frame.isFull());
+    ASSERT_FALSE(frame.add(0xffffffff, 0.0));
+    ASSERT_EQ(frame.size, MeasurementFrame::capacity);
+}
+
+// test serialization and deserialization
+TEST(MeasurementFrameTest, Serialize) {
+    MeasurementFrame frame;
+    frame.initialize(SpeedwireAddress(0x174, 3000123456), 0xfffffff0, MeasurementFrameType::SPEEDWIRE);
+    frame.add(0x00263f01, 1234.5);
+    frame.add(0x00464001, -0.25);
+    frame.add(0x00464101, 1e300);
+
+    std::vector<uint8_t> buffer(frame.getSerializedSize());
+    ASSERT_EQ(buffer.size(), MeasurementFrame::serialized_header_size + 3 * 12);
+    ASSERT_EQ(frame.serialize(buffer.data(), buffer.size() - 1), 0);
+    ASSERT_EQ(frame.serialize(buffer.data(), buffer.size()), buffer.size());
+
+    MeasurementFrame copy;
+    ASSERT_FALSE(copy.deserialize(buffer.data(), buffer.size() - 1));
+    ASSERT_TRUE(copy.deserialize(buffer.data(), buffer.size()));
+    ASSERT_TRUE(copy.device == frame.device);
+    ASSERT_EQ(copy.time, frame.time);
+    ASSERT_EQ(copy.type, frame.type);
+    ASSERT_EQ(copy.size, frame.size);
+    for (uint32_t i = 0; i < frame.size; ++i) {
+        ASSERT_EQ(copy.slots[i], frame.slots[i]);
+        ASSERT_EQ(copy.values[i], frame.values[i]);
+    }
+}
+
+// test that the truncated flag is reset for a new packet and survives serialization
+TEST(MeasurementFrameTest, Truncated) {
+    MeasurementFrame frame;
+    ASSERT_FALSE(frame.truncated);
+    frame.initialize(SpeedwireAddress(0x15D, 1234567890), 1000, MeasurementFrameType::OBIS);
+    frame.add(0x00010400, 123.0);
+    frame.truncated = true;
+
+    std::vector<uint8_t> buffer(frame.getSerializedSize());
+    ASSERT_EQ(frame.serialize(buffer.data(), buffer.size()), buffer.size());
+    MeasurementFrame copy;
+    ASSERT_TRUE(copy.deserialize(buffer.data(), buffer.size()));
+    ASSERT_TRUE(copy.truncated);
+
+    frame.clear();
+    ASSERT_FALSE(frame.truncated);
+    frame.truncated = true;
+    frame.initialize(SpeedwireAddress(0x15D, 1234567890), 2000, MeasurementFrameType::OBIS);
+    ASSERT_FALSE(frame.truncated);
+}
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include <Measurement.hpp>
+#include <MeasurementHistory.hpp>
+
+using namespace libspeedwire;
+
+// test rollup of 1 Hz inverter measurements into 1 minute and 15 minute buckets
+TEST(MeasurementHistoryTest, Rollup) {
+    MeasurementHistory history(MeasurementTimeBase::INVERTER_S);
+    history.addTier(900, 96);   // 15 minutes
+    history.addTier(60, 60);    // 1 minute
+    ASSERT_EQ(history.getNumberOfTiers(), 2);
+    ASSERT_EQ(history.getTier(0).duration, 60);
+    ASSERT_EQ(history.getTier(1).duration, 900);
+
+    MeasurementValues mv(10);
+    mv.setHistory(&history);
+    ASSERT_EQ(mv.getHistory(), &history);
+
+    const uint32_t start = 1800000000;  // a multiple of 900 seconds
+    for (uint32_t i = 0; i < 1800; ++i) {
+        mv.addMeasurement((double)(i % 60), start + i);
+    }
+    ASSERT_EQ(mv.getNumberOfElements(), 10);
+
+    // 29 completed minute buckets plus the open one
+    const MeasurementHistoryTier& minutes = history.getTier(0);
+    ASSERT_EQ(minutes.buckets.getNumberOfElements(), 29);
+    ASSERT_EQ(minutes.current.count, 60);
+    const MeasurementBucket& first = minutes.buckets.getOldestElement();
+    ASSERT_EQ(first.start_time, start);
+    ASSERT_EQ(first.last_time, start + 59);
+    ASSERT_EQ(first.count, 60);
+    ASSERT_EQ(first.min, 0.0);
+    ASSERT_EQ(first.max, 59.0);
+    ASSERT_EQ(first.last, 59.0);
+    ASSERT_DOUBLE_EQ(first.mean(), 29.5);
+
+    // 1 completed 15 minute bucket plus the open one
+    const MeasurementHistoryTier& quarters = history.getTier(1);
+    ASSERT_EQ(quarters.buckets.getNumberOfElements(), 1);
+    ASSERT_EQ(quarters.buckets[0].count, 900);
+    ASSERT_EQ(quarters.current.start_time, start + 900);
+
+    // queries select the coarsest suitable tier
+    std::vector<MeasurementBucket> result;
+    ASSERT_EQ(mv.query(start, start + 1799, 3600, result), 2);
+    ASSERT_EQ(result[0].start_time, start);
+    ASSERT_EQ(result[1].start_time, start + 900);
+    ASSERT_EQ(mv.query(start, start + 1799, 899, result), 30);
+    ASSERT_EQ(mv.query(start + 90, start + 150, 60, result), 2);     // partially overlapping buckets are included
+    ASSERT_EQ(result[0].start_time, start + 60);
+    ASSERT_EQ(result[1].start_time, start + 120);
+
+    // resolutions finer than the finest tier are served from the raw measurements
+    ASSERT_EQ(mv.query(start + 1795, start + 1797, 1, result), 3);
+    ASSERT_EQ(result[0].start_time, start + 1795);
+    ASSERT_EQ(result[0].count, 1);
+    ASSERT_EQ(result[2].last, (double)(1797 % 60));
+
+    history.clear();
+    ASSERT_EQ(history.query(start, start + 1799, 3600, result), 0);
+    ASSERT_EQ(history.getNumberOfTiers(), 2);
+}
+
+// test that bucket boundaries are aligned in unix epoch time across the 32-bit emeter timer wrap around
+TEST(MeasurementHistoryTest, WrapAround) {
+    MeasurementHistory history(MeasurementTimeBase::EMETER_MS);
+    history.addTier(1000, 100);
+    const uint64_t epoch = 0x18000000000ull - 5500;     // the emeter timer wraps after 5.5 seconds
+    for (uint64_t t = 0; t < 10000; t += 100) {
+        history.addMeasurement(1.0, SpeedwireTime::convertUnixEpochTimeToEmeterTimer(epoch + t), epoch + t);
+    }
+    const MeasurementHistoryTier& tier = history.getTier(0);
+    ASSERT_EQ(tier.buckets.getNumberOfElements(), 10);
+    ASSERT_EQ(tier.buckets[0].count, 9);
+    for (size_t i = 0; i < tier.buckets.getNumberOfElements(); ++i) {
+        const uint64_t start = SpeedwireTime::convertEmeterTimeToUnixEpochTime(tier.buckets[i].start_time, epoch);
+        ASSERT_EQ(start % 1000, 0);
+        ASSERT_EQ(start, (epoch / 1000 + i) * 1000);
+    }
+    ASSERT_EQ(tier.current.count, 1);
+}
+
+// test that queries fall back to a finer tier, if the coarse tier does not cover the requested time interval
+TEST(MeasurementHistoryTest, FallbackToFinerTier) {
+    MeasurementHistory history(MeasurementTimeBase::INVERTER_S);
+    history.addTier(60, 60);
+    history.addTier(900, 1);
+    const uint32_t start = 1800000000;
+    for (uint32_t i = 0; i < 2700; ++i) {
+        history.addMeasurement(1.0, start + i);
+    }
+    ASSERT_EQ(history.getTier(1).getOldestStartTime(), start + 900);
+
+    std::vector<MeasurementBucket> result;
+    ASSERT_EQ(history.query(start + 1000, start + 2699, 3600, result), 2);     // covered by the coarse tier
+    ASSERT_EQ(result[0].start_time, start + 900);
+    ASSERT_EQ(history.query(start + 100, start + 2699, 3600, result), 44);     // served by the minute tier
+    ASSERT_EQ(result[0].start_time, start + 60);
+}
+
+// test that measurements added through a Measurement reach the attached history exactly once
+TEST(MeasurementHistoryTest, MeasurementBackend) {
+    Measurement measurement(MeasurementType::InverterPower(), Wire::TOTAL);
+    measurement.measurementValues.setMaximumNumberOfElements(4);
+    MeasurementHistory history(MeasurementTimeBase::INVERTER_S);
+    history.addTier(60, 10);
+    measurement.measurementValues.setHistory(&history);
+    const uint32_t start = 1800000000;
+    for (uint32_t i = 0; i < 30; ++i) {
+        measurement.addMeasurement((uint32_t)(1000 + i), start + i);
+    }
+    ASSERT_EQ(history.getTier(0).current.count, 30);
+    ASSERT_DOUBLE_EQ(history.getTier(0).current.last, measurement.measurementValues.getNewestElement().value);
+}
@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+#include <MeasurementResampler.hpp>
+#include <SpeedwireTime.hpp>
+
+using namespace libspeedwire;
+
+// test alignment of an emeter series and an inverter series across a 32-bit emeter timer wrap around
+TEST(MeasurementResamplerTest, LinearAcrossWrapAround) {
+    // choose a current epoch time on a full second such that the emeter timer wrapped around about 10 seconds ago
+    const uint64_t now = (((uint64_t)0x1234 << 32) + 10000) / 1000 * 1000;
+    const uint64_t start = now - 60000;
+
+    // emeter: value equals elapsed milliseconds since start, one measurement per 1000 ms, shifted by 300 ms
+    MeasurementValues emeter(100);
+    for (uint64_t t = start + 300; t <= now; t += 1000) {
+        emeter.addMeasurement((double)(t - start), SpeedwireTime::convertUnixEpochTimeToEmeterTimer(t));
+    }
+    // inverter: value equals elapsed seconds since start, one measurement per 5 s
+    MeasurementValues inverter(100);
+    for (uint64_t t = start; t <= now; t += 5000) {
+        inverter.addMeasurement((double)(t - start) / 1000.0, SpeedwireTime::convertUnixEpochTimeToInverterTimer(t));
+    }
+
+    MeasurementResampler resampler;
+    ASSERT_EQ(resampler.addSeries(emeter, MeasurementTimeBase::EMETER_MS), 0);
+    ASSERT_EQ(resampler.addSeries(inverter, MeasurementTimeBase::INVERTER_S), 1);
+    ASSERT_EQ(resampler.getNumberOfSeries(), 2);
+
+    const size_t rows = resampler.resample(2000, now);
+    ASSERT_EQ(rows, resampler.getNumberOfTimes());
+    ASSERT_GT(rows, 25);
+    for (size_t i = 0; i < rows; ++i) {
+        const uint64_t time = resampler.getTimes()[i];
+        ASSERT_EQ(time % 2000, 0);
+        ASSERT_GE(time, start + 300);
+        ASSERT_LE(time, now);
+        ASSERT_NEAR(resampler.getValue(i, 0), (double)(time - start), 1e-6);
+        ASSERT_NEAR(resampler.getValue(i, 1), (double)(time - start) / 1000.0, 1e-6);
+    }
+
+    // buffers are reused and results are reproducible
+    const double* matrix = resampler.getMatrix().data();
+    ASSERT_EQ(resampler.resample(2000, now), rows);
+    ASSERT_EQ(resampler.getMatrix().data(), matrix);
+}
+
+// test zero-order-hold interpolation and non-overlapping series
+TEST(MeasurementResamplerTest, ZeroOrderHold) {
+    const uint64_t now = 1700000000000ull;
+    MeasurementValues a(10), b(10);
+    a.addMeasurement(1.0, SpeedwireTime::convertUnixEpochTimeToEmeterTimer(now - 4000));
+    a.addMeasurement(2.0, SpeedwireTime::convertUnixEpochTimeToEmeterTimer(now - 2500));
+    a.addMeasurement(3.0, SpeedwireTime::convertUnixEpochTimeToEmeterTimer(now));
+
+    MeasurementResampler resampler(ResamplingMode::ZERO_ORDER_HOLD);
+    resampler.addSeries(a, MeasurementTimeBase::EMETER_MS);
+    ASSERT_EQ(resampler.resample(1000, now), 5);
+    ASSERT_EQ(resampler.getValue(0, 0), 1.0);
+    ASSERT_EQ(resampler.getValue(1, 0), 1.0);
+    ASSERT_EQ(resampler.getValue(2, 0), 2.0);
+    ASSERT_EQ(resampler.getValue(3, 0), 2.0);
+    ASSERT_EQ(resampler.getValue(4, 0), 3.0);
+
+    // an empty series yields an empty grid
+    resampler.addSeries(b, MeasurementTimeBase::EMETER_MS);
+    ASSERT_EQ(resampler.resample(1000, now), 0);
+
+    // a series not overlapping with the first series yields an empty grid
+    b.addMeasurement(1.0, SpeedwireTime::convertUnixEpochTimeToEmeterTimer(now - 10000));
+    b.addMeasurement(1.0, SpeedwireTime::convertUnixEpochTimeToEmeterTimer(now - 9000));
+    ASSERT_EQ(resampler.resample(1000, now), 0);
+
+    resampler.clearSeries();
+    ASSERT_EQ(resampler.getNumberOfSeries(), 0);
+    ASSERT_EQ(resampler.resample(1000, now), 0);
+}
@@ -1,3 +1,5 @@
+#include <chrono>
+#include <cmath>
 #include <gtest/gtest.h>
 #include <MeasurementValues.hpp>
 #include <LineSegmentEstimator.hpp>
@@ -481,3 +483,227 @@ TEST(MeasurementValuesTest, Capacity3_estimateLinearRegressionDown) {
     ASSERT_EQ(variance, 1.0);
     EXPECT_DOUBLE_EQ(slope, -1.0);
 }
+
+// test statistics over subsets wrapping around the end of the ring buffer against straightforward reference calculations
+TEST(MeasurementValuesTest, StatisticsWrapped) {
+    const size_t capacity = 37;
+    MeasurementValues mv(capacity);
+    for (size_t i = 0; i < capacity + 23; ++i) {
+        mv.addMeasurement(100.0 + (double)((i * 7) % 13) - 0.25 * i, (uint32_t)(i * 1000));
+    }
+    for (size_t from = 0; from < capacity; ++from) {
+        for (size_t to = from; to < capacity; ++to) {
+            const size_t n = to - from + 1;
+            double y_sum = 0.0, y_sq_sum = 0.0, xy_sum = 0.0;
+            for (size_t i = from; i <= to; ++i) {
+                y_sum    += mv[i].value;
+                y_sq_sum += mv[i].value * mv[i].value;
+                xy_sum   += mv[i].value * (i - from);
+            }
+            const double ref_mean = y_sum / n;
+            const double ref_var  = (n <= 1 ? FLT_MAX : (y_sq_sum - ref_mean * y_sum) / (n - 1));
+
+            double mean, var, slope;
+            ASSERT_NEAR(mv.estimateMean(from, to), ref_mean, 1e-9);
+            mv.estimateMeanAndVariance(from, to, mean, var);
+            ASSERT_NEAR(mean, ref_mean, 1e-9);
+            ASSERT_NEAR(var, ref_var, 1e-6 * (1.0 + fabs(ref_var)));
+            mv.estimateLinearRegression(from, to, mean, var, slope);
+            ASSERT_NEAR(mean, ref_mean, 1e-9);
+            ASSERT_NEAR(var, ref_var, 1e-6 * (1.0 + fabs(ref_var)));
+            if (n > 1) {
+                const double x_mean = (n - 1) / 2.0;
+                double x_var = 0.0;
+                for (size_t i = 0; i < n; ++i) {
+                    x_var += (i - x_mean) * (i - x_mean);
+                }
+                const double ref_slope = (xy_sum - x_mean * y_sum) / x_var;
+                ASSERT_NEAR(slope, ref_slope, 1e-9);
+            }
+        }
+    }
+    ASSERT_NEAR(mv.estimateMean(), mv.estimateMean(0, capacity - 1), 1e-12);
+}
+
+// test running statistics against on-demand statistics while measurements are added and evicted
+TEST(MeasurementValuesTest, RunningStatistics) {
+    for (size_t capacity = 0; capacity < 12; ++capacity) {
+        MeasurementValues running(capacity);
+        MeasurementValues on_demand(capacity);
+        running.setRunningStatistics(true);
+        ASSERT_TRUE(running.hasRunningStatistics());
+        ASSERT_FALSE(on_demand.hasRunningStatistics());
+
+        uint32_t time = 0xffffff00;     // include a timer wrap around
+        for (size_t i = 0; i < 100; ++i) {
+            const double value = 1e6 + (double)((i * 11) % 7) * 0.1;
+            time += 10 + (uint32_t)(i % 3);
+            running.addMeasurement(value, time);
+            on_demand.addMeasurement(value, time);
+            ASSERT_NEAR(running.estimateMean(), on_demand.estimateMean(), 1e-6);
+            ASSERT_NEAR(running.estimateVariance(), on_demand.estimateVariance(), 1e-3);
+            ASSERT_NEAR(running.estimateTimeWeightedMean(), on_demand.estimateTimeWeightedMean(), 1e-6);
+        }
+        running.removeElements(0, 1);
+        on_demand.removeElements(0, 1);
+        if (on_demand.getNumberOfElements() > 0) {
+            ASSERT_NEAR(running.estimateMean(), on_demand.estimateMean(), 1e-6);
+        }
+        running.clear();
+        running.addMeasurement(5.0, 1000);
+        ASSERT_EQ(running.estimateMean(), 5.0);
+        ASSERT_EQ(running.estimateTimeWeightedMean(), 5.0);
+        ASSERT_EQ(running.estimateVariance(), FLT_MAX);
+    }
+
+    // time-weighted mean of a ramp from 0 to 10 followed by a constant 10 of the same duration
+    MeasurementValues mv(3);
+    mv.setRunningStatistics(true);
+    mv.addMeasurement(0.0, 1000);
+    mv.addMeasurement(10.0, 2000);
+    mv.addMeasurement(10.0, 3000);
+    ASSERT_DOUBLE_EQ(mv.estimateTimeWeightedMean(), 7.5);
+    ASSERT_DOUBLE_EQ(mv.estimateMean(), 20.0 / 3.0);
+}
+
+// test cursor based lookups and resampling against the binary search based lookups
+TEST(MeasurementValuesTest, Cursor) {
+    MeasurementValues mv(50);
+    MeasurementValuesCursor empty_cursor(mv);
+    ASSERT_EQ(empty_cursor.findClosestIndex(1000), (size_t)-1);
+    ASSERT_EQ(empty_cursor.interpolateClosestValues(1000), 0.0);
+
+    uint32_t time = 0xfffff000;     // include a timer wrap around
+    for (size_t i = 0; i < 80; ++i) {
+        time += 900 + (uint32_t)((i * 37) % 200);
+        mv.addMeasurement((double)((i * 13) % 29), time);
+    }
+    const uint32_t first = mv.getOldestElement().time - 5000;
+    const uint32_t last  = mv.getNewestElement().time + 5000;
+
+    // monotonic sweep
+    MeasurementValuesCursor cursor(mv);
+    std::vector<uint32_t> target_times;
+    for (uint32_t t = first; SpeedwireTime::calculateTimeDifference(t, last) <= 0; t += 97) {
+        ASSERT_EQ(cursor.findClosestIndex(t), mv.findClosestIndex(t));
+        ASSERT_EQ(cursor.interpolateClosestValues(t), mv.interpolateClosestValues(t));
+        target_times.push_back(t);
+    }
+
+    // random order queries
+    uint32_t state = 12345;
+    for (size_t i = 0; i < 1000; ++i) {
+        state = state * 1103515245u + 12345u;
+        const uint32_t t = first + (state >> 8) % (last - first);
+        ASSERT_EQ(cursor.findClosestIndex(t), mv.findClosestIndex(t));
+    }
+
+    // batch resampling
+    std::vector<double> resampled;
+    mv.resample(target_times, resampled);
+    ASSERT_EQ(resampled.size(), target_times.size());
+    for (size_t i = 0; i < target_times.size(); ++i) {
+        ASSERT_EQ(resampled[i], mv.interpolateClosestValues(target_times[i]));
+    }
+}
+
+// test that accessors return references into the ring buffer and report out of bounds conditions by the sentinel
+TEST(MeasurementValuesTest, RingBufferInterface) {
+    MeasurementValues mv(4);
+    ASSERT_TRUE(MeasurementValues::isIndexOutOfBoundsElement(mv.getNewestElement()));
+    ASSERT_TRUE(MeasurementValues::isIndexOutOfBoundsElement(mv.getOldestElement()));
+    ASSERT_TRUE(MeasurementValues::isIndexOutOfBoundsElement(mv[0]));
+
+    for (uint32_t i = 0; i < 6; ++i) {
+        mv.addMeasurement((double)i, i * 1000);
+    }
+    ASSERT_FALSE(MeasurementValues::isIndexOutOfBoundsElement(mv.getNewestElement()));
+    ASSERT_TRUE(MeasurementValues::isIndexOutOfBoundsElement(mv[4]));
+    ASSERT_EQ(&mv.getNewestElement(), &mv.at(3));
+    ASSERT_EQ(&mv.findClosestMeasurement(2900), &mv.at(1));
+    ASSERT_DOUBLE_EQ(mv.getOldestElement().value, 2.0);
+
+    // ring buffer and data vector indexes map onto each other
+    for (size_t i = 0; i < mv.getNumberOfElements(); ++i) {
+        const size_t index = mv.getDataVectorIndex(i);
+        ASSERT_EQ(mv.getRingBufferIndex(index), i);
+        ASSERT_EQ(&mv.getDataVector()[index], &mv.at(i));
+    }
+    ASSERT_EQ(mv.getFirstSpan().size + mv.getSecondSpan().size, 4);
+
+    // removals keep the running statistics consistent
+    mv.setRunningStatistics(true);
+    ASSERT_EQ(mv.removeOldestElements(1), 1);
+    ASSERT_EQ(mv.removeNewestElements(1), 1);
+    ASSERT_EQ(mv.getNumberOfElements(), 2);
+    ASSERT_DOUBLE_EQ(mv.at(0).value, 3.0);
+    ASSERT_DOUBLE_EQ(mv.estimateMean(), 3.5);
+}
+
+// benchmark statistics over 1024 sample windows; run with --gtest_also_run_disabled_tests
+TEST(MeasurementValuesTest, DISABLED_Benchmark) {
+    MeasurementValues mv(1024);
+    for (int i = 0; i < 1024 + 300; ++i) {
+        mv.addMeasurement(100.0 + (i % 17) * 0.5, i * 1000);
+    }
+    const int repetitions = 100000;
+    double result = 0.0, mean, var, slope;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repetitions; ++r) {
+        result += mv.estimateMean();
+    }
+    auto mean_end = std::chrono::steady_clock::now();
+    for (int r = 0; r < repetitions; ++r) {
+        mv.estimateMeanAndVariance(0, 1023, mean, var);
+        result += var;
+    }
+    auto var_end = std::chrono::steady_clock::now();
+    for (int r = 0; r < repetitions; ++r) {
+        mv.estimateLinearRegression(0, 1023, mean, var, slope);
+        result += slope;
+    }
+    auto regression_end = std::chrono::steady_clock::now();
+
+    // reference: the former scalar loops with a single accumulator, reading each measurement through at()
+    for (int r = 0; r < repetitions; ++r) {
+        double y_sum = 0.0;
+        for (size_t i = 0; i < 1024; ++i) {
+            y_sum += mv.at(i).value;
+        }
+        result += y_sum;
+    }
+    auto reference_mean_end = std::chrono::steady_clock::now();
+    for (int r = 0; r < repetitions; ++r) {
+        double y_sum = 0.0, y_sq_sum = 0.0;
+        for (size_t i = 0; i < 1024; ++i) {
+            const double value = mv.at(i).value;
+            y_sum += value;
+            y_sq_sum += value * value;
+        }
+        result += y_sq_sum - y_sum;
+    }
+    auto reference_var_end = std::chrono::steady_clock::now();
+    for (int r = 0; r < repetitions; ++r) {
+        double y_sum = 0.0, y_sq_sum = 0.0, xy_sum = 0.0;
+        for (size_t i = 0; i < 1024; ++i) {
+            const double value = mv.at(i).value;
+            y_sum += value;
+            y_sq_sum += value * value;
+            xy_sum += value * i;
+        }
+        result += xy_sum - y_sq_sum - y_sum;
+    }
+    auto reference_regression_end = std::chrono::steady_clock::now();
+
+    const double mean_ns = std::chrono::duration<double, std::nano>(mean_end - start).count() / repetitions;
+    const double var_ns = std::chrono::duration<double, std::nano>(var_end - mean_end).count() / repetitions;
+    const double regression_ns = std::chrono::duration<double, std::nano>(regression_end - var_end).count() / repetitions;
+    const double reference_mean_ns = std::chrono::duration<double, std::nano>(reference_mean_end - regression_end).count() / repetitions;
+    const double reference_var_ns = std::chrono::duration<double, std::nano>(reference_var_end - reference_mean_end).count() / repetitions;
+    const double reference_regression_ns = std::chrono::duration<double, std::nano>(reference_regression_end - reference_var_end).count() / repetitions;
+    printf("estimateMean:             %.0f ns  (scalar reference %.0f ns, %.1fx)\n", mean_ns, reference_mean_ns, reference_mean_ns / mean_ns);
+    printf("estimateMeanAndVariance:  %.0f ns  (scalar reference %.0f ns, %.1fx)\n", var_ns, reference_var_ns, reference_var_ns / var_ns);
+    printf("estimateLinearRegression: %.0f ns  (scalar reference %.0f ns, %.1fx)\n", regression_ns, reference_regression_ns, reference_regression_ns / regression_ns);
+    ASSERT_NE(result, 0.0);
+}
@@ -0,0 +1,205 @@
+#include <map>
+#include <vector>
+#include <gtest/gtest.h>
+#include <ObisFilter.hpp>
+#include <AveragingProcessor.hpp>
+#include <SpeedwireEmeterProtocol.hpp>
+
+using namespace libspeedwire;
+
+// obis consumer recording the newest value of each element and the number of endOfObisData() callbacks
+class ElementRecorder : public ObisConsumer {
+public:
+    std::vector<std::map<uint32_t, double> > packets;
+    size_t end_of_data;
+    ElementRecorder(void) : packets(1), end_of_data(0) {}
+    virtual void consume(const SpeedwireDevice& device, ObisData& element) {
+        packets.back()[element.toKey()] = (element.measurementValues.value_string.length() > 0 ? 0.0 : element.measurementValues.getNewestElement().value);
+    }
+    virtual void endOfObisData(const SpeedwireDevice& device, const uint32_t timestamp) {
+        packets.push_back(std::map<uint32_t, double>());
+        ++end_of_data;
+    }
+};
+
+// obis frame consumer recording the elements and the numeric measurements of each frame
+class FrameRecorder : public ObisFrameConsumer {
+public:
+    std::vector<std::map<uint32_t, double> > packets;
+    std::vector<std::map<uint32_t, double> > measurements;
+    std::vector<uint32_t> times;
+    virtual void consume(const SpeedwireDevice& device, const ObisDataFrame& frame) {
+        packets.push_back(std::map<uint32_t, double>());
+        for (const auto& entry : frame) {
+            packets.back()[entry.element->toKey()] = entry.value;
+        }
+        measurements.push_back(std::map<uint32_t, double>());
+        for (uint32_t i = 0; i < frame.measurements.size; ++i) {
+            measurements.back()[frame.measurements.slots[i]] = frame.measurements.values[i];
+        }
+        ASSERT_TRUE(frame.measurements.device == device.deviceAddress);
+        ASSERT_EQ(frame.measurements.time, frame.time);
+        times.push_back(frame.time);
+    }
+};
+
+// write a 4 byte obis element into the given buffer
+static void setObis4(uint8_t* const buffer, const ObisType& type, const uint32_t value) {
+    SpeedwireEmeterProtocol::setObisChannel(buffer, type.channel);
+    SpeedwireEmeterProtocol::setObisIndex(buffer, type.index);
+    SpeedwireEmeterProtocol::setObisType(buffer, type.type);
+    SpeedwireEmeterProtocol::setObisTariff(buffer, type.tariff);
+    SpeedwireEmeterProtocol::setObisValue4(buffer, value);
+}
+
+// write an 8 byte obis element into the given buffer
+static void setObis8(uint8_t* const buffer, const ObisType& type, const uint64_t value) {
+    setObis4(buffer, type, 0);
+    SpeedwireEmeterProtocol::setObisValue8(buffer, value);
+}
+
+// feed an emeter packet with power, energy and software version elements through the given filter
+static void feedPacket(ObisFilter& filter, const SpeedwireDevice& device, const uint32_t time, const uint32_t power) {
+    uint8_t obis[12] = { 0 };
+    setObis4(obis, ObisData::PositiveActivePowerTotal, power);
+    filter.consume(device, obis, time);
+    setObis4(obis, ObisData::NegativeActivePowerTotal, power / 2);
+    filter.consume(device, obis, time);
+    setObis4(obis, ObisData::PowerFactorTotal, 950);        // not filtered
+    filter.consume(device, obis, time);
+    setObis8(obis, ObisData::PositiveActiveEnergyTotal, 36000000ull * time);
+    filter.consume(device, obis, time);
+    setObis4(obis, ObisData::SoftwareVersion, 0x02020d52);
+    filter.consume(device, obis, time);
+    filter.endOfObisData(device, time);
+}
+
+// configure a filter with power, energy and software version elements
+static void addFilters(ObisFilter& filter) {
+    for (const ObisData* definition : { &ObisData::PositiveActivePowerTotal, &ObisData::NegativeActivePowerTotal, &ObisData::PositiveActiveEnergyTotal, &ObisData::SoftwareVersion }) {
+        ObisData entry(*definition);
+        entry.measurementValues.setMaximumNumberOfElements(8);
+        filter.addFilter(entry);
+    }
+}
+
+// test that frame consumers, adapted element consumers and element consumers see the same values once per packet
+TEST(ObisFilterTest, FrameEmission) {
+    ObisFilter filter;
+    addFilters(filter);
+    ElementRecorder elements, adapted;
+    FrameRecorder frames;
+    ObisFrameConsumerAdapter adapter(adapted);
+    filter.addConsumer(elements);
+    filter.addFrameConsumer(frames);
+    filter.addFrameConsumer(adapter);
+
+    SpeedwireDevice device;
+    device.deviceAddress = SpeedwireAddress(0x15d, 1234567890);
+    feedPacket(filter, device, 1000, 12345);
+    feedPacket(filter, device, 2000, 23456);
+
+    ASSERT_EQ(elements.end_of_data, 2);
+    ASSERT_EQ(adapted.end_of_data, 2);
+    ASSERT_EQ(frames.packets.size(), 2);
+    ASSERT_EQ(frames.times, std::vector<uint32_t>({ 1000, 2000 }));
+    for (size_t i = 0; i < 2; ++i) {
+        ASSERT_EQ(frames.packets[i].size(), 4);
+        ASSERT_EQ(frames.packets[i], elements.packets[i]);
+        ASSERT_EQ(frames.packets[i], adapted.packets[i]);
+
+        // the measurement frame holds the numeric values only
+        std::map<uint32_t, double> numeric(frames.packets[i]);
+        numeric.erase(ObisData::SoftwareVersion.toKey());
+        ASSERT_EQ(frames.measurements[i], numeric);
+    }
+    ASSERT_DOUBLE_EQ(frames.packets[1][ObisData::PositiveActivePowerTotal.toKey()], 2345.6);
+    ASSERT_DOUBLE_EQ(frames.packets[1][ObisData::NegativeActivePowerTotal.toKey()], 1172.8);
+}
+
+// test that a packet with more numeric values than the measurement frame capacity is flagged, while frame elements are complete
+TEST(ObisFilterTest, TruncatedFrame) {
+    const uint32_t n = (uint32_t)MeasurementFrame::capacity + 2;
+    ObisFilter filter;
+    for (uint32_t i = 0; i < n; ++i) {
+        ObisData entry(1 + i / 200, 1 + i % 200, 4, 0, MeasurementType::EmeterPositiveActivePower(), Wire::TOTAL);
+        entry.measurementValues.setMaximumNumberOfElements(2);
+        filter.addFilter(entry);
+    }
+    ElementRecorder elements;
+    FrameRecorder frames;
+    filter.addConsumer(elements);
+    filter.addFrameConsumer(frames);
+
+    class TruncationRecorder : public ObisFrameConsumer {
+    public:
+        std::vector<bool> truncated;
+        virtual void consume(const SpeedwireDevice& device, const ObisDataFrame& frame) { truncated.push_back(frame.measurements.truncated); }
+    } truncation;
+    filter.addFrameConsumer(truncation);
+
+    SpeedwireDevice device;
+    device.deviceAddress = SpeedwireAddress(0x15d, 1234567890);
+    for (uint32_t packet = 0; packet < 2; ++packet) {
+        const uint32_t size = (packet == 0 ? n : 3);
+        uint8_t obis[12] = { 0 };
+        for (uint32_t i = 0; i < size; ++i) {
+            setObis4(obis, ObisType(1 + i / 200, 1 + i % 200, 4, 0), i);
+            ASSERT_TRUE(filter.consume(device, obis, 1000 * (packet + 1)));
+        }
+        filter.endOfObisData(device, 1000 * (packet + 1));
+    }
+    ASSERT_EQ(truncation.truncated, std::vector<bool>({ true, false }));
+    ASSERT_EQ(frames.packets[0].size(), n);
+    ASSERT_EQ(frames.packets[0], elements.packets[0]);
+    ASSERT_EQ(frames.measurements[0].size(), MeasurementFrame::capacity);
+    ASSERT_EQ(frames.measurements[1].size(), 3);
+}
+
+// test that running statistics are taken over from each filter entry instead of being forced on
+TEST(ObisFilterTest, RunningStatisticsOptIn) {
+    ObisFilter filter;
+    ObisData plain(ObisData::PositiveActivePowerTotal);
+    plain.measurementValues.setMaximumNumberOfElements(4);
+    ObisData running(ObisData::NegativeActivePowerTotal);
+    running.measurementValues.setMaximumNumberOfElements(4);
+    running.measurementValues.setRunningStatistics(true);
+    filter.addFilter(plain);
+    filter.addFilter(running);
+
+    ASSERT_FALSE(filter.getFilter()[ObisData::PositiveActivePowerTotal.toKey()].measurementValues.hasRunningStatistics());
+    ASSERT_TRUE(filter.getFilter()[ObisData::NegativeActivePowerTotal.toKey()].measurementValues.hasRunningStatistics());
+
+    SpeedwireDevice device;
+    device.deviceAddress = SpeedwireAddress(0x15d, 1234567890);
+    for (uint32_t i = 1; i <= 6; ++i) {
+        feedPacket(filter, device, i * 1000, i * 1000);
+    }
+    // the newest four packets carry 300 .. 600 W positive and half of it as negative power
+    ASSERT_DOUBLE_EQ(filter.getFilter()[ObisData::NegativeActivePowerTotal.toKey()].measurementValues.estimateMean(), 225.0);
+    ASSERT_DOUBLE_EQ(filter.getFilter()[ObisData::PositiveActivePowerTotal.toKey()].measurementValues.estimateMean(), 450.0);
+}
+
+// test that the averaging processor passes frames on to frame consumers and element consumers alike
+TEST(ObisFilterTest, AveragingProcessorFanOut) {
+    ObisFilter filter;
+    addFilters(filter);
+    AveragingProcessor averaging(0, 0);
+    ElementRecorder elements;
+    FrameRecorder frames;
+    filter.addFrameConsumer(averaging);
+    averaging.addFrameConsumer(frames);
+    averaging.addConsumer(elements);
+
+    SpeedwireDevice device;
+    device.deviceAddress = SpeedwireAddress(0x15d, 1234567890);
+    for (uint32_t i = 1; i <= 3; ++i) {
+        feedPacket(filter, device, i * 1000, i * 1000);
+    }
+    ASSERT_EQ(frames.packets.size(), 3);
+    ASSERT_EQ(elements.end_of_data, 3);
+    for (size_t i = 0; i < 3; ++i) {
+        ASSERT_EQ(frames.packets[i].size(), 4);
+        ASSERT_EQ(frames.packets[i], elements.packets[i]);
+    }
+}
@@ -0,0 +1,129 @@
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <OrderedWorkerPool.hpp>
+
+using namespace libspeedwire;
+
+typedef OrderedWorkerPool<int, int> IntWorkerPool;
+
+// square the job value; odd values take longer to finish out of order
+static void square(const int& job, int& result, const size_t worker) {
+    if ((job & 1) != 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    result = job * job;
+}
+
+// test that results are delivered in submission order per key
+TEST(OrderedWorkerPoolTest, DeliveryOrder) {
+    IntWorkerPool pool(square, 4, 1000, OverflowPolicy::DROP_NEWEST);
+    ASSERT_EQ(pool.getNumberOfThreads(), 4);
+    for (int i = 0; i < 200; ++i) {
+        ASSERT_TRUE(pool.submit(i % 3, i));
+    }
+    std::vector<std::vector<int> > results(3);
+    size_t delivered = 0;
+    while (delivered < 200) {
+        pool.waitUntilIdle();
+        delivered += pool.deliver([&](const uint32_t key, int& result) { results[key].push_back(result); });
+    }
+    ASSERT_EQ(pool.getNumberOfDroppedJobs(), 0);
+    for (size_t key = 0; key < results.size(); ++key) {
+        int i = (int)key;
+        for (int result : results[key]) {
+            ASSERT_EQ(result, i * i);
+            i += 3;
+        }
+        ASSERT_EQ(i / 3, (200 - (int)key + 2) / 3);
+    }
+}
+
+// test overflow policies; without worker threads, jobs are processed by deliver()
+TEST(OrderedWorkerPoolTest, OverflowPolicies) {
+    std::vector<int> results;
+    auto collect = [&](const uint32_t key, int& result) { results.push_back(result); };
+
+    IntWorkerPool drop_newest(square, 0, 2, OverflowPolicy::DROP_NEWEST);
+    ASSERT_TRUE(drop_newest.submit(1, 1));
+    ASSERT_TRUE(drop_newest.submit(1, 2));
+    ASSERT_FALSE(drop_newest.submit(1, 3));
+    ASSERT_EQ(drop_newest.getNumberOfQueuedJobs(), 2);
+    ASSERT_EQ(drop_newest.deliver(collect), 2);
+    ASSERT_EQ(results, std::vector<int>({ 1, 4 }));
+    ASSERT_EQ(drop_newest.getNumberOfDroppedJobs(), 1);
+
+    results.clear();
+    IntWorkerPool drop_oldest(square, 0, 2, OverflowPolicy::DROP_OLDEST);
+    ASSERT_TRUE(drop_oldest.submit(1, 1));
+    ASSERT_TRUE(drop_oldest.submit(1, 2));
+    ASSERT_TRUE(drop_oldest.submit(1, 3));
+    ASSERT_EQ(drop_oldest.deliver(collect), 2);
+    ASSERT_EQ(results, std::vector<int>({ 4, 9 }));
+    ASSERT_EQ(drop_oldest.getNumberOfDroppedJobs(), 1);
+
+    // merging replaces the waiting job of the same key and keeps the delivery order of other keys; it applies to full queues only
+    results.clear();
+    IntWorkerPool merge(square, 0, 2, OverflowPolicy::MERGE);
+    ASSERT_TRUE(merge.submit(1, 1));
+    ASSERT_TRUE(merge.submit(1, 2));
+    ASSERT_EQ(merge.deliver(collect), 2);
+    ASSERT_EQ(results, std::vector<int>({ 1, 4 }));
+    ASSERT_EQ(merge.getNumberOfDroppedJobs(), 0);
+    results.clear();
+    ASSERT_TRUE(merge.submit(1, 1));
+    ASSERT_TRUE(merge.submit(2, 2));
+    ASSERT_TRUE(merge.submit(1, 3));
+    ASSERT_TRUE(merge.submit(2, 4));
+    ASSERT_EQ(merge.getNumberOfQueuedJobs(), 2);
+    ASSERT_EQ(merge.deliver(collect), 2);
+    ASSERT_EQ(results, std::vector<int>({ 9, 16 }));
+    ASSERT_EQ(merge.getNumberOfDroppedJobs(), 2);
+
+    // without a waiting job of the same key, the new job is queued in excess of the queue size instead of dropping another key
+    results.clear();
+    ASSERT_TRUE(merge.submit(1, 1));
+    ASSERT_TRUE(merge.submit(2, 2));
+    ASSERT_TRUE(merge.submit(3, 3));
+    ASSERT_TRUE(merge.submit(3, 4));
+    ASSERT_EQ(merge.getNumberOfQueuedJobs(), 3);
+    ASSERT_EQ(merge.deliver(collect), 3);
+    ASSERT_EQ(results, std::vector<int>({ 1, 4, 16 }));
+    ASSERT_EQ(merge.getNumberOfDroppedJobs(), 3);
+
+    // jobs submitted after stop() are dropped
+    merge.stop();
+    ASSERT_FALSE(merge.submit(1, 5));
+
+    // a merge function combines the jobs, e.g. incremental measurements
+    results.clear();
+    IntWorkerPool merge_sum(square, 0, 1, OverflowPolicy::MERGE, [](int& queued, const int& job) { queued += job; });
+    ASSERT_TRUE(merge_sum.submit(1, 1));
+    ASSERT_TRUE(merge_sum.submit(1, 2));
+    ASSERT_TRUE(merge_sum.submit(1, 3));
+    ASSERT_EQ(merge_sum.deliver(collect), 1);
+    ASSERT_EQ(results, std::vector<int>({ 36 }));
+}
+
+// test that jobs of the same key are never processed concurrently
+TEST(OrderedWorkerPoolTest, SerialPerKey) {
+    std::atomic<int> running[2] = { { 0 }, { 0 } };
+    std::atomic<int> overlaps(0);
+    OrderedWorkerPool<int, int> pool([&](const int& job, int& result, const size_t worker) {
+        if (running[job & 1]++ != 0) {
+            ++overlaps;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        result = job;
+        --running[job & 1];
+    }, 4, 1000, OverflowPolicy::DROP_NEWEST);
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_TRUE(pool.submit(i & 1, i));
+    }
+    std::vector<int> results;
+    while (results.size() < 100) {
+        pool.waitUntilIdle();
+        pool.deliver([&](const uint32_t key, int& result) { results.push_back(result); });
+    }
+    ASSERT_EQ(overlaps, 0);
+}
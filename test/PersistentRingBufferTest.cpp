@@ -0,0 +1,252 @@
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <PersistentRingBuffer.hpp>
+#include <MeasurementValues.hpp>
+
+using namespace libspeedwire;
+
+static const char* const test_file = "PersistentRingBufferTest.bin";
+
+// test that the ring buffer content survives closing and re-opening the file
+TEST(PersistentRingBufferTest, Restore) {
+    std::remove(test_file);
+    {
+        PersistentRingBuffer<uint32_t> rb;
+        ASSERT_FALSE(rb.isOpen());
+        ASSERT_EQ(rb.getNumberOfElements(), 0);
+        ASSERT_TRUE(rb.open(test_file, 5));
+        ASSERT_TRUE(rb.isOpen());
+        ASSERT_FALSE(rb.isRestored());
+        ASSERT_EQ(rb.getMaximumNumberOfElements(), 5);
+        for (uint32_t i = 0; i < 7; ++i) {
+            rb.addNewElement(i);
+        }
+        ASSERT_EQ(rb.getNumberOfElements(), 5);
+        ASSERT_EQ(rb.getOldestElement(), 2);
+        ASSERT_EQ(rb.getNewestElement(), 6);
+        ASSERT_TRUE(RingBuffer<uint32_t>::isIndexOutOfBoundsElement(rb[5]));
+        ASSERT_TRUE(rb.flush(false));
+    }
+    {
+        PersistentRingBuffer<uint32_t> rb;
+        ASSERT_TRUE(rb.open(test_file, 5));
+        ASSERT_TRUE(rb.isRestored());
+        ASSERT_EQ(rb.getNumberOfElements(), 5);
+        for (uint32_t i = 0; i < 5; ++i) {
+            ASSERT_EQ(rb[i], i + 2);
+        }
+        rb.addNewElement(7);
+        ASSERT_EQ(rb.getOldestElement(), 3);
+        ASSERT_EQ(rb.getNewestElement(), 7);
+    }
+    {
+        // a different capacity invalidates the content
+        PersistentRingBuffer<uint32_t> rb;
+        ASSERT_TRUE(rb.open(test_file, 8));
+        ASSERT_FALSE(rb.isRestored());
+        ASSERT_EQ(rb.getNumberOfElements(), 0);
+    }
+    std::remove(test_file);
+}
+
+// test that a corrupted state copy is detected and the other copy is used; if both are corrupted, the content is discarded
+TEST(PersistentRingBufferTest, CorruptedHeader) {
+    std::remove(test_file);
+    {
+        PersistentRingBuffer<double> rb;
+        ASSERT_TRUE(rb.open(test_file, 4));
+        rb.addNewElement(1.0);
+        rb.addNewElement(2.0);
+    }
+    {
+        MemoryMappedFile file;
+        ASSERT_TRUE(file.open(test_file, PersistentRingBufferHeader::data_offset));
+        PersistentRingBufferHeader* header = (PersistentRingBufferHeader*)file.getData();
+        const size_t newest = (header->states[1].generation > header->states[0].generation ? 1 : 0);
+        ASSERT_EQ(header->states[newest].number_of_elements, 2);
+        header->states[newest].number_of_elements = 3;
+    }
+    {
+        PersistentRingBuffer<double> rb;
+        ASSERT_TRUE(rb.open(test_file, 4));
+        ASSERT_TRUE(rb.isRestored());
+        ASSERT_EQ(rb.getNumberOfElements(), 1);
+        ASSERT_EQ(rb.getNewestElement(), 1.0);
+    }
+    {
+        MemoryMappedFile file;
+        ASSERT_TRUE(file.open(test_file, PersistentRingBufferHeader::data_offset));
+        PersistentRingBufferHeader* header = (PersistentRingBufferHeader*)file.getData();
+        header->states[0].write_pointer ^= 1;
+        header->states[1].write_pointer ^= 1;
+    }
+    {
+        PersistentRingBuffer<double> rb;
+        ASSERT_TRUE(rb.open(test_file, 4));
+        ASSERT_FALSE(rb.isRestored());
+        ASSERT_EQ(rb.getNumberOfElements(), 0);
+    }
+    std::remove(test_file);
+}
+
+// test that an addition interrupted by process termination leaves the previous content intact, even if the buffer is full
+TEST(PersistentRingBufferTest, InterruptedAddition) {
+    std::remove(test_file);
+    {
+        PersistentRingBuffer<uint32_t> rb;
+        ASSERT_TRUE(rb.open(test_file, 4));
+        for (uint32_t i = 1; i <= 5; ++i) {
+            rb.addNewElement(i);
+        }
+    }
+    {
+        // emulate termination after writing the element and part of the next state copy
+        MemoryMappedFile file;
+        ASSERT_TRUE(file.open(test_file, PersistentRingBufferHeader::data_offset + 5 * sizeof(uint32_t)));
+        PersistentRingBufferHeader* header = (PersistentRingBufferHeader*)file.getData();
+        const size_t newest = (header->states[1].generation > header->states[0].generation ? 1 : 0);
+        uint32_t* elements = (uint32_t*)(file.getData() + PersistentRingBufferHeader::data_offset);
+        elements[header->states[newest].write_pointer] = 99;
+        header->states[1 - newest].generation = header->states[newest].generation + 1;
+        header->states[1 - newest].write_pointer = (header->states[newest].write_pointer + 1) % 5;
+    }
+    {
+        PersistentRingBuffer<uint32_t> rb;
+        ASSERT_TRUE(rb.open(test_file, 4));
+        ASSERT_TRUE(rb.isRestored());
+        ASSERT_EQ(rb.getNumberOfElements(), 4);
+        for (uint32_t i = 0; i < 4; ++i) {
+            ASSERT_EQ(rb[i], i + 2);
+        }
+        rb.addNewElement(6);
+        ASSERT_EQ(rb.getOldestElement(), 3);
+        ASSERT_EQ(rb.getNewestElement(), 6);
+    }
+    std::remove(test_file);
+}
+
+// test removals of all ranges for all fill levels and rotations against RingBuffer, including a restart after each removal
+TEST(PersistentRingBufferTest, RemoveElements) {
+    const size_t capacity = 6;
+    for (size_t rotation = 0; rotation <= capacity; ++rotation) {
+        for (size_t num = 1; num <= capacity; ++num) {
+            for (size_t offs = 0; offs <= num; ++offs) {
+                for (size_t n = 0; n <= num - offs + 1; ++n) {
+                    std::remove(test_file);
+                    RingBuffer<uint32_t> expected(capacity);
+                    {
+                        PersistentRingBuffer<uint32_t> rb;
+                        ASSERT_TRUE(rb.open(test_file, capacity));
+                        for (uint32_t i = 0; i < rotation + num; ++i) {
+                            rb.addNewElement(i);
+                            expected.addNewElement(i);
+                        }
+                        expected.removeOldestElements(expected.getNumberOfElements() - num);
+                        rb.removeElements(0, rb.getNumberOfElements() - num);
+                        ASSERT_EQ(rb.getNumberOfElements(), num);
+                        ASSERT_EQ(rb.removeElements(offs, n), expected.removeElements(offs, n));
+                    }
+                    PersistentRingBuffer<uint32_t> rb;
+                    ASSERT_TRUE(rb.open(test_file, capacity));
+                    ASSERT_EQ(rb.getNumberOfElements(), expected.getNumberOfElements());
+                    for (size_t i = 0; i < expected.getNumberOfElements(); ++i) {
+                        ASSERT_EQ(rb[i], expected[i]) << "rotation " << rotation << " num " << num << " offs " << offs << " n " << n;
+                    }
+                    rb.addNewElement(100);
+                    ASSERT_EQ(rb.getNewestElement(), 100);
+                }
+            }
+        }
+    }
+    std::remove(test_file);
+}
+
+// history backend counting the added measurements
+class CountingHistory : public MeasurementHistoryBackend {
+public:
+    size_t count;
+    CountingHistory(void) : count(0) {}
+    virtual void addMeasurementValue(const double value, const uint32_t time) { ++count; }
+};
+
+// test that restored measurements are not added to the history a second time and that removals reach the persistent copy
+TEST(PersistentRingBufferTest, MeasurementValuesHistoryAndRemoval) {
+    std::remove(test_file);
+    CountingHistory history;
+    {
+        PersistentRingBuffer<TimestampDoublePair> rb;
+        ASSERT_TRUE(rb.open(test_file, 8));
+        MeasurementValues mv(4);
+        mv.setHistory(&history);
+        mv.setPersistentBuffer(&rb);
+        for (uint32_t i = 0; i < 8; ++i) {
+            mv.addMeasurement(i, i * 1000);
+        }
+        ASSERT_EQ(history.count, 8);
+
+        // the in-memory ring buffer holds 4..7, the persistent ring buffer 0..7
+        ASSERT_EQ(mv.removeElements(1, 2), 2);
+        ASSERT_EQ(rb.getNumberOfElements(), 6);
+        const double expected[] = { 0, 1, 2, 3, 4, 7 };
+        for (size_t i = 0; i < 6; ++i) {
+            ASSERT_EQ(rb[i].value, expected[i]);
+        }
+    }
+    {
+        PersistentRingBuffer<TimestampDoublePair> rb;
+        ASSERT_TRUE(rb.open(test_file, 8));
+        MeasurementValues mv(16);
+        mv.setHistory(&history);
+        mv.setPersistentBuffer(&rb);
+        ASSERT_EQ(history.count, 8);
+        ASSERT_EQ(mv.getNumberOfElements(), 6);
+
+        // the in-memory ring buffer holds more measurements than the persistent one after it overflows
+        for (uint32_t i = 8; i < 12; ++i) {
+            mv.addMeasurement(i, i * 1000);
+        }
+        ASSERT_EQ(history.count, 12);
+        ASSERT_EQ(mv.getNumberOfElements(), 10);
+        ASSERT_EQ(rb.getNumberOfElements(), 8);
+        ASSERT_EQ(mv.removeElements(0, 3), 3);
+        ASSERT_EQ(rb.getNumberOfElements(), 7);
+        ASSERT_EQ(rb.getOldestElement().value, 3.0);
+        ASSERT_EQ(mv.getOldestElement().value, 3.0);
+    }
+    std::remove(test_file);
+}
+
+// test that measurement values continue with the full window after a restart
+TEST(PersistentRingBufferTest, MeasurementValues) {
+    std::remove(test_file);
+    {
+        PersistentRingBuffer<TimestampDoublePair> rb;
+        ASSERT_TRUE(rb.open(test_file, 10));
+        MeasurementValues mv(10);
+        mv.setPersistentBuffer(&rb);
+        ASSERT_EQ(mv.getPersistentBuffer(), &rb);
+        for (uint32_t i = 0; i < 15; ++i) {
+            mv.addMeasurement(i * 2.0, i * 1000);
+        }
+        mv.removeElements(9, 1);
+        ASSERT_EQ(rb.getNumberOfElements(), 9);
+    }
+    {
+        PersistentRingBuffer<TimestampDoublePair> rb;
+        ASSERT_TRUE(rb.open(test_file, 10));
+        ASSERT_TRUE(rb.isRestored());
+        MeasurementValues mv(5);
+        mv.setRunningStatistics(true);
+        mv.setPersistentBuffer(&rb);
+        ASSERT_EQ(mv.getNumberOfElements(), 5);
+        ASSERT_EQ(mv.getOldestElement().time, 9000);
+        ASSERT_EQ(mv.getNewestElement().value, 26.0);
+        ASSERT_DOUBLE_EQ(mv.estimateMean(), (18.0 + 20.0 + 22.0 + 24.0 + 26.0) / 5.0);
+        mv.addMeasurement(100.0, 20000);
+        ASSERT_EQ(rb.getNumberOfElements(), 10);
+        ASSERT_EQ(rb.getNewestElement().value, 100.0);
+        mv.clear();
+        ASSERT_EQ(rb.getNumberOfElements(), 0);
+    }
+    std::remove(test_file);
+}
@@ -1,3 +1,5 @@
+#include <chrono>
+#include <vector>
 #include <gtest/gtest.h>
 #include <RingBuffer.hpp>
 
@@ -473,3 +475,115 @@ TEST(RingBufferTest, RemoveElements) {
     ASSERT_EQ(rb2.getNumberOfElements(), 1);
     ASSERT_EQ(rb3.getNumberOfElements(), 2);
 }
+
+// test removal of oldest, newest and middle elements in a wrapped around buffer against a reference vector
+TEST(RingBufferTest, RemoveElementsWrapped) {
+    const size_t capacity = 7;
+    for (size_t offs = 0; offs <= capacity; ++offs) {
+        for (size_t n = 0; n <= capacity; ++n) {
+            for (size_t fill = capacity; fill < 2 * capacity; ++fill) {
+                RingBuffer<int> rb(capacity);
+                std::vector<int> ref;
+                for (size_t i = 0; i < fill; ++i) {
+                    rb.addNewElement((int)i);
+                    ref.push_back((int)i);
+                }
+                ref.erase(ref.begin(), ref.end() - capacity);
+
+                const size_t expected = (offs < ref.size() ? std::min(n, ref.size() - offs) : 0);
+                ref.erase(ref.begin() + std::min(offs, ref.size()), ref.begin() + std::min(offs + n, ref.size()));
+                ASSERT_EQ(rb.removeElements(offs, n), expected);
+                ASSERT_EQ(rb.getNumberOfElements(), ref.size());
+                for (size_t i = 0; i < ref.size(); ++i) {
+                    ASSERT_EQ(rb[i], ref[i]);
+                }
+
+                // the buffer must continue to work as a ring buffer after removal
+                for (size_t i = 0; i < capacity; ++i) {
+                    rb.addNewElement(100 + (int)i);
+                }
+                for (size_t i = 0; i < capacity; ++i) {
+                    ASSERT_EQ(rb[i], 100 + (int)i);
+                }
+            }
+        }
+    }
+}
+
+// test removal of oldest and newest elements
+TEST(RingBufferTest, RemoveOldestNewestElements) {
+    RingBuffer<int> rb(4);
+    for (int i = 0; i < 6; ++i) {
+        rb.addNewElement(i);
+    }
+    ASSERT_EQ(rb.removeOldestElements(1), 1);
+    ASSERT_EQ(rb.getNumberOfElements(), 3);
+    ASSERT_EQ(rb.getOldestElement(), 3);
+    ASSERT_EQ(rb.removeNewestElements(1), 1);
+    ASSERT_EQ(rb.getNumberOfElements(), 2);
+    ASSERT_EQ(rb.getNewestElement(), 4);
+    ASSERT_EQ(rb.getWritePointer(), 1);
+    ASSERT_EQ(rb.removeNewestElements(5), 2);
+    ASSERT_EQ(rb.getNumberOfElements(), 0);
+    ASSERT_EQ(rb.removeOldestElements(1), 0);
+}
+
+// benchmark ring buffer fill-up and steady state insertion; run with --gtest_also_run_disabled_tests
+TEST(RingBufferTest, DISABLED_Benchmark) {
+    const size_t capacity = 1000;
+    double sum = 0.0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < 2000; ++r) {
+        RingBuffer<double> rb(capacity);
+        for (size_t i = 0; i < 3 * capacity; ++i) {
+            rb.addNewElement((double)i);
+        }
+        for (size_t i = 0; i < rb.getNumberOfElements(); ++i) {
+            sum += rb.at(i);
+        }
+    }
+    auto fill_end = std::chrono::steady_clock::now();
+
+    RingBuffer<double> rb(capacity);
+    for (int i = 0; i < 10000000; ++i) {
+        rb.addNewElement((double)i);
+    }
+    auto add_end = std::chrono::steady_clock::now();
+
+    printf("fill-up and scan: %.1f ms\n", std::chrono::duration<double, std::milli>(fill_end - start).count());
+    printf("steady state add: %.2f ns/element\n", std::chrono::duration<double, std::nano>(add_end - fill_end).count() / 1e7);
+    ASSERT_EQ(rb.getNumberOfElements(), capacity);
+    ASSERT_GT(sum, 0.0);
+}
+
+// test removal of elements in the middle of partially filled and wrapped ring buffers, for all head positions
+TEST(RingBufferTest, RemoveElementsPartiallyFilled) {
+    const size_t capacity = 9;
+    for (size_t head = 0; head < capacity; ++head) {
+        for (size_t size = 1; size <= capacity; ++size) {
+            for (size_t offs = 0; offs < size; ++offs) {
+                for (size_t n = 1; n <= size - offs; ++n) {
+                    RingBuffer<int> rb(capacity);
+                    for (size_t i = 0; i < head; ++i) {
+                        rb.addNewElement(-1);
+                    }
+                    rb.removeOldestElements(head);
+                    std::vector<int> ref;
+                    for (size_t i = 0; i < size; ++i) {
+                        rb.addNewElement((int)i);
+                        ref.push_back((int)i);
+                    }
+                    ref.erase(ref.begin() + offs, ref.begin() + offs + n);
+                    ASSERT_EQ(rb.removeElements(offs, n), n);
+                    ASSERT_EQ(rb.getNumberOfElements(), ref.size());
+                    for (size_t i = 0; i < ref.size(); ++i) {
+                        ASSERT_EQ(rb[i], ref[i]);
+                    }
+                    rb.addNewElement(100);
+                    ASSERT_EQ(rb.getNewestElement(), 100);
+                }
+            }
+        }
+    }
+}
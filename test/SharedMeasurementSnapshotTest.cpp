@@ -0,0 +1,82 @@
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <SharedMeasurementSnapshot.hpp>
+
+using namespace libspeedwire;
+
+static const char* const test_file = "SharedMeasurementSnapshotTest.bin";
+
+// test publishing and reading latest values and history rings
+TEST(SharedMeasurementSnapshotTest, PublishAndRead) {
+    std::remove(test_file);
+    SharedMeasurementReader reader;
+    ASSERT_FALSE(reader.open(test_file));
+
+    SharedMeasurementPublisher publisher;
+    ASSERT_TRUE(publisher.open(test_file, 4, 3));
+    ASSERT_TRUE(reader.open(test_file));
+    ASSERT_TRUE(reader.isOpen());
+
+    TimestampDoublePair result;
+    ASSERT_FALSE(reader.read(1234, 0x00010400, result));
+
+    for (uint32_t i = 0; i < 5; ++i) {
+        ASSERT_TRUE(publisher.publish(1234, 0x00010400, i * 10.0, 1000 * i));
+    }
+    ASSERT_TRUE(publisher.publish(5678, 0x00010400, -1.0, 42));
+    ASSERT_TRUE(reader.read(1234, 0x00010400, result));
+    ASSERT_EQ(result.value, 40.0);
+    ASSERT_EQ(result.time, 4000);
+    ASSERT_TRUE(reader.read(5678, 0x00010400, result));
+    ASSERT_EQ(result.value, -1.0);
+
+    std::vector<TimestampDoublePair> history;
+    ASSERT_EQ(reader.readHistory(1234, 0x00010400, history), 3);
+    ASSERT_EQ(history[0].value, 20.0);
+    ASSERT_EQ(history[2].value, 40.0);
+    ASSERT_EQ(history[2].time, 4000);
+    ASSERT_EQ(reader.readHistory(1234, 0x00020400, history), 0);
+
+    // the slot table is full after 4 series
+    ASSERT_TRUE(publisher.publish(1, 1, 1.0, 1));
+    ASSERT_TRUE(publisher.publish(2, 2, 2.0, 2));
+    ASSERT_FALSE(publisher.publish(3, 3, 3.0, 3));
+    ASSERT_TRUE(reader.read(2, 2, result));
+    ASSERT_EQ(result.value, 2.0);
+    ASSERT_FALSE(reader.read(3, 3, result));
+
+    reader.close();
+    publisher.close();
+    std::remove(test_file);
+}
+
+// test that an open reader detects a publisher restart with a larger slot table, and never reads beyond its mapping
+TEST(SharedMeasurementSnapshotTest, PublisherRestart) {
+    std::remove(test_file);
+    SharedMeasurementPublisher publisher;
+    ASSERT_TRUE(publisher.open(test_file, 2, 2));
+    ASSERT_TRUE(publisher.publish(1234, 0x00010400, 1.0, 1000));
+
+    SharedMeasurementReader reader;
+    ASSERT_TRUE(reader.open(test_file));
+    ASSERT_TRUE(reader.isCurrent());
+    TimestampDoublePair result;
+    ASSERT_TRUE(reader.read(1234, 0x00010400, result));
+
+    publisher.close();
+    ASSERT_TRUE(publisher.open(test_file, 1000, 16));
+    ASSERT_TRUE(publisher.publish(1234, 0x00010400, 2.0, 2000));
+    ASSERT_FALSE(reader.isCurrent());
+    ASSERT_FALSE(reader.read(1234, 0x00010400, result));
+    std::vector<TimestampDoublePair> history;
+    ASSERT_EQ(reader.readHistory(1234, 0x00010400, history), 0);
+    ASSERT_FALSE(reader.read(5678, 0x00010400, result));
+
+    ASSERT_TRUE(reader.open(test_file));
+    ASSERT_TRUE(reader.read(1234, 0x00010400, result));
+    ASSERT_EQ(result.value, 2.0);
+
+    reader.close();
+    publisher.close();
+    std::remove(test_file);
+}
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include <SpeedwireData.hpp>
+
+using namespace libspeedwire;
+
+// all predefined definitions must be found and must be identical to the definitions in the global map
+TEST(SpeedwireDataIndexTest, PredefinedDefinitions) {
+    const SpeedwireDataIndex& index = SpeedwireDataIndex::getPredefinedIndex();
+    const SpeedwireDataMap& map = SpeedwireDataMap::getGlobalMap();
+    ASSERT_GE(index.size(), map.size());
+
+    for (const auto& entry : map) {
+        const SpeedwireData* definition = index.find(entry.first);
+        ASSERT_NE(definition, (const SpeedwireData*)NULL);
+        ASSERT_EQ(definition->toKey(), entry.first);
+        ASSERT_EQ(definition->name, entry.second.name);
+    }
+}
+
+// pointers returned by the index must be stable
+TEST(SpeedwireDataIndexTest, StablePointers) {
+    const SpeedwireData* definition1 = SpeedwireDataIndex::getPredefinedIndex().find(SpeedwireData::InverterPowerL1.toKey());
+    const SpeedwireData* definition2 = SpeedwireDataIndex::getPredefinedIndex().find(SpeedwireData::InverterPowerL1);
+    ASSERT_NE(definition1, (const SpeedwireData*)NULL);
+    ASSERT_EQ(definition1, definition2);
+    ASSERT_EQ(definition1->name, SpeedwireData::InverterPowerL1.name);
+}
+
+// battery connector id 0x7 must resolve to connector id 0x1, unless there is an explicit definition
+TEST(SpeedwireDataIndexTest, BatteryConnectorAlias) {
+    const SpeedwireDataIndex& index = SpeedwireDataIndex::getPredefinedIndex();
+
+    const SpeedwireData* alias = index.find(SpeedwireData::InverterDeviceName.id | 0x7);
+    ASSERT_NE(alias, (const SpeedwireData*)NULL);
+    ASSERT_EQ(alias, index.find(SpeedwireData::InverterDeviceName.toKey()));
+
+    const SpeedwireData* battery = index.find(SpeedwireData::BatteryPowerL1.toKey());
+    ASSERT_NE(battery, (const SpeedwireData*)NULL);
+    ASSERT_EQ(battery->name, SpeedwireData::BatteryPowerL1.name);
+    ASSERT_NE(battery, index.find(SpeedwireData::InverterPowerL1.toKey()));
+
+    // aliases are only provided for connector id 0x7
+    ASSERT_EQ(index.find(SpeedwireData::InverterDeviceName.id | 0x3), (const SpeedwireData*)NULL);
+}
+
+// unknown keys must not be found
+TEST(SpeedwireDataIndexTest, UnknownKeys) {
+    std::vector<SpeedwireData> definitions;
+    definitions.push_back(SpeedwireData::InverterPowerL2);
+    definitions.push_back(SpeedwireData::InverterPowerL1);
+    SpeedwireDataIndex index(definitions);
+    ASSERT_EQ(index.size(), 4);
+    ASSERT_EQ(index.find(0x00000000), (const SpeedwireData*)NULL);
+    ASSERT_EQ(index.find(0xffffffff), (const SpeedwireData*)NULL);
+    ASSERT_EQ(index.find(SpeedwireData::InverterPowerL3.toKey()), (const SpeedwireData*)NULL);
+    ASSERT_EQ(index.find(SpeedwireData::InverterPowerL1.toKey())->name, SpeedwireData::InverterPowerL1.name);
+    ASSERT_EQ(index.find(SpeedwireData::InverterPowerL2.toKey())->name, SpeedwireData::InverterPowerL2.name);
+}
+
+// definitions added to the global map at runtime must be described by SpeedwireRawData::toString()
+TEST(SpeedwireDataIndexTest, RuntimeDefinitionDescription) {
+    SpeedwireData definition(SpeedwireData::InverterPowerL1);
+    definition.id = 0x00abcd00;
+    definition.name = "RuntimeDefinition";
+    ASSERT_EQ(SpeedwireDataIndex::getPredefinedIndex().find(definition.toKey()), (const SpeedwireData*)NULL);
+
+    SpeedwireDataMap& map = SpeedwireDataMap::getGlobalMap();
+    map.add(definition);
+    const std::string description = static_cast<const SpeedwireRawData&>(definition).toString();
+    map.erase(definition.toKey());
+    ASSERT_NE(description.find("RuntimeDefinition"), std::string::npos);
+}
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include <SpeedwireHeader.hpp>
+#include <SpeedwireData2Packet.hpp>
+#include <SpeedwireInverterProtocol.hpp>
+#include <SpeedwireIngestPlan.hpp>
+
+using namespace libspeedwire;
+
+// assemble an inverter reply packet with one register element of 28 bytes per given definition
+static SpeedwireInverterProtocol assembleReply(std::vector<uint8_t>& buffer, const std::vector<SpeedwireData>& definitions, const uint32_t time, const int32_t value) {
+    const uint32_t element_length = 28;
+    buffer.assign(1024, 0);
+    SpeedwireHeader header(buffer.data(), (unsigned long)buffer.size());
+    header.setDefaultHeader(1, (uint16_t)(38 + definitions.size() * element_length), SpeedwireData2Packet::sma_inverter_protocol_id);
+    SpeedwireData2Packet data2_packet(header);
+    SpeedwireInverterProtocol reply(data2_packet);
+    reply.setCommandID(definitions[0].command | Command::QUERY_RESPONSE);
+    reply.setFirstRegisterID(0);
+    reply.setLastRegisterID((uint32_t)definitions.size() - 1);
+    for (size_t i = 0; i < definitions.size(); ++i) {
+        const SpeedwireData& definition = definitions[i];
+        const unsigned long offset = (unsigned long)(i * element_length);
+        reply.setDataUint32(offset + 0, ((uint32_t)definition.type << 24) | definition.id | definition.conn);
+        reply.setDataUint32(offset + 4, time);
+        for (unsigned long j = 8; j < element_length; j += 4) {
+            reply.setDataUint32(offset + j, (uint32_t)(value + (int32_t)i));
+        }
+    }
+    return reply;
+}
+
+// replies must be ingested into the map and the plan must be reused
+TEST(SpeedwireIngestPlanTest, Ingest) {
+    std::vector<SpeedwireData> definitions;
+    definitions.push_back(SpeedwireData::InverterPowerL1);
+    definitions.push_back(SpeedwireData::InverterPowerL2);
+    definitions.push_back(SpeedwireData::InverterPowerL3);
+    SpeedwireDataMap map(definitions);
+    SpeedwireIngest ingest(map);
+
+    std::vector<uint8_t> buffer;
+    SpeedwireInverterProtocol reply1 = assembleReply(buffer, definitions, 1000, 100);
+    ASSERT_EQ(reply1.getRawDataLength(), 28);
+    ASSERT_EQ(ingest.ingest(reply1), 3);
+    ASSERT_EQ(ingest.getConsumedElements().size(), 3);
+    for (size_t i = 0; i < definitions.size(); ++i) {
+        const SpeedwireData& element = map[definitions[i].toKey()];
+        ASSERT_EQ(ingest.getConsumedElements()[i], &element);
+        ASSERT_EQ(element.measurementValues.getNewestElement().time, 1000);
+        ASSERT_EQ(element.measurementValues.getNewestElement().value, (double)(100 + i) / (double)element.measurementType.divisor);
+    }
+
+    SpeedwireInverterProtocol reply2 = assembleReply(buffer, definitions, 1001, 200);
+    ASSERT_EQ(ingest.ingest(reply2), 3);
+    ASSERT_EQ(map[definitions[2].toKey()].measurementValues.getNewestElement().time, 1001);
+    ASSERT_EQ(map[definitions[2].toKey()].measurementValues.getNewestElement().value, 202.0 / (double)definitions[2].measurementType.divisor);
+}
+
+// elements without destination are skipped and plans are rebuilt if the reply layout changes
+TEST(SpeedwireIngestPlanTest, Rebuild) {
+    std::vector<SpeedwireData> definitions;
+    definitions.push_back(SpeedwireData::InverterPowerL1);
+    definitions.push_back(SpeedwireData::InverterPowerL2);
+    SpeedwireDataMap map;
+    map.add(SpeedwireData::InverterPowerL2);
+    SpeedwireIngest ingest(map);
+
+    std::vector<uint8_t> buffer;
+    SpeedwireInverterProtocol reply1 = assembleReply(buffer, definitions, 1000, 100);
+    ASSERT_EQ(ingest.ingest(reply1), 1);
+    ASSERT_EQ(ingest.getConsumedElements()[0], &map[SpeedwireData::InverterPowerL2.toKey()]);
+
+    // same command and register range, but different registers
+    std::vector<SpeedwireData> swapped;
+    swapped.push_back(SpeedwireData::InverterPowerL2);
+    swapped.push_back(SpeedwireData::InverterPowerL1);
+    SpeedwireInverterProtocol reply2 = assembleReply(buffer, swapped, 1001, 300);
+    ASSERT_EQ(ingest.ingest(reply2), 1);
+    ASSERT_EQ(map[SpeedwireData::InverterPowerL2.toKey()].measurementValues.getNewestElement().value, 300.0 / (double)SpeedwireData::InverterPowerL2.measurementType.divisor);
+
+    // elements added to the map are only considered after invalidating the plans
+    map.add(SpeedwireData::InverterPowerL1);
+    ASSERT_EQ(ingest.ingest(reply2), 1);
+    ingest.invalidate();
+    ASSERT_EQ(ingest.ingest(reply2), 2);
+}
+
+// views of elements shorter than their header must have an empty payload
+TEST(SpeedwireIngestPlanTest, TruncatedElementView) {
+    std::vector<SpeedwireData> definitions;
+    definitions.push_back(SpeedwireData::InverterPowerL1);
+    std::vector<uint8_t> buffer;
+    SpeedwireInverterProtocol reply = assembleReply(buffer, definitions, 1000, 100);
+    const void* element = reply.getFirstRawDataElement();
+    for (uint32_t length = 0; length < 8; ++length) {
+        ASSERT_EQ(reply.getRawDataView(element, length).data_size, 0);
+    }
+    ASSERT_EQ(reply.getRawDataView(element, 28).data_size, 20);
+    ASSERT_EQ(reply.getRawDataView(NULL, 28).data_size, 0);
+}
+
+// SpeedwireData::consume() must accept reply views by the same rule as the ingest plan and limit the payload size
+TEST(SpeedwireIngestPlanTest, ConsumeView) {
+    std::vector<SpeedwireData> definitions;
+    definitions.push_back(SpeedwireData::InverterPowerL1);
+    std::vector<uint8_t> buffer;
+    SpeedwireInverterProtocol reply = assembleReply(buffer, definitions, 1000, 100);
+
+    SpeedwireData element(SpeedwireData::InverterPowerL1);
+    SpeedwireRawDataView view = *reply.getRawDataViews().begin();
+    ASSERT_NE(view.command, element.command);
+    ASSERT_TRUE(element.matches(view));
+    ASSERT_TRUE(element.consume(view));
+    ASSERT_EQ(element.measurementValues.getNewestElement().time, 1000);
+
+    view.data_size = 4096;
+    ASSERT_EQ(view.getPayloadSize(), sizeof(SpeedwireRawData::data));
+    view.type = SpeedwireDataType::Status32;
+    ASSERT_FALSE(element.matches(view));
+}
+
+// SpeedwireData::consume() must accept raw data copies by the same rule as reply views
+TEST(SpeedwireIngestPlanTest, ConsumeRawData) {
+    std::vector<SpeedwireData> definitions;
+    definitions.push_back(SpeedwireData::InverterPowerL1);
+    std::vector<uint8_t> buffer;
+    SpeedwireInverterProtocol reply = assembleReply(buffer, definitions, 1000, 100);
+
+    SpeedwireData element(SpeedwireData::InverterPowerL1);
+    SpeedwireRawData raw = (*reply.getRawDataViews().begin()).toRawData();
+    ASSERT_NE(raw.command, element.command);
+    ASSERT_TRUE(element.matches(raw));
+    ASSERT_TRUE(element.consume(raw));
+    ASSERT_EQ(element.measurementValues.getNewestElement().time, 1000);
+
+    raw.id = SpeedwireData::InverterPowerL2.id;
+    ASSERT_FALSE(element.matches(raw));
+    ASSERT_FALSE(element.consume(raw));
+}